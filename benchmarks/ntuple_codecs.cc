@@ -0,0 +1,188 @@
+////////////////////////////////////////////////////////////////////////
+// ntuple_codecs
+//
+// Compare the write and read throughput, and the compression ratio, of
+// the compression codecs available for Ntuple columns (see
+// hep_hpc/hdf5/Codec.hpp), with uncompressed storage as the baseline.
+//
+// Usage: ntuple_codecs [<rows> [<compression-threads>]]
+//
+// Each row consists of columns representative of HEP data: a noisy
+// digitized amplitude (float), a small hit count (unsigned short), a
+// monotonically increasing event number (unsigned long long) and a
+// word of status flags (unsigned char). Throughput is of uncompressed
+// bytes, including the final flush on writing; each column is read
+// back whole. Codecs not available in this build (and without an HDF5
+// filter plugin) are skipped.
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Codec.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/NtupleOptions.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/make_column.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+#include "hdf5.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace hep_hpc::hdf5;
+
+namespace {
+  char const * const filename = "ntuple_codecs.hdf5";
+
+  constexpr std::size_t rowBytes =
+    sizeof(float) + sizeof(unsigned short) + sizeof(unsigned long long) +
+    sizeof(unsigned char);
+
+  struct Columns {
+    std::vector<float> adc;
+    std::vector<unsigned short> nHits;
+    std::vector<unsigned long long> event;
+    std::vector<unsigned char> flags;
+  };
+
+  Columns
+  generate(std::size_t const nRows)
+  {
+    std::mt19937 gen(42);
+    std::normal_distribution<float> noise(1000.0f, 25.0f);
+    std::poisson_distribution<unsigned short> hits(4.0);
+    std::bernoulli_distribution rare(0.05);
+    Columns result;
+    result.adc.reserve(nRows);
+    result.nHits.reserve(nRows);
+    result.event.reserve(nRows);
+    result.flags.reserve(nRows);
+    unsigned long long event = 1000000ull;
+    for (std::size_t i = 0; i != nRows; ++i) {
+      result.adc.push_back(noise(gen));
+      result.nHits.push_back(hits(gen));
+      event += rare(gen) ? 2ull : 1ull; // Occasional gaps.
+      result.event.push_back(event);
+      result.flags.push_back(rare(gen) ? 0x3u : 0x1u);
+    }
+    return result;
+  }
+
+  double
+  seconds_since(std::chrono::steady_clock::time_point const start)
+  {
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  // Dataset creation properties for codec (none for the baseline).
+  PropertyList
+  properties(Codec const * const codec)
+  {
+    return (codec == nullptr) ?
+      PropertyList{H5P_DATASET_CREATE} :
+      codecProperties(*codec);
+  }
+
+  // Seconds, including the final flush.
+  double
+  write(Codec const * const codec,
+        Columns const & data,
+        unsigned int const compressionThreads)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    {
+      auto nt = make_ntuple({filename, "events",
+            NtupleOptions{}.
+            setOverwriteContents(NtupleOverwriteFlag::YES).
+            setCompressionThreads(compressionThreads)},
+        make_scalar_column<float>("adc", {properties(codec)}),
+        make_scalar_column<unsigned short>("nHits", {properties(codec)}),
+        make_scalar_column<unsigned long long>("event", {properties(codec)}),
+        make_scalar_column<unsigned char>("flags", {properties(codec)}));
+      for (std::size_t i = 0; i != data.adc.size(); ++i) {
+        nt.insert(data.adc[i], data.nHits[i], data.event[i], data.flags[i]);
+      }
+    }
+    return seconds_since(start);
+  }
+
+  template <typename T>
+  void
+  readColumn(File const & file, char const * const name,
+             hid_t const memType, std::vector<T> & buf)
+  {
+    Dataset dset(file, std::string("events/") + name);
+    dset.read(memType, buf.data());
+  }
+
+  // Seconds.
+  double
+  read(Columns & buf)
+  {
+    File const file(filename);
+    auto const start = std::chrono::steady_clock::now();
+    readColumn(file, "adc", H5T_NATIVE_FLOAT, buf.adc);
+    readColumn(file, "nHits", H5T_NATIVE_USHORT, buf.nHits);
+    readColumn(file, "event", H5T_NATIVE_ULLONG, buf.event);
+    readColumn(file, "flags", H5T_NATIVE_UCHAR, buf.flags);
+    return seconds_since(start);
+  }
+
+  std::size_t
+  storedBytes()
+  {
+    File const file(filename);
+    std::size_t result = 0ull;
+    for (auto const name : { "adc", "nHits", "event", "flags" }) {
+      result += H5Dget_storage_size(Dataset(file,
+                                            std::string("events/") + name));
+    }
+    return result;
+  }
+}
+
+int main(int argc, char * argv[])
+{
+  std::size_t const nRows = (argc > 1) ? std::atol(argv[1]) : 4000000ull;
+  unsigned int const compressionThreads =
+    (argc > 2) ? std::atoi(argv[2]) : 0u;
+  if (nRows == 0ull) {
+    std::cerr << "Usage: ntuple_codecs [<rows> [<compression-threads>]]\n";
+    return 1;
+  }
+  auto const data = generate(nRows);
+  auto buf = data;
+  double const mb = nRows * rowBytes / 1.0e6;
+  std::cout << "Throughput (MB/s uncompressed), " << nRows << " rows ("
+            << mb << " MB), compression threads " << compressionThreads
+            << "\n"
+            << std::setw(10) << "codec" << std::setw(12) << "write"
+            << std::setw(12) << "read" << std::setw(12) << "ratio" << "\n"
+            << std::fixed << std::setprecision(2);
+  auto const report = [&](char const * const name, Codec const * const codec)
+    {
+      double const w = write(codec, data, compressionThreads);
+      double const r = read(buf);
+      std::cout << std::setw(10) << name
+                << std::setw(12) << mb / w
+                << std::setw(12) << mb / r
+                << std::setw(12) << nRows * rowBytes / double(storedBytes())
+                << std::endl;
+    };
+  report("none", nullptr);
+  for (auto const codec : { Codec::DEFLATE, Codec::ZSTD, Codec::LZ4 }) {
+    if (codecAvailable(codec)) {
+      report(codecName(codec), &codec);
+    } else {
+      std::cout << std::setw(10) << codecName(codec)
+                << "  (not available)" << std::endl;
+    }
+  }
+}
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////
+// ntuple_flush_latency
+//
+// Compare the distribution of Ntuple::insert() latencies with
+// synchronous (default) and asynchronous (double-buffered) flushing.
+//
+// Usage: ntuple_flush_latency [<nrows> [<bufsize> [<waveform-length>]]]
+//
+// Each row consists of a few scalars and a waveform of 16-bit ADC
+// values, compressed with the default (deflate) settings. Latencies of
+// every insert() are recorded and their percentiles reported for each
+// mode.
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/NtupleOptions.hpp"
+#include "hep_hpc/hdf5/make_column.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace hep_hpc::hdf5;
+
+namespace {
+  using clock_type = std::chrono::steady_clock;
+
+  struct Result {
+    std::vector<double> latencies; // us.
+    double total; // s, including final flush.
+  };
+
+  Result
+  run(NtupleFlushMode const flushMode,
+      std::size_t const nrows,
+      std::size_t const bufsize,
+      std::size_t const wflen)
+  {
+    std::string const filename =
+      (flushMode == NtupleFlushMode::ASYNC) ?
+      "ntuple_flush_latency_async.hdf5" :
+      "ntuple_flush_latency_sync.hdf5";
+    Result result;
+    result.latencies.reserve(nrows);
+    std::mt19937 urng(123);
+    std::normal_distribution<float> noise(0.0f, 8.0f);
+    std::vector<unsigned short> waveform(wflen);
+    auto const start = clock_type::now();
+    {
+      auto nt = make_ntuple({filename, "events",
+            NtupleOptions{}.setBufsize(bufsize).setFlushMode(flushMode)},
+        make_scalar_column<unsigned int>("event"),
+        make_scalar_column<double>("energy"),
+        make_scalar_column<float>("time"),
+        make_column<unsigned short>("waveform", wflen));
+      for (std::size_t i = 0; i != nrows; ++i) {
+        for (std::size_t j = 0; j != wflen; ++j) {
+          waveform[j] = static_cast<unsigned short>(2048.0f + noise(urng));
+        }
+        auto const before = clock_type::now();
+        nt.insert(static_cast<unsigned int>(i),
+                  1.0 + i * 1.0e-3,
+                  noise(urng),
+                  waveform.data());
+        auto const after = clock_type::now();
+        result.latencies.push_back
+          (std::chrono::duration<double, std::micro>(after - before).count());
+      }
+    } // Final flush.
+    result.total =
+      std::chrono::duration<double>(clock_type::now() - start).count();
+    return result;
+  }
+
+  double
+  percentile(std::vector<double> const & sorted, double const p)
+  {
+    auto const index =
+      static_cast<std::size_t>(p / 100.0 * (sorted.size() - 1));
+    return sorted[index];
+  }
+
+  void
+  report(std::string const & label, Result result)
+  {
+    auto & lat = result.latencies;
+    std::sort(lat.begin(), lat.end());
+    std::cout << std::left << std::setw(8) << label << std::right
+              << std::fixed << std::setprecision(2);
+    for (double const p : { 50.0, 90.0, 99.0, 99.9 }) {
+      std::cout << std::setw(12) << percentile(lat, p);
+    }
+    std::cout << std::setw(12) << lat.back()
+              << std::setw(12) << std::setprecision(3) << result.total
+              << "\n";
+  }
+}
+
+int main(int argc, char * argv[])
+{
+  std::size_t const nrows = (argc > 1) ? std::atol(argv[1]) : 200000ull;
+  std::size_t const bufsize = (argc > 2) ? std::atol(argv[2]) : 1000ull;
+  std::size_t const wflen = (argc > 3) ? std::atol(argv[3]) : 256ull;
+  if (nrows == 0ull || bufsize == 0ull || wflen == 0ull) {
+    std::cerr << "Usage: ntuple_flush_latency [<nrows> [<bufsize> [<waveform-length>]]]\n";
+    return 1;
+  }
+  std::cout << "insert() latency (us) for " << nrows << " rows, bufsize "
+            << bufsize << ", waveform length " << wflen << "\n"
+            << std::left << std::setw(8) << "mode" << std::right;
+  for (auto const label : { "p50", "p90", "p99", "p99.9", "max", "total(s)" }) {
+    std::cout << std::setw(12) << label;
+  }
+  std::cout << "\n";
+  report("sync", run(NtupleFlushMode::SYNC, nrows, bufsize, wflen));
+  report("async", run(NtupleFlushMode::ASYNC, nrows, bufsize, wflen));
+}
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////
+// ntuple_layout
+//
+// Compare write throughput, and the throughput of reading back whole
+// rows, between the columnar (one dataset per column) and row-wise
+// compound-dataset layouts of an Ntuple (see NtupleLayout in
+// hep_hpc/hdf5/NtupleOptions.hpp).
+//
+// Usage: ntuple_layout [<rows> [<bufsize> [<read-batch>]]]
+//
+// Each row consists of a few scalars and a short fixed-length array,
+// compressed with the default (deflate) settings. Rows are read back in
+// batches of <read-batch> rows (default 10000): from every column
+// dataset in turn for the columnar layout, or as one compound selection
+// for the row-wise layout.
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/NtupleOptions.hpp"
+#include "hep_hpc/hdf5/make_column.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+#include "hdf5.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace hep_hpc::hdf5;
+
+namespace {
+  struct Row {
+    unsigned int event;
+    double energy;
+    float time;
+    float position[3];
+  };
+
+  char const * const filename = "ntuple_layout.hdf5";
+
+  double
+  seconds_since(std::chrono::steady_clock::time_point const start)
+  {
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  // Rows per second, including the final flush.
+  double
+  write(NtupleLayout const layout,
+        std::size_t const nRows,
+        std::size_t const bufsize)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    {
+      auto nt = make_ntuple({filename, "events",
+            NtupleOptions{}.
+            setOverwriteContents(NtupleOverwriteFlag::YES).
+            setBufsize(bufsize).
+            setLayout(layout)},
+        make_scalar_column<unsigned int>("event"),
+        make_scalar_column<double>("energy"),
+        make_scalar_column<float>("time"),
+        make_column<float>("position", 3));
+      float position[] = { 0.0f, 1.0f, 2.0f };
+      for (std::size_t i = 0; i != nRows; ++i) {
+        position[0] = static_cast<float>(i);
+        nt.insert(static_cast<unsigned int>(i),
+                  i * 1.0e-3,
+                  static_cast<float>(i % 100),
+                  position);
+      }
+    }
+    return nRows / seconds_since(start);
+  }
+
+  // Read nRows rows of dset in batches of the given size.
+  void
+  readBatches(Dataset const & dset,
+              hid_t const memType,
+              std::size_t const elementSize,
+              std::size_t const nRows,
+              std::size_t const batch,
+              void * const buf)
+  {
+    Dataspace fileSpace(H5Dget_space(dset));
+    for (hsize_t first = 0; first < nRows; first += batch) {
+      hsize_t const count = std::min<hsize_t>(batch, nRows - first);
+      hsize_t const offset[2] { first, 0ull };
+      hsize_t const counts[2] { count, elementSize };
+      H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, offset, nullptr,
+                          counts, nullptr);
+      Dataspace memSpace(H5Screate_simple(H5Sget_simple_extent_ndims(fileSpace),
+                                          counts, nullptr));
+      H5Dread(dset, memType, memSpace, fileSpace, H5P_DEFAULT, buf);
+    }
+  }
+
+  // Rows per second.
+  double
+  read(NtupleLayout const layout,
+       std::size_t const nRows,
+       std::size_t const batch)
+  {
+    File const file(filename);
+    auto const start = std::chrono::steady_clock::now();
+    if (layout == NtupleLayout::ROW_COMPOUND) {
+      hsize_t const dims[1] { 3 };
+      hid_t const ptype = H5Tarray_create2(H5T_NATIVE_FLOAT, 1, dims);
+      hid_t const rtype = H5Tcreate(H5T_COMPOUND, sizeof(Row));
+      H5Tinsert(rtype, "event", HOFFSET(Row, event), H5T_NATIVE_UINT);
+      H5Tinsert(rtype, "energy", HOFFSET(Row, energy), H5T_NATIVE_DOUBLE);
+      H5Tinsert(rtype, "time", HOFFSET(Row, time), H5T_NATIVE_FLOAT);
+      H5Tinsert(rtype, "position", HOFFSET(Row, position), ptype);
+      std::vector<Row> rows(batch);
+      readBatches(Dataset(file, "/events/rows"), rtype, 1ull,
+                  nRows, batch, rows.data());
+      H5Tclose(rtype);
+      H5Tclose(ptype);
+    } else {
+      std::vector<unsigned int> event(batch);
+      std::vector<double> energy(batch);
+      std::vector<float> time(batch), position(batch * 3);
+      readBatches(Dataset(file, "/events/event"), H5T_NATIVE_UINT, 1ull,
+                  nRows, batch, event.data());
+      readBatches(Dataset(file, "/events/energy"), H5T_NATIVE_DOUBLE, 1ull,
+                  nRows, batch, energy.data());
+      readBatches(Dataset(file, "/events/time"), H5T_NATIVE_FLOAT, 1ull,
+                  nRows, batch, time.data());
+      readBatches(Dataset(file, "/events/position"), H5T_NATIVE_FLOAT, 3ull,
+                  nRows, batch, position.data());
+    }
+    return nRows / seconds_since(start);
+  }
+}
+
+int main(int argc, char * argv[])
+{
+  std::size_t const nRows = (argc > 1) ? std::atol(argv[1]) : 1000000ull;
+  std::size_t const bufsize = (argc > 2) ? std::atol(argv[2]) : 1000ull;
+  std::size_t const batch = (argc > 3) ? std::atol(argv[3]) : 10000ull;
+  if (nRows == 0ull || bufsize == 0ull || batch == 0ull) {
+    std::cerr << "Usage: ntuple_layout [<rows> [<bufsize> [<read-batch>]]]\n";
+    return 1;
+  }
+  std::cout << "Throughput (Mrows/s), " << nRows << " rows, bufsize "
+            << bufsize << ", read batch " << batch << "\n"
+            << std::setw(10) << "layout" << std::setw(12) << "write"
+            << std::setw(12) << "read" << "\n"
+            << std::fixed << std::setprecision(3);
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    double const w = write(layout, nRows, bufsize);
+    double const r = read(layout, nRows, batch);
+    std::cout << std::setw(10)
+              << ((layout == NtupleLayout::COLUMNAR) ? "columnar" : "compound")
+              << std::setw(12) << w / 1.0e6
+              << std::setw(12) << r / 1.0e6 << std::endl;
+  }
+}
@@ -0,0 +1,191 @@
+////////////////////////////////////////////////////////////////////////
+// ntuple_shuffle
+//
+// Compare the write and read throughput, and the compression ratio, of
+// Ntuple columns of different types with no shuffle, byte shuffle and
+// bit shuffle ahead of the compression codec (see
+// hep_hpc/hdf5/Codec.hpp).
+//
+// Usage: ntuple_shuffle [<rows> [<codec> [<compression-threads>]]]
+//
+// Each column type is written as its own Ntuple with the default
+// dataset creation properties (deflate) and NtupleOptions::setShuffle(),
+// or with codecProperties() for another codec. The values are
+// representative of HEP data: a small hit count (unsigned short), an
+// ADC count (int), a monotonically increasing event number (unsigned
+// long long), a noisy amplitude (float), a slowly-drifting timestamp
+// (double) and a word of status flags (signed char). Throughput is of
+// uncompressed bytes, including the final flush on writing.
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Codec.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/NtupleOptions.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/make_column.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+#include "hdf5.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace hep_hpc::hdf5;
+
+namespace {
+  char const * const filename = "ntuple_shuffle.hdf5";
+
+  double
+  seconds_since(std::chrono::steady_clock::time_point const start)
+  {
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+
+  struct Config {
+    Codec codec;
+    Shuffle shuffle;
+    unsigned int compressionThreads;
+  };
+
+  // Seconds, including the final flush.
+  template <typename T>
+  double
+  write(std::vector<T> const & data, Config const & config)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    {
+      NtupleOptions options;
+      options.setOverwriteContents(NtupleOverwriteFlag::YES).
+        setCompressionThreads(config.compressionThreads).
+        setShuffle(config.shuffle);
+      auto nt = (config.codec == Codec::DEFLATE) ?
+        make_ntuple({filename, "values", options},
+                    make_scalar_column<T>("value")) :
+        make_ntuple({filename, "values", options},
+                    make_scalar_column<T>("value",
+                                          {codecProperties(config.codec,
+                                                           DEFAULT_CODEC_LEVEL,
+                                                           config.shuffle)}));
+      for (auto const & value : data) {
+        nt.insert(value);
+      }
+    }
+    return seconds_since(start);
+  }
+
+  // Seconds.
+  template <typename T>
+  double
+  read(std::vector<T> & buf, hid_t const memType)
+  {
+    File const file(filename);
+    auto const start = std::chrono::steady_clock::now();
+    Dataset dset(file, "values/value");
+    dset.read(memType, buf.data());
+    return seconds_since(start);
+  }
+
+  std::size_t
+  storedBytes()
+  {
+    File const file(filename);
+    return H5Dget_storage_size(Dataset(file, "values/value"));
+  }
+
+  template <typename T>
+  void
+  report(char const * const name,
+         std::vector<T> const & data,
+         hid_t const memType,
+         Codec const codec,
+         unsigned int const compressionThreads)
+  {
+    auto buf = data;
+    double const mb = data.size() * sizeof(T) / 1.0e6;
+    for (auto const shuffle : { Shuffle::NONE, Shuffle::BYTE, Shuffle::BIT }) {
+      double const w = write(data, {codec, shuffle, compressionThreads});
+      double const r = read(buf, memType);
+      std::cout << std::setw(20) << name
+                << std::setw(8) << ((shuffle == Shuffle::NONE) ? "none" :
+                                    (shuffle == Shuffle::BYTE) ? "byte" :
+                                    "bit")
+                << std::setw(12) << mb / w
+                << std::setw(12) << mb / r
+                << std::setw(12)
+                << data.size() * sizeof(T) / double(storedBytes())
+                << std::endl;
+    }
+  }
+}
+
+int main(int argc, char * argv[])
+{
+  std::size_t const nRows = (argc > 1) ? std::atol(argv[1]) : 4000000ull;
+  Codec codec = Codec::DEFLATE;
+  try {
+    if (argc > 2) {
+      codec = codecFromName(argv[2]);
+    }
+  }
+  catch (std::invalid_argument const & e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  unsigned int const compressionThreads =
+    (argc > 3) ? std::atoi(argv[3]) : 0u;
+  if (nRows == 0ull) {
+    std::cerr << "Usage: ntuple_shuffle "
+              << "[<rows> [<codec> [<compression-threads>]]]\n";
+    return 1;
+  }
+  if (!codecAvailable(codec)) {
+    std::cerr << "Codec " << codecName(codec) << " is not available.\n";
+    return 1;
+  }
+  std::mt19937 gen(42);
+  std::poisson_distribution<unsigned short> hits(4.0);
+  std::normal_distribution<float> noise(1000.0f, 25.0f);
+  std::uniform_int_distribution<int> adc(0, 4095);
+  std::bernoulli_distribution rare(0.05);
+  std::vector<unsigned short> nHits;
+  std::vector<int> adcs;
+  std::vector<unsigned long long> events;
+  std::vector<float> amplitudes;
+  std::vector<double> times;
+  std::vector<signed char> flags;
+  unsigned long long event = 1000000ull;
+  double time = 1.5e9;
+  for (std::size_t i = 0; i != nRows; ++i) {
+    nHits.push_back(hits(gen));
+    adcs.push_back(adc(gen));
+    event += rare(gen) ? 2ull : 1ull; // Occasional gaps.
+    events.push_back(event);
+    amplitudes.push_back(noise(gen));
+    time += 1.0e-3 * (1.0 + rare(gen));
+    times.push_back(time);
+    flags.push_back(rare(gen) ? 0x3 : 0x1);
+  }
+  std::cout << "Throughput (MB/s uncompressed), " << nRows << " rows, codec "
+            << codecName(codec) << ", compression threads "
+            << compressionThreads << "\n"
+            << std::setw(20) << "column" << std::setw(8) << "shuffle"
+            << std::setw(12) << "write" << std::setw(12) << "read"
+            << std::setw(12) << "ratio" << "\n"
+            << std::fixed << std::setprecision(2);
+  report("nHits (uint16)", nHits, H5T_NATIVE_USHORT, codec, compressionThreads);
+  report("adc (int32)", adcs, H5T_NATIVE_INT, codec, compressionThreads);
+  report("event (uint64)", events, H5T_NATIVE_ULLONG, codec, compressionThreads);
+  report("amplitude (float)", amplitudes, H5T_NATIVE_FLOAT, codec,
+         compressionThreads);
+  report("time (double)", times, H5T_NATIVE_DOUBLE, codec, compressionThreads);
+  report("flags (int8)", flags, H5T_NATIVE_SCHAR, codec, compressionThreads);
+}
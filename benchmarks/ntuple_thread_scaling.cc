@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////////////////
+// ntuple_thread_scaling
+//
+// Measure aggregate Ntuple::insert() throughput as a function of the
+// number of inserting threads sharing one Ntuple, with the default
+// (locked) insertion and with per-thread staging blocks.
+//
+// Usage: ntuple_thread_scaling [<rows-per-thread> [<bufsize> [<max-threads>]]]
+//
+// Thread counts are powers of two from 1 to <max-threads> (default
+// 64). Each row consists of a few scalars and a short fixed-length
+// array, compressed with the default (deflate) settings.
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/NtupleOptions.hpp"
+#include "hep_hpc/hdf5/make_column.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hep_hpc::hdf5;
+
+namespace {
+  // Rows per second, including the final flush.
+  double
+  run(NtupleInsertMode const insertMode,
+      std::size_t const nThreads,
+      std::size_t const rowsPerThread,
+      std::size_t const bufsize)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    {
+      auto nt = make_ntuple({"ntuple_thread_scaling.hdf5", "events",
+            NtupleOptions{}.setBufsize(bufsize).setInsertMode(insertMode)},
+        make_scalar_column<unsigned int>("event"),
+        make_scalar_column<double>("energy"),
+        make_scalar_column<float>("time"),
+        make_column<float>("position", 3));
+      std::vector<std::thread> threads;
+      for (std::size_t t = 0; t != nThreads; ++t) {
+        threads.emplace_back([&nt, t, rowsPerThread]() {
+            float position[] = { 0.0f, 1.0f, 2.0f };
+            for (std::size_t i = 0; i != rowsPerThread; ++i) {
+              position[0] = static_cast<float>(i);
+              nt.insert(static_cast<unsigned int>(t * rowsPerThread + i),
+                        i * 1.0e-3,
+                        static_cast<float>(t),
+                        position);
+            }
+          });
+      }
+      for (auto & thread : threads) {
+        thread.join();
+      }
+    }
+    std::chrono::duration<double> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    return nThreads * rowsPerThread / elapsed.count();
+  }
+}
+
+int main(int argc, char * argv[])
+{
+  std::size_t const rowsPerThread =
+    (argc > 1) ? std::atol(argv[1]) : 100000ull;
+  std::size_t const bufsize = (argc > 2) ? std::atol(argv[2]) : 1000ull;
+  std::size_t const maxThreads = (argc > 3) ? std::atol(argv[3]) : 64ull;
+  if (rowsPerThread == 0ull || bufsize == 0ull || maxThreads == 0ull) {
+    std::cerr << "Usage: ntuple_thread_scaling [<rows-per-thread> [<bufsize> [<max-threads>]]]\n";
+    return 1;
+  }
+  std::cout << "Aggregate insert() throughput (Mrows/s), " << rowsPerThread
+            << " rows per thread, bufsize " << bufsize << " ("
+            << std::thread::hardware_concurrency()
+            << " hardware threads)\n"
+            << std::setw(8) << "threads" << std::setw(12) << "locked"
+            << std::setw(12) << "per-thread" << "\n"
+            << std::fixed << std::setprecision(3);
+  for (std::size_t nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+    double const locked =
+      run(NtupleInsertMode::LOCKED, nThreads, rowsPerThread, bufsize);
+    double const perThread =
+      run(NtupleInsertMode::PER_THREAD, nThreads, rowsPerThread, bufsize);
+    std::cout << std::setw(8) << nThreads
+              << std::setw(12) << locked / 1.0e6
+              << std::setw(12) << perThread / 1.0e6 << std::endl;
+  }
+}
@@ -6,6 +6,7 @@
 #endif
 
 #include "hep_hpc/concat_hdf5/maybe_report_rank.hpp"
+#include "hep_hpc/hdf5/Codec.hpp"
 #include "hep_hpc/hdf5/Dataset.hpp"
 #include "hep_hpc/hdf5/Datatype.hpp"
 #include "hep_hpc/hdf5/Group.hpp"
@@ -361,6 +362,8 @@ namespace {
                                     File & h5out,
                                     bool const want_filters,
                                     bool const force_compression,
+                                    Codec const codec,
+                                    int const codec_level,
                                     std::size_t mem_max_bytes,
                                     long long const max_rows)
   {
@@ -428,26 +431,33 @@ namespace {
         // Deactivate filters in outgoing dataset.
         in_ds_create_plist(&H5Premove_filter, H5Z_FILTER_ALL);
       } else if (force_compression) {
-        // Add compression if it's not already there.
-        unsigned int flags;
-        size_t cd_nelmts { 0 };
-        size_t namelen { 0 };
-        unsigned int filter_config;
-        if (ErrorController::call(ErrorMode::NONE,
-                                  &H5Pget_filter_by_id2,
-                                  in_ds_create_plist,
-                                  H5Z_FILTER_DEFLATE,
-                                  &flags,
-                                  &cd_nelmts,
-                                  nullptr,
-                                  namelen,
-                                  nullptr,
-                                  &filter_config) < 0) {
-          // Set deflate filter.
+        // Add compression if it's not already there (with any codec).
+        auto const has_filter = [&in_ds_create_plist](H5Z_filter_t const filter)
+          {
+            unsigned int flags;
+            size_t cd_nelmts { 0 };
+            size_t namelen { 0 };
+            unsigned int filter_config;
+            return ErrorController::call(ErrorMode::NONE,
+                                         &H5Pget_filter_by_id2,
+                                         in_ds_create_plist,
+                                         filter,
+                                         &flags,
+                                         &cd_nelmts,
+                                         nullptr,
+                                         namelen,
+                                         nullptr,
+                                         &filter_config) >= 0;
+          };
+        if (!(has_filter(H5Z_FILTER_DEFLATE) ||
+              has_filter(H5Z_FILTER_SZIP) ||
+              has_filter(H5Z_FILTER_ZSTD) ||
+              has_filter(H5Z_FILTER_LZ4))) {
+          // Set compression filter.
           report(0,
-                 std::string("Forcing DEFLATE compression for dataset ") +
-                 ds_name + ".");
-          in_ds_create_plist(&H5Pset_deflate, 6);
+                 std::string("Forcing ") + codecName(codec) +
+                 " compression for dataset " + ds_name + ".");
+          setCodec(in_ds_create_plist, codec, codec_level);
         }
       }
 
@@ -568,6 +578,8 @@ HDF5FileConcatenator(std::string const & output,
                      std::vector<std::regex> const & only_groups,
                      bool const want_filters,
                      bool const force_compression,
+                     Codec const codec,
+                     int const codec_level,
                      bool const want_collective_writes,
                      bool const want_flush_per_dataset,
                      bool const want_mpi_io,
@@ -576,6 +588,8 @@ HDF5FileConcatenator(std::string const & output,
   , mem_max_bytes_(mem_max_bytes)
   , want_filters_(want_filters)
   , force_compression_(force_compression)
+  , codec_(codec)
+  , codec_level_(codec_level)
   , want_collective_writes_(want_collective_writes)
   , want_flush_per_dataset_(want_flush_per_dataset)
   , want_mpi_io_(want_mpi_io)
@@ -832,6 +846,8 @@ handle_dataset_(Dataset in_ds, std::string const ds_name)
                                     h5out_,
                                     want_filters_,
                                     force_compression_,
+                                    codec_,
+                                    codec_level_,
                                     mem_max_bytes_,
                                     max_rows_);
 
@@ -4,6 +4,7 @@
 #include "hep_hpc/Utilities/detail/compiler_macros.hpp"
 #include "hep_hpc/concat_hdf5/ConcatenatedDSInfo.hpp"
 #include "hep_hpc/concat_hdf5/FilenameColumnInfo.hpp"
+#include "hep_hpc/hdf5/Codec.hpp"
 #include "hep_hpc/hdf5/Dataset.hpp"
 #include "hep_hpc/hdf5/Dataspace.hpp"
 #include "hep_hpc/hdf5/File.hpp"
@@ -33,6 +34,8 @@ public:
                        std::vector<std::regex> const & only_groups,
                        bool want_filters,
                        bool force_compression,
+                       hdf5::Codec codec,
+                       int codec_level,
                        bool want_collective_writes,
                        bool want_flush_per_dataset,
                        bool want_mpi_io,
@@ -56,6 +59,8 @@ private:
   hsize_t mem_max_bytes_;
   bool want_filters_;
   bool force_compression_;
+  hdf5::Codec codec_;
+  int codec_level_;
   bool want_collective_writes_
 #ifndef HEP_HPC_USE_MPI
   // Satisfy picky compilers if we're not compiled with MPI.
@@ -24,6 +24,7 @@
 #include "hep_hpc/concat_hdf5/FilenameColumnInfo.hpp"
 #include "hep_hpc/concat_hdf5/HDF5FileConcatenator.hpp"
 #include "hep_hpc/concat_hdf5/maybe_report_rank.hpp"
+#include "hep_hpc/hdf5/Codec.hpp"
 #include "hep_hpc/hdf5/errorHandling.hpp"
 
 #ifdef HEP_HPC_USE_MPI
@@ -183,6 +184,8 @@ public:
     std::vector<std::regex> const & only_groups() const { return only_groups_; }
     bool want_filters() const { return want_filters_; }
     bool force_compression() const { return force_compression_; }
+    hdf5::Codec codec() const { return codec_; }
+    int codec_level() const { return codec_level_; }
     bool want_collective_writes() const { return want_collective_writes_;}
     bool want_flush_per_dataset() const { return want_flush_per_dataset_; }
     bool want_mpi_io() const { return want_mpi_io_; }
@@ -199,6 +202,7 @@ private:
     static std::size_t const DEFAULT_MEM_MAX;
     static bool const DEFAULT_WANT_FILTERS;
     static bool const DEFAULT_FORCE_COMPRESSION;
+    static hdf5::Codec const DEFAULT_CODEC;
     static bool const DEFAULT_WANT_COLLECTIVE_WRITES;
     static bool const DEFAULT_WANT_FLUSH_PER_DATASET;
     static bool const DEFAULT_WANT_MPI_IO;
@@ -213,6 +217,8 @@ private:
     std::vector<std::regex> only_groups_;
     bool want_filters_ { DEFAULT_WANT_FILTERS };
     bool force_compression_ { DEFAULT_FORCE_COMPRESSION };
+    hdf5::Codec codec_ { DEFAULT_CODEC };
+    int codec_level_ { hdf5::DEFAULT_CODEC_LEVEL };
     bool want_collective_writes_ { DEFAULT_WANT_COLLECTIVE_WRITES };
     bool want_flush_per_dataset_ { DEFAULT_WANT_FLUSH_PER_DATASET };
     bool want_mpi_io_ { DEFAULT_WANT_MPI_IO };
@@ -255,6 +261,30 @@ private:
       if (arg[1] == '-') { // Long options.
         if (arg == "--append") {
           arg = "-a"; // Short option alias.
+        } else if (arg == "--codec") {
+          coerce_n_sub_args(1);
+          auto const & spec = *++iarg;
+          auto const colon = spec.find(':');
+          try {
+            codec_ = hdf5::codecFromName(spec.substr(0, colon));
+            if (colon != std::string::npos) {
+              codec_level_ = std::stoi(spec.substr(colon + 1), &idx);
+              if (idx != spec.size() - colon - 1 || codec_level_ < 0) {
+                throw_bad_argument(arg, spec, 2);
+              }
+            }
+          }
+          catch (ProgramOptionsException const &) {
+            throw;
+          }
+          catch (std::exception const & e) {
+            throw_bad_argument(arg, spec, 2, e.what());
+          }
+          if (!hdf5::codecAvailable(codec_)) {
+            throw_bad_argument(arg, spec, 2, "codec not available");
+          }
+          force_compression_ = true;
+          continue;
         } else if (arg == "--collective-writes") {
           arg = "-C"; // Short option alias.
         } else if (arg == "--no-collective-writes") {
@@ -504,6 +534,17 @@ OPTIONS
               << std::boolalpha << DEFAULT_APPEND << R"END().
     Mutually exclusive with --overwrite.
 
+  --codec <codec>[:<level>]
+
+    Select the codec for --force-compression (which it implies): one
+    of deflate, zstd or lz4 (default )END"
+              << hdf5::codecName(DEFAULT_CODEC)
+              << R"END(), with an optional compression
+    level (deflate: 1-9, default 6; zstd: 1-22, default 3). zstd and lz4
+    require either support built into this program or the corresponding
+    HDF5 filter plugin (see HDF5_PLUGIN_PATH), and readers of the output
+    will need the same.
+
   --collective-writes
   -C
   --no-collective-writes
@@ -562,12 +603,12 @@ OPTIONS
 
   --force-compression
 
-    Force compression (deflate, level 6) on columns with none set
-    set (default )END"
+    Force compression (deflate, level 6, unless otherwise specified with
+    --codec) on columns with none set (default )END"
               << std::boolalpha << DEFAULT_FORCE_COMPRESSION
-              << R"END(). Requires filters (--with-filters) and
-    (if invoking multiple MPI proceses) collective writes
-    (--collective-writes) to be selected.
+              << R"END().
+    Requires filters (--with-filters) and (if invoking multiple MPI
+    proceses) collective writes (--collective-writes) to be selected.
 
   --help
   -h
@@ -674,6 +715,7 @@ NOTES
   std::size_t const ProgramOptions::DEFAULT_MEM_MAX = 100ull;
   bool const ProgramOptions::DEFAULT_WANT_FILTERS = true;
   bool const ProgramOptions::DEFAULT_FORCE_COMPRESSION = false;
+  hdf5::Codec const ProgramOptions::DEFAULT_CODEC = hdf5::Codec::DEFLATE;
   bool const ProgramOptions::DEFAULT_WANT_COLLECTIVE_WRITES = true;
   bool const ProgramOptions::DEFAULT_WANT_FLUSH_PER_DATASET = false;
   bool const ProgramOptions::DEFAULT_WANT_MPI_IO = false;
@@ -714,6 +756,8 @@ int main(int argc, char **argv)
                    program_options.only_groups(),
                    program_options.want_filters(),
                    program_options.force_compression(),
+                   program_options.codec(),
+                   program_options.codec_level(),
                    program_options.want_collective_writes(),
                    program_options.want_flush_per_dataset(),
                    program_options.want_mpi_io(),
@@ -0,0 +1,161 @@
+#include "hep_hpc/hdf5/ChunkCache.hpp"
+
+#include "hep_hpc/hdf5/Datatype.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+  std::atomic<std::size_t> budget {hep_hpc::hdf5::DEFAULT_CHUNK_CACHE_BUDGET};
+  std::atomic<std::size_t> reserved {0ull};
+
+  // Hash slots per chunk held (see H5Pset_chunk_cache()).
+  constexpr std::size_t SLOTS_PER_CHUNK = 100ull;
+
+  // Preemption policy: evict fully read or written chunks first
+  // (sequential access), or chunks regardless (random access).
+  constexpr double SEQUENTIAL_W0 = 1.0;
+  constexpr double RANDOM_W0 = 0.75;
+
+  std::size_t nextPrime(std::size_t n)
+  {
+    auto const isPrime = [](std::size_t const m)
+      {
+        for (std::size_t d = 2ull; d * d <= m; ++d) {
+          if (m % d == 0ull) {
+            return false;
+          }
+        }
+        return m > 1ull;
+      };
+    while (!isPrime(n)) {
+      ++n;
+    }
+    return n;
+  }
+
+  // Reserve up to nChunks chunks of chunkSize bytes from the budget,
+  // returning the number reserved.
+  std::size_t reserveChunks(std::size_t const nChunks,
+                            std::size_t const chunkSize)
+  {
+    std::size_t current = reserved.load();
+    std::size_t n;
+    do {
+      std::size_t const total = budget.load();
+      std::size_t const available = (current < total) ? total - current : 0ull;
+      n = std::min(nChunks, available / chunkSize);
+      if (n == 0ull) {
+        return 0ull;
+      }
+    } while (!reserved.compare_exchange_weak(current, current + n * chunkSize));
+    return n;
+  }
+}
+
+void
+hep_hpc::hdf5::ChunkCacheReservation::reset() noexcept
+{
+  if (bytes_ != 0ull) {
+    reserved -= bytes_;
+    bytes_ = 0ull;
+  }
+}
+
+std::size_t
+hep_hpc::hdf5::chunkCacheBudget()
+{
+  return budget.load();
+}
+
+void
+hep_hpc::hdf5::setChunkCacheBudget(std::size_t const bytes)
+{
+  budget = bytes;
+}
+
+std::size_t
+hep_hpc::hdf5::chunkCacheReserved()
+{
+  return reserved.load();
+}
+
+hep_hpc::hdf5::PropertyList
+hep_hpc::hdf5::chunkCacheProperties(std::size_t const chunkSize,
+                                    ChunkAccess const access,
+                                    ChunkCacheReservation & reservation)
+{
+  reservation.reset();
+  if (chunkSize == 0ull || budget.load() == 0ull) {
+    return {};
+  }
+  std::size_t const nChunks =
+    reserveChunks((access == ChunkAccess::RANDOM) ? RANDOM_ACCESS_CHUNKS : 1ull,
+                  chunkSize);
+  if (nChunks == 0ull) {
+    // N.B. the HDF5 default cache may still hold a small chunk, whereas
+    // a cache of 0 bytes would be disabled.
+    return {};
+  }
+  reservation.bytes_ = nChunks * chunkSize;
+  PropertyList result(H5P_DATASET_ACCESS);
+  (void) ErrorController::call(&H5Pset_chunk_cache,
+                               result,
+                               nextPrime(SLOTS_PER_CHUNK * nChunks),
+                               reservation.bytes_,
+                               (access == ChunkAccess::RANDOM) ?
+                               RANDOM_W0 : SEQUENTIAL_W0);
+  return result;
+}
+
+std::size_t
+hep_hpc::hdf5::chunkSizeBytes(hid_t const dcpl, hid_t const fileType)
+{
+  if (H5Pget_layout(dcpl) != H5D_CHUNKED) {
+    return 0ull;
+  }
+  hsize_t chunking[H5S_MAX_RANK];
+  int const rank = H5Pget_chunk(dcpl, H5S_MAX_RANK, chunking);
+  if (rank < 1) {
+    return 0ull;
+  }
+  std::size_t result = H5Tget_size(fileType);
+  for (int i = 0; i != rank; ++i) {
+    result *= chunking[i];
+  }
+  return result;
+}
+
+std::size_t
+hep_hpc::hdf5::datasetChunkSize(hid_t const dset)
+{
+  PropertyList const dcpl(ErrorController::call(&H5Dget_create_plist, dset),
+                          ResourceStrategy::handle_tag);
+  Datatype const dtype(ErrorController::call(&H5Dget_type, dset));
+  return chunkSizeBytes(dcpl, dtype);
+}
+
+hep_hpc::hdf5::Dataset
+hep_hpc::hdf5::openDatasetWithChunkCache(hid_t const fileOrGroup,
+                                         std::string const & fullPathName,
+                                         ChunkAccess const access,
+                                         ChunkCacheReservation & reservation)
+{
+  Dataset dset(fileOrGroup, fullPathName);
+  if (!dset || budget.load() == 0ull) {
+    return dset;
+  }
+  // The access properties must be provided on opening, once the chunk
+  // size is known.
+  std::size_t const chunkSize = datasetChunkSize(dset);
+  if (chunkSize == 0ull) {
+    return dset;
+  }
+  PropertyList aprops = chunkCacheProperties(chunkSize, access, reservation);
+  if (aprops.is_default()) {
+    return dset;
+  }
+  dset.reset();
+  return Dataset(fileOrGroup, fullPathName, std::move(aprops));
+}
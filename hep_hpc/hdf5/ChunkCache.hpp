@@ -0,0 +1,172 @@
+#ifndef hep_hpc_hdf5_ChunkCache_hpp
+#define hep_hpc_hdf5_ChunkCache_hpp
+////////////////////////////////////////////////////////////////////////
+// Raw data chunk caches sized per dataset.
+//
+// HDF5 gives each open chunked dataset a chunk cache of 1 MiB in 521
+// slots unless its dataset access properties specify otherwise. A
+// chunk larger than its dataset's cache is not cached at all, so that
+// each partial write (e.g. an append which does not complete a chunk)
+// or read of such a chunk reads and decompresses it again, and each
+// partial write also recompresses and rewrites it; conversely, a cache
+// larger than the chunks accessed together wastes memory, which adds
+// up over many datasets.
+//
+// The datasets of Ntuple columns (see hep_hpc/hdf5/Ntuple.hpp) without
+// dataset access properties of their own, and those read by NtupleTail
+// and NtupleIndex, are instead given caches sized for their chunks and
+// the way they are accessed, out of a budget shared by all of the
+// datasets of the process.
+//
+////////////////////////////////////
+// enum class hep_hpc::hdf5::ChunkAccess;
+//
+//   The access pattern of a dataset, determining the size of its cache:
+//
+//   * APPEND: rows written in order (an Ntuple column): one chunk, the
+//     one being filled.
+//
+//   * SEQUENTIAL: rows read in order, usually a few at a time (e.g.
+//     NtupleTail): one chunk, the one being read.
+//
+//   * RANDOM: rows read in any order (e.g. the binary searches of
+//     NtupleIndex): RANDOM_ACCESS_CHUNKS chunks.
+//
+//   Fully written or read chunks are evicted first for APPEND and
+//   SEQUENTIAL (H5Pset_chunk_cache() w0 = 1), and the cache has about
+//   100 hash slots per chunk held.
+//
+////////////////////////////////////
+// Functions
+//
+// std::size_t chunkCacheBudget();
+// void setChunkCacheBudget(std::size_t bytes);
+//
+//   The total size of the chunk caches of datasets of this process
+//   sized here (default DEFAULT_CHUNK_CACHE_BUDGET, 256 MiB). Once it
+//   is exhausted, a dataset's cache holds as many of the chunks it
+//   should as the remainder allows, or is left at the HDF5 default
+//   (1 MiB, outside the budget) if not even one chunk fits. 0 disables
+//   the sizing here altogether: datasets are opened with the HDF5
+//   defaults. Changes do not affect datasets already open.
+//
+// std::size_t chunkCacheReserved();
+//
+//   The part of the budget held by the caches of open datasets.
+//
+// PropertyList chunkCacheProperties(std::size_t chunkSize,
+//                                   ChunkAccess access,
+//                                   ChunkCacheReservation & reservation);
+//
+//   Dataset access properties for a dataset with chunks of chunkSize
+//   bytes (uncompressed) accessed as specified, with the cache reserved
+//   from the budget in reservation (replacing anything it held), which
+//   should be kept for as long as the dataset is open. Default access
+//   properties if chunkSize is 0 (not chunked), the budget is 0, or
+//   not even one chunk fits in what remains of it.
+//
+// std::size_t chunkSizeBytes(hid_t dcpl, hid_t fileType);
+// std::size_t datasetChunkSize(hid_t dset);
+//
+//   The uncompressed size in bytes of a chunk of a dataset with
+//   creation properties dcpl and elements of fileType (or of dset),
+//   or 0 if it is not chunked.
+//
+// Dataset openDatasetWithChunkCache(hid_t fileOrGroup,
+//                                   std::string const & fullPathName,
+//                                   ChunkAccess access,
+//                                   ChunkCacheReservation & reservation);
+//
+//   Open a dataset with a chunk cache sized as above.
+//
+////////////////////////////////////
+// class hep_hpc::hdf5::ChunkCacheReservation
+//
+//   A part of the budget, returned to it on destruction (or reset()).
+//   Movable but not copyable.
+//
+//   std::size_t bytes() const;
+//   void reset();
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+
+#include "hdf5.h"
+
+#include <cstddef>
+#include <string>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    enum class ChunkAccess {
+      APPEND,
+        SEQUENTIAL,
+        RANDOM
+        };
+
+    constexpr std::size_t DEFAULT_CHUNK_CACHE_BUDGET = 256ull << 20;
+    constexpr std::size_t RANDOM_ACCESS_CHUNKS = 16ull;
+
+    class ChunkCacheReservation;
+
+    std::size_t chunkCacheBudget();
+    void setChunkCacheBudget(std::size_t bytes);
+
+    std::size_t chunkCacheReserved();
+
+    PropertyList chunkCacheProperties(std::size_t chunkSize,
+                                      ChunkAccess access,
+                                      ChunkCacheReservation & reservation);
+
+    std::size_t chunkSizeBytes(hid_t dcpl, hid_t fileType);
+    std::size_t datasetChunkSize(hid_t dset);
+
+    Dataset openDatasetWithChunkCache(hid_t fileOrGroup,
+                                      std::string const & fullPathName,
+                                      ChunkAccess access,
+                                      ChunkCacheReservation & reservation);
+  }
+}
+
+class hep_hpc::hdf5::ChunkCacheReservation {
+public:
+  ChunkCacheReservation() = default;
+  ~ChunkCacheReservation() { reset(); }
+
+  ChunkCacheReservation(ChunkCacheReservation && other) noexcept
+    : bytes_(other.bytes_) { other.bytes_ = 0ull; }
+  ChunkCacheReservation & operator = (ChunkCacheReservation && other) noexcept;
+
+  ChunkCacheReservation(ChunkCacheReservation const &) = delete;
+  ChunkCacheReservation & operator = (ChunkCacheReservation const &) = delete;
+
+  std::size_t bytes() const { return bytes_; }
+
+  void reset() noexcept;
+
+private:
+  friend PropertyList
+  chunkCacheProperties(std::size_t, ChunkAccess, ChunkCacheReservation &);
+
+  std::size_t bytes_ {0ull};
+};
+
+inline
+hep_hpc::hdf5::ChunkCacheReservation &
+hep_hpc::hdf5::ChunkCacheReservation::
+operator = (ChunkCacheReservation && other) noexcept
+{
+  if (this != &other) {
+    reset();
+    bytes_ = other.bytes_;
+    other.bytes_ = 0ull;
+  }
+  return *this;
+}
+
+#endif /* hep_hpc_hdf5_ChunkCache_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
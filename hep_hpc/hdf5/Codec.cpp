@@ -0,0 +1,121 @@
+#include "hep_hpc/hdf5/Codec.hpp"
+
+#include "hep_hpc/hdf5/Exception.hpp"
+#include "hep_hpc/hdf5/detail/CodecFilters.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <stdexcept>
+
+namespace {
+  constexpr unsigned int DEFAULT_DEFLATE_LEVEL = 6u;
+  constexpr unsigned int DEFAULT_ZSTD_LEVEL = 3u;
+}
+
+void
+hep_hpc::hdf5::registerCodecs()
+{
+  detail::registerCodecFilters();
+}
+
+bool
+hep_hpc::hdf5::codecAvailable(Codec const codec)
+{
+  registerCodecs();
+  // Checks for (and loads) a plugin if not registered.
+  ScopedErrorHandler seh(ErrorMode::NONE);
+  return H5Zfilter_avail(codecFilter(codec)) > 0;
+}
+
+char const *
+hep_hpc::hdf5::codecName(Codec const codec)
+{
+  switch (codec) {
+  case Codec::DEFLATE:
+    return "deflate";
+  case Codec::ZSTD:
+    return "zstd";
+  case Codec::LZ4:
+    return "lz4";
+  }
+  throw std::invalid_argument("Unrecognized codec.");
+}
+
+hep_hpc::hdf5::Codec
+hep_hpc::hdf5::codecFromName(std::string const & name)
+{
+  for (auto const codec : { Codec::DEFLATE, Codec::ZSTD, Codec::LZ4 }) {
+    if (name == codecName(codec)) {
+      return codec;
+    }
+  }
+  throw std::invalid_argument("Unrecognized codec name: " + name);
+}
+
+H5Z_filter_t
+hep_hpc::hdf5::codecFilter(Codec const codec)
+{
+  switch (codec) {
+  case Codec::DEFLATE:
+    return H5Z_FILTER_DEFLATE;
+  case Codec::ZSTD:
+    return H5Z_FILTER_ZSTD;
+  case Codec::LZ4:
+    return H5Z_FILTER_LZ4;
+  }
+  throw std::invalid_argument("Unrecognized codec.");
+}
+
+herr_t
+hep_hpc::hdf5::setCodec(PropertyList & dcpl, Codec const codec,
+                        int const level)
+{
+  if (!codecAvailable(codec)) {
+    throw Exception(std::string("Compression codec ") + codecName(codec) +
+                    " is not available.");
+  }
+  switch (codec) {
+  case Codec::DEFLATE:
+    return ErrorController::call(&H5Pset_deflate, dcpl,
+                                 (level < 0) ? DEFAULT_DEFLATE_LEVEL :
+                                 static_cast<unsigned int>(level));
+  case Codec::ZSTD:
+  {
+    unsigned int const values[] {(level < 0) ? DEFAULT_ZSTD_LEVEL :
+        static_cast<unsigned int>(level)};
+    return ErrorController::call(&H5Pset_filter, dcpl, H5Z_FILTER_ZSTD,
+                                 H5Z_FLAG_MANDATORY, 1ul, values);
+  }
+  case Codec::LZ4:
+    // Default (whole-chunk) block size.
+    return ErrorController::call(&H5Pset_filter, dcpl, H5Z_FILTER_LZ4,
+                                 H5Z_FLAG_MANDATORY, 0ul, nullptr);
+  }
+  throw std::invalid_argument("Unrecognized codec.");
+}
+
+herr_t
+hep_hpc::hdf5::setShuffle(PropertyList & dcpl, Shuffle const shuffle)
+{
+  switch (shuffle) {
+  case Shuffle::NONE:
+    return 0;
+  case Shuffle::BYTE:
+    return ErrorController::call(&H5Pset_shuffle, dcpl);
+  case Shuffle::BIT:
+    registerCodecs();
+    // Default block size, no compression within the filter.
+    return ErrorController::call(&H5Pset_filter, dcpl, H5Z_FILTER_BITSHUFFLE,
+                                 H5Z_FLAG_MANDATORY, 0ul, nullptr);
+  }
+  throw std::invalid_argument("Unrecognized shuffle.");
+}
+
+hep_hpc::hdf5::PropertyList
+hep_hpc::hdf5::codecProperties(Codec const codec, int const level,
+                               Shuffle const shuffle)
+{
+  PropertyList result(H5P_DATASET_CREATE);
+  (void) setShuffle(result, shuffle);
+  (void) setCodec(result, codec, level);
+  return result;
+}
@@ -0,0 +1,153 @@
+#ifndef hep_hpc_hdf5_Codec_hpp
+#define hep_hpc_hdf5_Codec_hpp
+////////////////////////////////////////////////////////////////////////
+// enum class hep_hpc::hdf5::Codec;
+//
+//   Compression codecs for the datasets of Ntuple columns (see
+//   hep_hpc/hdf5/make_column.hpp) and the concatenator:
+//
+//   * DEFLATE: zlib (H5Z_FILTER_DEFLATE, built into HDF5).
+//
+//   * ZSTD: Zstandard (HDF5 registered filter 32015), much faster than
+//     deflate at a similar compression ratio.
+//
+//   * LZ4: LZ4 (HDF5 registered filter 32004), faster still, at a
+//     lower ratio.
+//
+//   The ZSTD and LZ4 filters are built into this library if the zstd
+//   and lz4 libraries are found at configure time, and are registered
+//   with HDF5 on first use of any of the functions below; otherwise an
+//   HDF5 filter plugin with the same ID is used if one is found (see
+//   HDF5_PLUGIN_PATH). The data written are compatible with the
+//   standard plugins, so that any HDF5 reader with those plugins can
+//   read them.
+//
+//   e.g.:
+//
+//     make_scalar_column<float>("adc", {codecProperties(Codec::ZSTD)})
+//
+////////////////////////////////////
+// enum class hep_hpc::hdf5::Shuffle;
+//
+//   Pre-filters rearranging the bytes of a chunk so that it compresses
+//   better:
+//
+//   * NONE.
+//
+//   * BYTE: byte shuffle (H5Z_FILTER_SHUFFLE, built into HDF5), storing
+//     the first bytes of all elements, then the second bytes, etc. Of
+//     use only for multi-byte types.
+//
+//   * BIT: bit shuffle (HDF5 registered filter 32008, built into this
+//     library), storing the corresponding bits of all elements together
+//     (see hep_hpc/hdf5/detail/Bitshuffle.hpp). Usually better than
+//     BYTE for integers with a small range and for quantized or
+//     reduced-precision floating point (see make_column.hpp), and of
+//     use also for single-byte types. Written in the format of the
+//     standard bitshuffle plugin (without its own compression), so that
+//     any HDF5 reader with that plugin can read it.
+//
+//   The default dataset creation properties of Ntuple columns apply
+//   BYTE to the datasets of multi-byte arithmetic types (see
+//   NtupleOptions::shuffle() in hep_hpc/hdf5/NtupleOptions.hpp).
+//
+////////////////////////////////////
+// Functions
+//
+// void registerCodecs();
+//
+//   Register the built-in bitshuffle, ZSTD and LZ4 filters with HDF5
+//   (once): needed only by a process reading such data before otherwise
+//   using this interface.
+//
+// bool codecAvailable(Codec codec);
+//
+//   Whether data may be written (and read) with codec.
+//
+// char const * codecName(Codec codec);
+// Codec codecFromName(std::string const & name);
+//
+//   Conversion to and from the lower-case names "deflate", "zstd" and
+//   "lz4". codecFromName() throws std::invalid_argument for any other.
+//
+// H5Z_filter_t codecFilter(Codec codec);
+//
+//   The ID of codec's HDF5 filter.
+//
+// herr_t setCodec(PropertyList & dcpl, Codec codec,
+//                 int level = DEFAULT_CODEC_LEVEL);
+//
+//   Append codec to the filter pipeline of the dataset creation
+//   property list dcpl (the dataset of an Ntuple column so created is
+//   given default chunking if dcpl specifies none). level is the
+//   compression level for DEFLATE (1-9, default 6) and ZSTD (1-22,
+//   default 3), and is ignored for LZ4. Throws Exception if codec is
+//   not available.
+//
+// herr_t setShuffle(PropertyList & dcpl, Shuffle shuffle);
+//
+//   Append shuffle (if not NONE) to the filter pipeline of dcpl: to
+//   take effect, before any codec.
+//
+// PropertyList codecProperties(Codec codec,
+//                              int level = DEFAULT_CODEC_LEVEL,
+//                              Shuffle shuffle = Shuffle::NONE);
+//
+//   A new dataset creation property list with shuffle and codec set,
+//   e.g.:
+//
+//     codecProperties(Codec::LZ4, DEFAULT_CODEC_LEVEL, Shuffle::BIT)
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/PropertyList.hpp"
+
+#include "hdf5.h"
+
+#include <string>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    enum class Codec {
+      DEFLATE,
+        ZSTD,
+        LZ4
+        };
+
+    enum class Shuffle {
+      NONE,
+        BYTE,
+        BIT
+        };
+
+    constexpr int DEFAULT_CODEC_LEVEL = -1;
+
+    // Registered HDF5 filter IDs.
+    constexpr H5Z_filter_t H5Z_FILTER_ZSTD = 32015;
+    constexpr H5Z_filter_t H5Z_FILTER_LZ4 = 32004;
+    constexpr H5Z_filter_t H5Z_FILTER_BITSHUFFLE = 32008;
+
+    void registerCodecs();
+
+    bool codecAvailable(Codec codec);
+
+    char const * codecName(Codec codec);
+    Codec codecFromName(std::string const & name);
+
+    H5Z_filter_t codecFilter(Codec codec);
+
+    herr_t setCodec(PropertyList & dcpl, Codec codec,
+                    int level = DEFAULT_CODEC_LEVEL);
+
+    herr_t setShuffle(PropertyList & dcpl, Shuffle shuffle);
+
+    PropertyList codecProperties(Codec codec,
+                                 int level = DEFAULT_CODEC_LEVEL,
+                                 Shuffle shuffle = Shuffle::NONE);
+  }
+}
+
+#endif /* hep_hpc_hdf5_Codec_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -23,6 +23,32 @@
 //   for straightforward representation of fixed-length strings.
 //
 ////////////////////////////////////
+// struct hep_hpc::hdf5::dict_string;
+//
+//   A std::string (to which it is convertible in both directions) for
+//   columns of strings taking few distinct values (e.g. detector
+//   names, trigger paths or process labels). A column of dict_string
+//   is dictionary-encoded: each distinct string is assigned a 32-bit
+//   unsigned integer code (in order of first appearance), the column's
+//   dataset holds the codes, and the strings are written to a companion
+//   variable-length string dataset named for the column in the
+//   subgroup _dictionary of the Ntuple's group, such that the string
+//   with code i is its entry i. Not supported in the row-wise layout
+//   (such columns are always written to datasets of their own) or in
+//   SWMR mode.
+//
+////////////////////////////////////
+// Columns of bool.
+//
+//   Flags are bit-packed on file: the dataset of a column of bool
+//   with elements of N flags has elements of (N + 7) / 8 8-bit
+//   bitfields (H5T_NATIVE_B8), laid out as described in
+//   hep_hpc/hdf5/pack_bits.hpp, whose unpack_bits() recovers the
+//   flags. Custom dataset creation properties therefore apply to the
+//   packed shape. Not supported in the row-wise layout (such columns
+//   are always written to datasets of their own), or as key columns.
+//
+////////////////////////////////////
 // enum class hep_hpc::hdf5::TranslationMode;
 //
 //   Force representation on disk regardless of current architecture.
@@ -89,10 +115,34 @@
 //   native representation will be translated to the specifed format for
 //   file storage, where appropriate.
 //
+//////////////////
+// Reduced precision (Column<float, NDIMS> and Column<double, NDIMS>
+// only).
+//
+// void setMantissaBits(unsigned bits);
+// unsigned mantissaBits() const;
+//
+//   Store values rounded to bits explicit mantissa bits (at most, and
+//   by default, 23 for float or 52 for double), e.g. for quantities
+//   measured with a resolution well above the type's precision. The
+//   rounding is applied as rows are inserted; the zeroed low-order
+//   bits make the stored values compress much better. See also
+//   make_column() in hep_hpc/hdf5/make_column.hpp.
+//
+// T relativeErrorBound() const;
+//
+//   Bound on the relative error of each stored normal value:
+//   2^-(bits + 1), or 0 at full precision. (Values so large that they
+//   would round to infinity are truncated instead, with relative error
+//   below 2^-bits. Subnormal values have instead an absolute error of
+//   at most 2^-(bits + 1) times the smallest normal value, and may be
+//   flushed to zero. Infinities and NaNs are stored unchanged.)
+//
 ////////////////////////////////////////////////////////////////////////
 #include "hep_hpc/hdf5/Datatype.hpp"
 #include "hep_hpc/hdf5/Exception.hpp"
 #include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/detail/MantissaRounding.hpp"
 
 #include "hdf5.h"
 
@@ -100,17 +150,30 @@
 #include <cstdint>
 #include <numeric>
 #include <string>
+#include <utility>
 
 namespace hep_hpc {
   namespace hdf5 {
     template<typename T, size_t NDIMS = 1>
     struct Column;
 
+    // Rows per chunk of an Ntuple column's dataset without explicit
+    // chunking if NtupleOptions::chunkBytes() is zero; otherwise, the
+    // default chunk size in bytes and the maximum rows per chunk so
+    // derived (see hep_hpc/hdf5/NtupleOptions.hpp).
     constexpr size_t DEFAULT_CHUNKING = 128ull;
+    constexpr size_t DEFAULT_CHUNK_BYTES = 1ull << 20;
+    constexpr size_t MAX_DEFAULT_CHUNKING = 1ull << 20;
 
     template <size_t SZ>
     using fstring_t = std::array<char, SZ>;
 
+    struct dict_string : std::string {
+      using std::string::string;
+      dict_string() = default;
+      dict_string(std::string s) : std::string(std::move(s)) { }
+    };
+
     enum class TranslationMode : uint8_t {
       NONE,
         IEEE_STD_LE, // Little-endian, IEEE-754 floating point.
@@ -243,14 +306,16 @@ namespace hep_hpc {
     };
 
     template <size_t NDIMS>
-    struct Column<double, NDIMS> : detail::column_base<NDIMS> {
+    struct Column<double, NDIMS> : detail::column_base<NDIMS>,
+                                   detail::mantissa_rounding<double> {
       using detail::column_base<NDIMS>::column_base;
       static hid_t engine_type(TranslationMode mode = TranslationMode::NONE)
         { ENGINE_TYPE(H5T_NATIVE_DOUBLE, H5T_IEEE_F64LE, H5T_IEEE_F64BE) }
     };
 
     template <size_t NDIMS>
-    struct Column<float, NDIMS> : detail::column_base<NDIMS> {
+    struct Column<float, NDIMS> : detail::column_base<NDIMS>,
+                                  detail::mantissa_rounding<float> {
       using detail::column_base<NDIMS>::column_base;
       static hid_t engine_type(TranslationMode mode = TranslationMode::NONE)
         { ENGINE_TYPE(H5T_NATIVE_FLOAT, H5T_IEEE_F32LE, H5T_IEEE_F32BE) }
@@ -474,6 +539,22 @@ namespace hep_hpc {
       hdf5::Datatype STRING_TYPE_;
     };
 
+    // Dictionary-encoded strings are stored as their codes.
+    template <size_t NDIMS>
+    struct Column<dict_string, NDIMS> : detail::column_base<NDIMS> {
+      using detail::column_base<NDIMS>::column_base;
+      static hid_t engine_type(TranslationMode mode = TranslationMode::NONE)
+        { ENGINE_TYPE(H5T_NATIVE_UINT32, H5T_STD_U32LE, H5T_STD_U32BE) }
+    };
+
+    // Flags are bit-packed when written (see detail::BitPacker).
+    template <size_t NDIMS>
+    struct Column<bool, NDIMS> : detail::column_base<NDIMS> {
+      using detail::column_base<NDIMS>::column_base;
+      static hid_t engine_type(TranslationMode mode = TranslationMode::NONE)
+        { ENGINE_TYPE(H5T_NATIVE_B8, H5T_STD_B8LE, H5T_STD_B8BE) }
+    };
+
     namespace detail {
 
       //=============================================================================
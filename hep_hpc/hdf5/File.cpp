@@ -8,7 +8,14 @@ hep_hpc::hdf5::File::File(std::string const & filename,
   :
   h5file_([&]()
           { HID_t result;
-            if (flag == H5F_ACC_RDONLY || flag == H5F_ACC_RDWR) {
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR >= 10)
+            // SWMR flags qualify file-open semantics.
+            unsigned int const openFlag =
+              flag & ~(H5F_ACC_SWMR_READ | H5F_ACC_SWMR_WRITE);
+#else
+            unsigned int const openFlag = flag;
+#endif
+            if (openFlag == H5F_ACC_RDONLY || openFlag == H5F_ACC_RDWR) {
               // Open.
               if (fileCreationProperties.is_valid_non_default()) { // ERROR.
                 throw
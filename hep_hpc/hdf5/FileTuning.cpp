@@ -0,0 +1,114 @@
+#include "hep_hpc/hdf5/FileTuning.hpp"
+
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <algorithm>
+
+hep_hpc::hdf5::FileTuning
+hep_hpc::hdf5::FileTuning::localSSD()
+{
+  return FileTuning{}.
+    setAlignment(4ull << 10, 64ull << 10).
+    setPageSize(64ull << 10).
+    setPageBufferSize(4ull << 20).
+    setMetadataCacheSize(8ull << 20).
+    setMetaBlockSize(64ull << 10).
+    setSmallDataBlockSize(64ull << 10);
+}
+
+hep_hpc::hdf5::FileTuning
+hep_hpc::hdf5::FileTuning::parallelFS(hsize_t const stripeSize)
+{
+  return FileTuning{}.
+    setAlignment(stripeSize, stripeSize).
+    setPageSize(stripeSize).
+    setPageBufferSize(16ull * stripeSize).
+    setMetadataCacheSize(32ull << 20).
+    setMetaBlockSize(stripeSize).
+    setSmallDataBlockSize(stripeSize);
+}
+
+hep_hpc::hdf5::FileTuning
+hep_hpc::hdf5::FileTuning::tmpfs()
+{
+  return FileTuning{}.
+    setMetadataCacheSize(16ull << 20);
+}
+
+herr_t
+hep_hpc::hdf5::setFileCreationTuning(PropertyList & fcpl,
+                                     FileTuning const & tuning)
+{
+  herr_t result = 0;
+  if (tuning.pageSize() != 0ull) {
+#if H5_VERSION_GE(1,10,1)
+    // Free space is not tracked across file closes.
+    if ((result = ErrorController::call(&H5Pset_file_space_strategy,
+                                        fcpl,
+                                        H5F_FSPACE_STRATEGY_PAGE,
+                                        false,
+                                        hsize_t(1ull))) != 0 ||
+        (result = ErrorController::call(&H5Pset_file_space_page_size,
+                                        fcpl,
+                                        tuning.pageSize())) != 0) {
+      return result;
+    }
+#endif
+  }
+  return result;
+}
+
+herr_t
+hep_hpc::hdf5::setFileAccessTuning(PropertyList & fapl,
+                                   FileTuning const & tuning,
+                                   bool const pageBuffer)
+{
+  herr_t result = 0;
+  if ((tuning.alignment() != 1ull || tuning.alignmentThreshold() != 1ull) &&
+      (result = ErrorController::call(&H5Pset_alignment,
+                                      fapl,
+                                      tuning.alignmentThreshold(),
+                                      tuning.alignment())) != 0) {
+    return result;
+  }
+#if H5_VERSION_GE(1,10,1)
+  if (pageBuffer && tuning.pageBufferSize() != 0ull &&
+      (result = ErrorController::call(&H5Pset_page_buffer_size,
+                                      fapl,
+                                      tuning.pageBufferSize(),
+                                      0u, 0u)) != 0) {
+    return result;
+  }
+#else
+  (void) pageBuffer;
+#endif
+  if (tuning.metadataCacheSize() != 0ull) {
+    H5AC_cache_config_t config;
+    config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+    if ((result = ErrorController::call(&H5Pget_mdc_config,
+                                        fapl, &config)) != 0) {
+      return result;
+    }
+    config.set_initial_size = true;
+    config.initial_size = tuning.metadataCacheSize();
+    config.max_size = std::max(config.max_size, config.initial_size);
+    config.min_size = std::min(config.min_size, config.initial_size);
+    if ((result = ErrorController::call(&H5Pset_mdc_config,
+                                        fapl, &config)) != 0) {
+      return result;
+    }
+  }
+  if (tuning.metaBlockSize() != 0ull &&
+      (result = ErrorController::call(&H5Pset_meta_block_size,
+                                      fapl,
+                                      tuning.metaBlockSize())) != 0) {
+    return result;
+  }
+  if (tuning.smallDataBlockSize() != 0ull &&
+      (result = ErrorController::call(&H5Pset_small_data_block_size,
+                                      fapl,
+                                      tuning.smallDataBlockSize())) != 0) {
+    return result;
+  }
+  return result;
+}
@@ -0,0 +1,154 @@
+#ifndef hep_hpc_hdf5_FileTuning_hpp
+#define hep_hpc_hdf5_FileTuning_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::FileTuning
+//
+// A small value class collecting the file-level HDF5 settings affecting
+// I/O performance on a given kind of storage, for files created (or
+// opened) by an Ntuple (see NtupleOptions::setFileTuning() in
+// hep_hpc/hdf5/NtupleOptions.hpp), or by any other means via
+// setFileCreationTuning() and setFileAccessTuning() below. A
+// default-constructed FileTuning leaves every setting at the HDF5
+// default. Setters return a reference to the object so that they may be
+// chained, e.g.:
+//
+//   FileTuning::parallelFS(4 << 20).setMetadataCacheSize(64 << 20)
+//
+////////////////////////////////////
+// Presets
+//
+// static FileTuning localSSD();
+//
+//   Objects of 64 KiB or more aligned to 4 KiB blocks; file space
+//   allocated in 64 KiB pages, with a 4 MiB page buffer; 8 MiB
+//   metadata cache; 64 KiB metadata and small raw data blocks.
+//
+// static FileTuning parallelFS(hsize_t stripeSize = 1 MiB);
+//
+//   For Lustre-like parallel filesystems, where I/O not aligned to
+//   stripes, and many small metadata writes, are expensive: objects of
+//   at least stripeSize aligned to stripes; file space allocated in
+//   stripe-sized pages with a page buffer of 16 stripes, so that
+//   metadata is written a page at a time; 32 MiB metadata cache;
+//   metadata and small raw data blocks of one stripe. N.B. a file then
+//   occupies at least a few stripes, however little it holds.
+//
+// static FileTuning tmpfs();
+//
+//   For memory-backed filesystems, where I/O is cheap but space is
+//   precious: no alignment or paging; 16 MiB metadata cache, to avoid
+//   evicting and re-reading the metadata of many datasets.
+//
+////////////////////////////////////
+// Settings
+//
+// hsize_t alignment (default 1)
+// hsize_t alignmentThreshold (default 1)
+//
+//   Objects of at least alignmentThreshold bytes are allocated at
+//   multiples of alignment (H5Pset_alignment()). 1 for no alignment.
+//
+// hsize_t pageSize (default 0)
+//
+//   If non-zero, the file space is allocated in pages of this size
+//   (H5Pset_file_space_strategy() with H5F_FSPACE_STRATEGY_PAGE, and
+//   H5Pset_file_space_page_size(); at least 512 bytes): small metadata
+//   and raw data are aggregated into pages, and larger objects start
+//   on page boundaries. Applies only to a file being created, and
+//   requires HDF5 >= 1.10.1.
+//
+// std::size_t pageBufferSize (default 0)
+//
+//   If non-zero, the size of the page buffer (H5Pset_page_buffer_size(),
+//   at least pageSize), through which I/O to a paged file takes place a
+//   page at a time. Applies only to files with paged file space, and
+//   not to parallel (MPI-IO) access.
+//
+// std::size_t metadataCacheSize (default 0)
+//
+//   If non-zero, the initial size of the metadata cache (and the
+//   minimum of its maximum size) in bytes (H5Pset_mdc_config()).
+//
+// hsize_t metaBlockSize (default 0)
+// hsize_t smallDataBlockSize (default 0)
+//
+//   If non-zero, the size of the blocks from which space for metadata
+//   and for small raw data objects is allocated
+//   (H5Pset_meta_block_size(), H5Pset_small_data_block_size()).
+//
+////////////////////////////////////
+// Functions
+//
+// herr_t setFileCreationTuning(PropertyList & fcpl,
+//                              FileTuning const & tuning);
+// herr_t setFileAccessTuning(PropertyList & fapl,
+//                            FileTuning const & tuning,
+//                            bool pageBuffer = true);
+//
+//   Apply the settings of tuning to file creation and file access
+//   property lists, respectively: the page buffer only if pageBuffer
+//   is set (e.g. not for a file without paged file space).
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/PropertyList.hpp"
+
+#include "hdf5.h"
+
+#include <cstddef>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    class FileTuning;
+
+    herr_t setFileCreationTuning(PropertyList & fcpl,
+                                 FileTuning const & tuning);
+    herr_t setFileAccessTuning(PropertyList & fapl,
+                               FileTuning const & tuning,
+                               bool pageBuffer = true);
+  }
+}
+
+class hep_hpc::hdf5::FileTuning {
+public:
+  static FileTuning localSSD();
+  static FileTuning parallelFS(hsize_t stripeSize = 1ull << 20);
+  static FileTuning tmpfs();
+
+  // Accessors.
+  hsize_t alignment() const { return alignment_; }
+  hsize_t alignmentThreshold() const { return alignmentThreshold_; }
+  hsize_t pageSize() const { return pageSize_; }
+  std::size_t pageBufferSize() const { return pageBufferSize_; }
+  std::size_t metadataCacheSize() const { return metadataCacheSize_; }
+  hsize_t metaBlockSize() const { return metaBlockSize_; }
+  hsize_t smallDataBlockSize() const { return smallDataBlockSize_; }
+
+  // Setters.
+  FileTuning & setAlignment(hsize_t alignment, hsize_t threshold = 1ull)
+    { alignment_ = alignment; alignmentThreshold_ = threshold; return *this; }
+  FileTuning & setPageSize(hsize_t pageSize)
+    { pageSize_ = pageSize; return *this; }
+  FileTuning & setPageBufferSize(std::size_t pageBufferSize)
+    { pageBufferSize_ = pageBufferSize; return *this; }
+  FileTuning & setMetadataCacheSize(std::size_t metadataCacheSize)
+    { metadataCacheSize_ = metadataCacheSize; return *this; }
+  FileTuning & setMetaBlockSize(hsize_t metaBlockSize)
+    { metaBlockSize_ = metaBlockSize; return *this; }
+  FileTuning & setSmallDataBlockSize(hsize_t smallDataBlockSize)
+    { smallDataBlockSize_ = smallDataBlockSize; return *this; }
+
+private:
+  hsize_t alignment_ {1ull};
+  hsize_t alignmentThreshold_ {1ull};
+  hsize_t pageSize_ {0ull};
+  std::size_t pageBufferSize_ {0ull};
+  std::size_t metadataCacheSize_ {0ull};
+  hsize_t metaBlockSize_ {0ull};
+  hsize_t smallDataBlockSize_ {0ull};
+};
+
+#endif /* hep_hpc_hdf5_FileTuning_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
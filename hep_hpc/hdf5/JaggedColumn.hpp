@@ -0,0 +1,142 @@
+#ifndef hep_hpc_hdf5_JaggedColumn_hpp
+#define hep_hpc_hdf5_JaggedColumn_hpp
+////////////////////////////////////////////////////////////////////////
+// template <typename T> hep_hpc::hdf5::JaggedColumn;
+//
+//   A template representing an Ntuple column whose elements are
+//   variable-length sequences of T (e.g. the hits of an event), T
+//   being a basic arithmetic type (see hep_hpc/hdf5/Column.hpp):
+//
+//     auto nt = make_ntuple({"data.hdf5", "events"},
+//                           make_scalar_column<int>("event"),
+//                           JaggedColumn<float>("hitEnergy"));
+//     std::vector<float> energies;
+//     ...
+//     nt.insert(event, energies);
+//
+//   Rather than padding each row or using HDF5 variable-length types,
+//   the values of all rows are stored contiguously in a flat, chunked
+//   one-dimensional dataset named for the column in the subgroup
+//   _jagged of the Ntuple's group, and the column's own dataset holds
+//   one unsigned 64-bit integer per row: the cumulative number of
+//   values up to and including that row. The values of row i are
+//   therefore [offsets[i - 1], offsets[i]) of the values dataset (with
+//   offsets[-1] = 0). Values are written before the offsets which
+//   refer to them.
+//
+//   Not supported in the row-wise layout (such columns are always
+//   written to datasets of their own) or in SWMR mode.
+//
+////////////////////////////////////
+// template <typename T> hep_hpc::hdf5::jagged_span<T>;
+//
+//   The element type of a JaggedColumn<T>: a view of a contiguous
+//   sequence of T (data, size), constructible from a pointer and size
+//   or from a std::vector<T>. The values are copied on insert(). A
+//   default-constructed (or nullptr) jagged_span is an empty row.
+//
+////////////////////////////////////
+// JaggedColumn details.
+//
+// JaggedColumn(<string-ish> colName,
+//              hsize_t valuesPerChunk = DEFAULT_JAGGED_CHUNKING);
+//
+//   The values dataset is chunked in chunks of valuesPerChunk values;
+//   the offsets dataset is chunked as for any other column (see
+//   setDatasetCreationProperties()).
+//
+// static hid_t engine_type(TranslationMode mode = TranslationMode::NONE);
+// static hid_t value_type(TranslationMode mode = TranslationMode::NONE);
+//
+//   The HDF5 types of the offsets and of the values.
+//
+// hsize_t valuesPerChunk() const;
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Column.hpp"
+
+#include "hdf5.h"
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    template <typename T>
+    struct JaggedColumn;
+
+    template <typename T>
+    struct jagged_span;
+
+    constexpr hsize_t DEFAULT_JAGGED_CHUNKING = 4096ull;
+  }
+}
+
+template <typename T>
+struct hep_hpc::hdf5::jagged_span {
+  jagged_span() = default;
+  jagged_span(T const * d, std::size_t n) : data(d), size(n) { }
+  jagged_span(std::vector<T> const & v) : data(v.data()), size(v.size()) { }
+
+  T const * data {nullptr};
+  std::size_t size {0ull};
+};
+
+template <typename T>
+struct hep_hpc::hdf5::JaggedColumn : detail::column_base<1ull> {
+  static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+                "JaggedColumn requires a basic arithmetic type.");
+
+  JaggedColumn(std::string colName,
+               hsize_t valuesPerChunk = DEFAULT_JAGGED_CHUNKING)
+    : detail::column_base<1ull>(std::move(colName)),
+      valuesPerChunk_(valuesPerChunk)
+    { }
+  JaggedColumn(char const * colName,
+               hsize_t valuesPerChunk = DEFAULT_JAGGED_CHUNKING)
+    : JaggedColumn(std::string(colName), valuesPerChunk)
+    { }
+
+  static hid_t engine_type(TranslationMode mode = TranslationMode::NONE)
+    { ENGINE_TYPE(H5T_NATIVE_UINT64, H5T_STD_U64LE, H5T_STD_U64BE) }
+  static hid_t value_type(TranslationMode mode = TranslationMode::NONE)
+    { return Column<T, 1ull>::engine_type(mode); }
+
+  hsize_t valuesPerChunk() const { return valuesPerChunk_; }
+
+private:
+  hsize_t valuesPerChunk_;
+};
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      template <typename T>
+      struct permissive_column<JaggedColumn<T> > : JaggedColumn<T> {
+        using JaggedColumn<T>::JaggedColumn;
+
+        permissive_column(JaggedColumn<T> && column)
+          :
+          JaggedColumn<T>(std::move(column))
+          {
+          }
+        permissive_column(JaggedColumn<T> const & column)
+          :
+          JaggedColumn<T>(column)
+          {
+          }
+
+        using element_type = jagged_span<T>;
+      };
+    }
+  }
+}
+
+#endif /* hep_hpc_hdf5_JaggedColumn_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
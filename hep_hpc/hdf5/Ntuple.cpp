@@ -1,6 +1,9 @@
 #include "hep_hpc/hdf5/Ntuple.hpp"
 #include "hep_hpc/hdf5/errorHandling.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <numeric>
 #include <stdexcept>
 
 hep_hpc::hdf5::File
@@ -23,3 +26,128 @@ hep_hpc::hdf5::NtupleDetail::verifiedFile(File file)
   }
   return file;
 }
+
+hep_hpc::hdf5::File
+hep_hpc::hdf5::NtupleDetail::openFile(std::string filename,
+                                      NtupleOverwriteFlag const overwriteContents,
+                                      FileTuning const & tuning)
+{
+  htri_t exists = 0;
+  if (overwriteContents == NtupleOverwriteFlag::APPEND) {
+    ScopedErrorHandler seh;
+    exists = H5Fis_hdf5(filename.c_str());
+  }
+  if (exists > 0) {
+    // HDF5 refuses to open a file without paged file space with a page
+    // buffer.
+    bool const paged = (tuning.pageBufferSize() != 0ull) &&
+                       hasPagedFileSpace(filename);
+    return File(std::move(filename), H5F_ACC_RDWR, {},
+                fileAccessProperties(tuning, paged));
+  }
+  return File(std::move(filename), H5F_ACC_TRUNC,
+              fileCreationProperties(tuning),
+              fileAccessProperties(tuning));
+}
+
+bool
+hep_hpc::hdf5::NtupleDetail::hasPagedFileSpace(std::string const & filename)
+{
+#if H5_VERSION_GE(1,10,1)
+  File const file(filename, H5F_ACC_RDONLY);
+  PropertyList const fcpl(ErrorController::call(&H5Fget_create_plist, file),
+                          ResourceStrategy::handle_tag);
+  H5F_fspace_strategy_t strategy;
+  hbool_t persist;
+  hsize_t threshold;
+  return ErrorController::call(&H5Pget_file_space_strategy, fcpl,
+                               &strategy, &persist, &threshold) == 0 &&
+    strategy == H5F_FSPACE_STRATEGY_PAGE;
+#else
+  (void) filename;
+  return false;
+#endif
+}
+
+void
+hep_hpc::hdf5::NtupleDetail::startSWMRWrite(File const & file)
+{
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR >= 10)
+  unsigned intent;
+  if (ErrorController::call(&H5Fget_intent, file, &intent) != (herr_t)0) {
+    throw std::runtime_error("Error obtaining file mode.");
+  }
+  if ((intent & H5F_ACC_SWMR_WRITE) != 0u) { // Already done.
+    return;
+  }
+  if (ErrorController::call(&H5Fstart_swmr_write, file) != (herr_t)0) {
+    throw std::runtime_error("Unable to switch file to SWMR-write mode: "
+                             "it must be open for writing with the latest "
+                             "file format.");
+  }
+#else
+  (void) file;
+  throw std::runtime_error("SWMR mode requires HDF5 >= 1.10.");
+#endif
+}
+
+void
+hep_hpc::hdf5::NtupleDetail::verifyThreadSafeLibrary()
+{
+  hbool_t threadSafe = 0;
+  ErrorController::call(ErrorMode::EXCEPTION,
+                        &H5is_library_threadsafe, &threadSafe);
+  if (!threadSafe) {
+    throw std::runtime_error("Asynchronous Ntuple flushing requires an HDF5 "
+                             "library configured for thread safety.");
+  }
+}
+
+std::uint64_t
+hep_hpc::hdf5::NtupleDetail::nextStagingID()
+{
+  static std::atomic<std::uint64_t> id {0ull};
+  return ++id;
+}
+
+std::unordered_map<std::uint64_t, void *> &
+hep_hpc::hdf5::NtupleDetail::threadStagingBlocks()
+{
+  thread_local std::unordered_map<std::uint64_t, void *> blocks;
+  return blocks;
+}
+
+std::size_t
+hep_hpc::hdf5::NtupleDetail::budgetRows(std::size_t const budget,
+                                        std::size_t const rowBytes,
+                                        std::initializer_list<hsize_t> chunkRows)
+{
+  std::size_t const nRows = (rowBytes == 0ull) ? 1ull :
+                            std::max(budget / rowBytes, std::size_t(1ull));
+  // Least common multiple of the chunk row counts, giving up as soon as
+  // it exceeds the budget.
+  std::size_t alignment = 1ull;
+  for (auto const rows : chunkRows) {
+    if (rows == 0ull) { continue; }
+    alignment = std::lcm(alignment, static_cast<std::size_t>(rows));
+    if (alignment > nRows) {
+      return nRows;
+    }
+  }
+  return nRows - (nRows % alignment);
+}
+
+hsize_t
+hep_hpc::hdf5::NtupleDetail::budgetChunkRows(NtupleOptions const & options,
+                                             std::size_t const rowBytes)
+{
+  std::size_t budget = options.bufferBytes();
+  if (options.memoryPool() &&
+      (budget == 0ull || options.memoryPool()->capacity() < budget)) {
+    budget = options.memoryPool()->capacity();
+  }
+  if (budget == 0ull || rowBytes == 0ull) {
+    return 0ull;
+  }
+  return std::max(hsize_t(budget / (2ull * rowBytes)), hsize_t(1ull));
+}
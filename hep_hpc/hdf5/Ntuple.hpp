@@ -47,6 +47,16 @@
 // * std::string, char const * or char * (variable-length string
 //   support). However, see the notes for insert() below.
 //
+// * hep_hpc::hdf5::dict_string (dictionary-encoded strings: see
+//   hep_hpc/hdf5/Column.hpp), inserted as for std::string.
+//
+// * bool (flags, bit-packed on file: see hep_hpc/hdf5/Column.hpp).
+//
+// Columns of variable-length sequences of a basic arithmetic type may
+// be specified with hep_hpc::hdf5::JaggedColumn<T> (see
+// hep_hpc/hdf5/JaggedColumn.hpp), inserted as a jagged_span<T> (or
+// std::vector<T>) per row.
+//
 // N.B. We recommend using hep_hpc::hdf5::make_ntuple (see
 // hep_hpc/hdf5/make_ntuple.hpp) with hep_hpc::hdf5::make_column() (see
 // hep_hpc/hdf5/make_column.hpp) and/or
@@ -71,6 +81,16 @@
 //                 [TranslationMode mode,]
 //                 std::size_t bufsize = <default>);
 //
+// Ntuple<Args...>(hid_t file,
+//                 std::string tablename,
+//                 column_info_t columns,
+//                 NtupleOptions options);
+//
+// Ntuple<Args...>(std::string filename,
+//                 std::string tablename,
+//                 column_info_t columns,
+//                 NtupleOptions options);
+//
 //   Create an Ntuple tied to an HDF5 file with column types specified
 //   by Args and column information specified by columns. A valid
 //   columns parameter would be a brace-enclosed initializer list whose
@@ -91,7 +111,7 @@
 //
 //   If hid_t is provided, caller is responsible for file resource
 //   management. If filename is provided and file exists, it is
-//   truncated.
+//   truncated (unless appending: see below).
 //
 //   If TranslationMode is specified (see hep_hpc/Column.hpp for
 //   details), then the representation on disk is specified (e.g. as
@@ -103,11 +123,26 @@
 //   overwriteContents controls whether an existing entity of name
 //   <tablename> would be overwritten or not (if not, an exception is
 //   thrown currently). Its value, if specified, should be
-//   hep_hpc::hdf5::NtupleOverwriteFlag::NO or
-//   hep_hpc::hdf5::NtupleOverwriteFlag::YES.
+//   hep_hpc::hdf5::NtupleOverwriteFlag::NO,
+//   hep_hpc::hdf5::NtupleOverwriteFlag::YES or
+//   hep_hpc::hdf5::NtupleOverwriteFlag::APPEND. With APPEND, an
+//   existing file of name filename is opened for writing rather than
+//   truncated, and an existing table <tablename> is reopened: the name,
+//   type (including translation mode) and dimensions of each column
+//   must match those of its existing dataset, which must be chunked
+//   and extendible, and all columns must have the same number of rows
+//   (else an exception is thrown). Rows are then appended after the
+//   existing ones. A table (or file) not already present is created as
+//   usual.
 //
 //   Buffer size controls how many rows are cached in memory before
-//   being flushed to the file; defaults to 1000 if not specified.
+//   being flushed to the file; defaults to 1000 if not specified. A
+//   memory budget may be specified instead via
+//   NtupleOptions::setBufferBytes().
+//
+//   Where options is specified (see hep_hpc/hdf5/NtupleOptions.hpp),
+//   it supplies the translation mode, overwrite flag and buffer size
+//   along with any other settings, such as asynchronous flushing.
 //
 //   Insertion is row-wise; storage is column-wise.
 //
@@ -116,7 +151,10 @@
 //
 //   This nontrivial destructor will ensure that all existing buffered
 //   data have been flushed to the HDF5, and the file and all associated
-//   HDF5 entities have been closed
+//   HDF5 entities have been closed. In NtupleFlushMode::ASYNC, any
+//   outstanding asynchronous write is completed first. If key columns
+//   were specified (see NtupleOptions::setKeyColumns()), the key index
+//   is then written.
 //
 ////////////////////////////////////
 // std::string name() const;
@@ -130,6 +168,21 @@
 //   Ntuple.
 //
 ////////////////////////////////////
+// std::size_t bufsize() const;
+//
+//   The number of rows cached in memory before being flushed to the
+//   file (per staging block in NtupleInsertMode::PER_THREAD).
+//
+////////////////////////////////////
+// std::size_t chunkRewrites() const;
+//
+//   The number of writes to a dataset so far which began within an
+//   already-written chunk, requiring HDF5 to read back and rewrite that
+//   chunk. With NtupleOptions::chunkAlignedFlush() (the default), this
+//   happens only for the first write to a dataset after an explicit
+//   flush() which ended mid-chunk.
+//
+////////////////////////////////////
 // static constexpr std::size_t nColumns();
 //
 //    Static function returning the number of columns defined for the
@@ -139,6 +192,19 @@
 // std::array<Dataset, ncolumns()> const & datasets() const;
 //
 //   Give access to the HDF5 datasets representing the data in the file.
+//   N.B. their extents are grown geometrically as rows are written
+//   (other than in SWMR mode: see NtupleOptions), and may therefore
+//   exceed the number of rows written other than after flush() or
+//   destruction of the Ntuple. With
+//   NtupleLayout::ROW_COMPOUND (see NtupleOptions), the datasets of
+//   columns stored in rowDataset() are invalid.
+//
+////////////////////////////////////
+// Dataset const & rowDataset() const;
+//
+//   With NtupleLayout::ROW_COMPOUND, give access to the dataset of
+//   compound type holding the columns of fixed-size type, one element
+//   per row (invalid otherwise).
 //
 ////////////////////////////////////
 // template <typename T>
@@ -159,40 +225,98 @@
 //   N.B. Variable-length strings are supported with a basic element
 //   type of std::string or const char * (or char *). In the case of
 //   std::string, you are providing to insert() a pointer to a
-//   contiguous array of std::string, each of which is copied at
-//   insert() time. In the case of the char * types, one therefore
-//   provides to insert() a char const * * (or char * *) which points to
-//   a contiguous array of char const * (or char *), /each of which must
-//   continue to point to a valid null-terminated character string until
-//   the buffer has been flushed/.
+//   contiguous array of std::string; in the case of the char * types,
+//   a char const * * (or char * *) which points to a contiguous array
+//   of char const * (or char *), each a null-terminated character
+//   string (or nullptr, for an empty one). Either way, each string is
+//   copied at insert() time into a contiguous character pool (so that,
+//   once the pool has grown to accommodate a full buffer, no per-row
+//   memory allocation is required), and need not outlive the call.
 //
 //   If the buffer is full, it will be flushed prior to the data being
-//   inserted.
+//   inserted (as whole chunks: see NtupleOptions::chunkAlignedFlush()).
+//   In NtupleFlushMode::ASYNC, the full buffer is instead handed to the
+//   writer thread and insertion continues into the second buffer; if
+//   the writer is still busy with the previous buffer, insert() waits
+//   for it to finish.
+//
+//   In NtupleInsertMode::PER_THREAD, the row is appended without
+//   locking to the calling thread's own staging block (see
+//   hep_hpc/hdf5/NtupleOptions.hpp).
+//
+////////////////////////////////////
+// void insert_columns(std::size_t nRows,
+//                     <column-element-type> const * ...);
+//
+//   Insert nRows rows of data provided column-wise. Each argument
+//   after nRows is a pointer to a contiguous sequence of nRows *
+//   Column::elementSize() items of the basic element type of the
+//   corresponding column (it is a compile-time error to fail to provide
+//   one argument per column), organized as for insert(); nullptr
+//   signifies nRows default-constructed rows. The data are copied en
+//   bloc into the buffers, avoiding per-row overhead; a batch of more
+//   than bufsize rows is written directly to file (after any
+//   currently-buffered rows), bypassing the buffers altogether. The
+//   variable-length string caveats for insert() apply here also.
+//
+//   In NtupleInsertMode::PER_THREAD, the rows are appended to the
+//   calling thread's staging block(s) and are therefore contiguous in
+//   the table only within each block.
+//
+////////////////////////////////////
+// void insert_strided(std::size_t nRows,
+//                     std::size_t stride,
+//                     <column-element-type> const * ...);
+//
+//   As for insert_columns(), except that successive rows of each column
+//   are stride bytes apart rather than contiguous: e.g. each pointer
+//   may point to a member of the first of an array of nRows structs,
+//   with stride equal to the size of the struct (but see also
+//   hep_hpc/hdf5/StructNtuple.hpp). The Column::elementSize() items of
+//   each row must be contiguous. Rows are always copied into the
+//   buffers, which are flushed as they fill.
 //
 ////////////////////////////////////
 //
 // void flush()
 //
-//   Flush the currently-buffered data to file.
+//   Flush the currently-buffered data to file, including any rows held
+//   back to complete a chunk (see NtupleOptions::chunkAlignedFlush()). In
+//   NtupleFlushMode::ASYNC, any outstanding asynchronous write is
+//   completed first, so that all data inserted so far have been written
+//   on return. In NtupleInsertMode::PER_THREAD, only rows staged by the
+//   calling thread (and all completed blocks) are written.
 //
 ////////////////////////////////////////////////////////////////////////
-#include "hep_hpc/Utilities/detail/compiler_macros.hpp"
 #include "hep_hpc/Utilities/detail/index_sequence.hpp"
 #include "hep_hpc/hdf5/Column.hpp"
 #include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/FileTuning.hpp"
+#include "hep_hpc/hdf5/JaggedColumn.hpp"
+#include "hep_hpc/hdf5/NtupleMemoryPool.hpp"
+#include "hep_hpc/hdf5/NtupleOptions.hpp"
+#include "hep_hpc/hdf5/detail/AtomicStack.hpp"
+#include "hep_hpc/hdf5/detail/KeyIndex.hpp"
 #include "hep_hpc/hdf5/detail/NtupleDataStructure.hpp"
+#include "hep_hpc/hdf5/detail/NtupleWriterThread.hpp"
 #include "hep_hpc/hdf5/errorHandling.hpp"
 
 #include "hdf5.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
 #include <iostream>
 #include <iterator>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -201,8 +325,6 @@ namespace hep_hpc {
     template <typename... Args>
     class Ntuple;
 
-    enum class NtupleOverwriteFlag : bool { NO, YES };
-
   } // Namespace hdf5.
 } // Namespace hep_hpc.
 
@@ -211,6 +333,10 @@ class hep_hpc::hdf5::Ntuple {
 public:
   using column_info_t = std::tuple<detail::permissive_column<Args>...>;
 
+  // Basic element type of a column described by T.
+  template <typename T>
+  using Element_t = typename detail::permissive_column<T>::element_type;
+
   // 1.
   Ntuple(hid_t file,
          std::string tablename,
@@ -267,16 +393,36 @@ public:
          column_info_t columns,
          std::size_t bufsize);
 
+  // 9.
+  Ntuple(hid_t file,
+         std::string tablename,
+         column_info_t columns,
+         NtupleOptions options);
+
+  // 10.
+  Ntuple(std::string filename,
+         std::string tablename,
+         column_info_t columns,
+         NtupleOptions options);
+
   ~Ntuple() noexcept;
 
   File const & file() const;
   std::string const & name() const;
   Group const &  group() const;
+  std::size_t bufsize() const { return bufRows_(); }
+  std::size_t chunkRewrites() const { return dd_->chunkRewrites; }
   static constexpr std::size_t nColumns() { return sizeof...(Args); }
   std::array<Dataset, nColumns()> const & datasets() const;
+  Dataset const & rowDataset() const { return dd_->rows; }
 
   template <typename... T>
   void insert(T && ...);
+  void insert_columns(std::size_t nRows,
+                      Element_t<Args> const * ... columns);
+  void insert_strided(std::size_t nRows,
+                      std::size_t stride,
+                      Element_t<Args> const * ... columns);
   void flush();
 
   // Enable moving
@@ -290,13 +436,13 @@ public:
 private:
   static_assert(nColumns() > 0, "Ntuple with zero types is meaningless");
 
-  template <typename T>
-  using Element_t = typename detail::permissive_column<T>::element_type;
+  using buffers_t = std::tuple<detail::column_buffer_t<Element_t<Args> >...>;
+  using data_structure_t = detail::NtupleDataStructure<Args...>;
 
   static constexpr hep_hpc::detail::make_index_sequence<nColumns()> iSequence()
     { return hep_hpc::detail::make_index_sequence<nColumns()>(); }
 
-  // 5.
+  // 11.
   //
   // This is the c'tor that does all of the work. It exists so that the
   // Args... and column-names array can be expanded in parallel.
@@ -304,21 +450,170 @@ private:
   Ntuple(File file,
          std::string tablename,
          column_info_t columns,
-         TranslationMode mode,
-         NtupleOverwriteFlag overwriteContents,
-         std::size_t bufsize,
+         NtupleOptions const & options,
          hep_hpc::detail::index_sequence<I...>);
 
+  // Write the contents of buffers to the datasets of dd (see
+  // writeColumn_()) and clear them. Caller is responsible for ensuring
+  // exclusive access to both.
+  template <size_t... I>
+  static int flush_(buffers_t & buffers,
+                    data_structure_t & dd,
+                    bool force,
+                    hep_hpc::detail::index_sequence<I...>);
+
+  // Write nRows rows of the columns stored in the row-wise dataset of
+  // dd, if any. The data of other columns are ignored.
+  template <size_t... I>
+  static int writeRows_(data_structure_t & dd,
+                        std::size_t nRows,
+                        hep_hpc::detail::index_sequence<I...>,
+                        std::array<void const *, nColumns()> const & data);
+
+  // Write nRows rows of column I to its dataset, preceded by any rows
+  // carried over from the previous write. Unless force is set (or
+  // NtupleOptions::chunkAlignedFlush() is false), only whole chunks are
+  // written and any remainder is carried over to the next write.
+  template <size_t I, typename T>
+  static int writeColumn_(data_structure_t & dd,
+                          T const * data,
+                          std::size_t nRows,
+                          bool force);
+
+  // Deal with a full buffer: flush it or hand it to the writer thread,
+  // as appropriate. Caller must hold the lock.
+  void handoff_();
+
+  // Append nRows rows starting at row firstRow of the provided columns
+  // to buffers.
+  template <size_t... I>
+  void appendColumns_(buffers_t & buffers,
+                      std::size_t firstRow,
+                      std::size_t nRows,
+                      hep_hpc::detail::index_sequence<I...>,
+                      Element_t<Args> const * ... columns) const;
+
+  // As appendColumns_(), with rows stride bytes apart.
+  template <size_t... I>
+  void appendStrided_(buffers_t & buffers,
+                      std::size_t firstRow,
+                      std::size_t nRows,
+                      std::size_t stride,
+                      hep_hpc::detail::index_sequence<I...>,
+                      Element_t<Args> const * ... columns) const;
+
+  // Write nRows rows of the provided columns directly to the datasets
+  // of dd.
+  template <size_t... I>
+  static int writeColumns_(data_structure_t & dd,
+                           std::size_t nRows,
+                           hep_hpc::detail::index_sequence<I...>,
+                           Element_t<Args> const * ... columns);
+
+  // Record in dd.heldBytes the memory held by the buffers of dd, and
+  // by writerBuffers if any, in bytes. Caller must have exclusive
+  // access to all of them (in NtupleFlushMode::ASYNC, by being the
+  // writer thread or having waited for it).
+  template <size_t... I>
+  static void recordHeldBytes_(data_structure_t & dd,
+                               buffers_t const * writerBuffers,
+                               hep_hpc::detail::index_sequence<I...>);
+
+  // Memory held by the buffers of an Ntuple, in bytes: buffers, plus
+  // the rest as last recorded by recordHeldBytes_().
+  template <size_t... I>
+  static std::size_t heldBytes_(data_structure_t const & dd,
+                                buffers_t const & buffers,
+                                hep_hpc::detail::index_sequence<I...>);
+
+  // Report the memory held to the pool, if any. Returns true if the
+  // pool should reclaim memory. Caller must hold the lock.
+  bool charge_();
+
+  // In-memory size of a row of columns, in bytes.
+  template <size_t... I>
+  static std::size_t rowBytes_(column_info_t const & columns,
+                               hep_hpc::detail::index_sequence<I...>);
+
+  // Rows per buffer.
+  std::size_t bufRows_() const
+    { return max_[0] / std::get<0>(dd_->columns).elementSize(); }
+
+  template <size_t... I>
+  void reserve_(buffers_t & buffers,
+                hep_hpc::detail::index_sequence<I...>) const;
+
   template <size_t... I>
-  int flush_(hep_hpc::detail::index_sequence<I...>);
+  static void clear_(buffers_t & buffers,
+                     hep_hpc::detail::index_sequence<I...>);
+
+  // NtupleInsertMode::PER_THREAD only.
+  struct StagingBlock_ {
+    buffers_t buffers {};
+    StagingBlock_ * next {nullptr};
+  };
+
+  struct Staging_ {
+    explicit Staging_(std::uint64_t id) : id(id) { }
+    // Key for per-thread lookup of the current staging block.
+    std::uint64_t const id;
+    // Owner of all staging blocks.
+    std::mutex blocksMutex {};
+    std::vector<std::unique_ptr<StagingBlock_> > blocks {};
+    // Completed blocks awaiting flush.
+    detail::AtomicStack<StagingBlock_> full {};
+    // Flushed blocks available for reuse.
+    detail::AtomicStack<StagingBlock_> free {};
+    // Is a thread currently writing completed blocks?
+    std::atomic<bool> draining {false};
+    // Asynchronous flush only: has flush() been called?
+    std::atomic<bool> flushAll {false};
+  };
+
+  template <typename... T>
+  void insertStaged_(T && ... args);
+
+  // The calling thread's current staging block (acquired if necessary).
+  StagingBlock_ & stagingBlock_();
+
+  StagingBlock_ * acquireStagingBlock_();
+
+  // Pass the calling thread's current staging block to the flush path.
+  void releaseStagingBlock_();
+
+  // Write completed blocks if no other thread is doing so. If
+  // flushAll, wait for any other thread to finish doing so, and then
+  // write all carried-over rows also.
+  void drainStaged_(bool flushAll);
+
+  // Write all completed blocks (and carried-over rows, if force).
+  // Caller is responsible for ensuring exclusive access to dd.
+  static int drain_(Staging_ & staging, data_structure_t & dd, bool force);
 
-  std::tuple<std::vector<Element_t<Args> >...> buffers_;
+  // Membership of the memory pool, if any. N.B. it precedes all the
+  // state used to release memory, so that move assignment leaves the
+  // pool before that state is replaced.
+  std::unique_ptr<NtupleMemoryPool::Client> poolClient_ {};
+
+  // Asynchronous flush only: the thread writing writerBuffers_. N.B. it
+  // precedes all the state it uses so that move assignment retires the
+  // old writer thread (completing any outstanding write) before that
+  // state is replaced.
+  std::unique_ptr<detail::NtupleWriterThread> writer_ {};
+
+  // Held by pointer so that its address is stable for the memory
+  // pool across moves of the Ntuple.
+  std::unique_ptr<buffers_t> buffers_ {new buffers_t};
 
   File file_;
   std::string name_;
   std::array<size_t, nColumns()> max_;
   std::unique_ptr<std::recursive_mutex> mutex_ {};
-  detail::NtupleDataStructure<Args...> dd_;
+  // Held by pointer so that addresses are stable for the writer thread
+  // across moves of the Ntuple.
+  std::unique_ptr<buffers_t> writerBuffers_ {};
+  std::unique_ptr<Staging_> staging_ {};
+  std::unique_ptr<data_structure_t> dd_;
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -330,6 +625,46 @@ namespace hep_hpc {
     namespace NtupleDetail {
       File verifiedFile(File file);
 
+      // Open the named file for an Ntuple: truncated, unless it exists
+      // and overwriteContents is NtupleOverwriteFlag::APPEND, with the
+      // settings of tuning (see FileTuning.hpp).
+      File openFile(std::string filename,
+                    NtupleOverwriteFlag overwriteContents,
+                    FileTuning const & tuning = {});
+
+      // Was the named (existing) file created with paged file space
+      // (see FileTuning::pageSize())?
+      bool hasPagedFileSpace(std::string const & filename);
+
+      // Switch file to single-writer/multiple-reader mode, if it is not
+      // already.
+      void startSWMRWrite(File const & file);
+
+      // Throw if the HDF5 library is not configured for thread safety.
+      void verifyThreadSafeLibrary();
+
+      // Number of rows of rowBytes each fitting in budget bytes,
+      // rounded down to a multiple of the least common multiple of the
+      // non-zero chunkRows if possible. Minimum 1.
+      std::size_t budgetRows(std::size_t budget,
+                             std::size_t rowBytes,
+                             std::initializer_list<hsize_t> chunkRows);
+
+      // Limit on the rows per chunk of default chunking such that the
+      // rows of rowBytes held back to complete one chunk of every
+      // column take at most half of the memory allowed by options: the
+      // smaller of bufferBytes and the capacity of memoryPool, where
+      // set. 0 (no limit) if neither is.
+      hsize_t budgetChunkRows(NtupleOptions const & options,
+                              std::size_t rowBytes);
+
+      // Unique identifier for an Ntuple's per-thread staging blocks.
+      std::uint64_t nextStagingID();
+
+      // The calling thread's current staging block for each Ntuple
+      // using NtupleInsertMode::PER_THREAD, by identifier.
+      std::unordered_map<std::uint64_t, void *> & threadStagingBlocks();
+
       template <size_t I, typename TUPLE, typename COLS, typename... Tail>
       void
       insert(TUPLE & buffers, COLS const & cols,
@@ -346,27 +681,92 @@ namespace hep_hpc {
       void
       insert(TUPLE &, COLS const &) { }
 
-      template <typename BUFFER, typename COL>
-      herr_t flush_one(BUFFER & buf, Dataset & dset, COL const & col);
+      // Append nRows rows of a column (nullptr: default-constructed
+      // rows) to its buffer.
+      template <typename T, typename COL, typename U>
+      void append_rows(std::vector<T> & buf, COL const & col,
+                       U const * data, std::size_t nRows);
+
+      // Special case: variable-length strings.
+      template <typename COL, typename U>
+      void append_rows(detail::StringArena & buf, COL const & col,
+                       U const * data, std::size_t nRows);
+
+      // As append_rows(), with rows stride bytes apart.
+      template <typename T, typename COL, typename U>
+      void append_rows_strided(std::vector<T> & buf, COL const & col,
+                               U const * data, std::size_t stride,
+                               std::size_t nRows);
+
+      template <typename COL, typename U>
+      void append_rows_strided(detail::StringArena & buf, COL const & col,
+                               U const * data, std::size_t stride,
+                               std::size_t nRows);
+
+      // Jagged columns.
+      template <typename T, typename COL>
+      void append_rows(detail::JaggedBuffer<T> & buf, COL const & col,
+                       jagged_span<T> const * data, std::size_t nRows);
+
+      template <typename T, typename COL>
+      void append_rows_strided(detail::JaggedBuffer<T> & buf, COL const & col,
+                               jagged_span<T> const * data, std::size_t stride,
+                               std::size_t nRows);
+
+      // Write nRows rows of a column after the rows already written to
+      // its dataset, growing the dataset's extent if necessary.
+      template <typename T, typename COL>
+      herr_t write_rows(T const * data, hsize_t nRows,
+                        Dataset & dset, COL const & col,
+                        detail::ColumnWriteState & state);
 
       // Special case: shim for std::string.
       template <typename COL>
-      herr_t flush_one(std::vector<std::string> & buf,
-                       Dataset & dset,
-                       COL const & col);
+      herr_t write_rows(std::string const * data, hsize_t nRows,
+                        Dataset & dset, COL const & col,
+                        detail::ColumnWriteState & state);
+
+      // As write_rows() above, along with the column's companion (see
+      // detail::column_companion), if it has one.
+      template <typename T, typename COL>
+      herr_t write_rows(detail::NoCompanion &,
+                        T const * data, hsize_t nRows,
+                        Dataset & dset, COL const & col,
+                        detail::ColumnWriteState & state);
+
+      template <typename T, typename COL>
+      herr_t write_rows(detail::StringDictionary & dictionary,
+                        T const * data, hsize_t nRows,
+                        Dataset & dset, COL const & col,
+                        detail::ColumnWriteState & state);
+
+      template <typename T, typename COL>
+      herr_t write_rows(detail::JaggedValues<T> & values,
+                        jagged_span<T> const * data, hsize_t nRows,
+                        Dataset & dset, COL const & col,
+                        detail::ColumnWriteState & state);
 
-      // Special case: shim for std::array.
-      template <int SZ, typename COL>
-      herr_t flush_one(std::vector<std::array<char, SZ> > & buf,
-                       Dataset & dset,
-                       COL const & col);
+      template <typename B, typename COL>
+      herr_t write_rows(detail::BitPacker & packer,
+                        B const * data, hsize_t nRows,
+                        Dataset & dset, COL const & col,
+                        detail::ColumnWriteState & state);
 
-      PropertyList fileAccessProperties()
+      inline PropertyList fileAccessProperties(FileTuning const & tuning = {},
+                                               bool pageBuffer = true)
       {
         // Ensure we are using the latest available HDF5 file format to
         // write our data.
         PropertyList plist(H5P_FILE_ACCESS);
         H5Pset_libver_bounds(plist, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+        setFileAccessTuning(plist, tuning, pageBuffer);
+        return plist;
+      }
+
+      inline PropertyList fileCreationProperties(FileTuning const & tuning)
+      {
+        PropertyList plist(H5P_FILE_CREATE);
+        setFileCreationTuning(plist, tuning);
         return plist;
       }
 
@@ -386,9 +786,10 @@ Ntuple(hid_t file,
   Ntuple{File(file),
     std::move(name),
     std::move(columns),
-    mode,
-    overwriteContents,
-    bufsize,
+    NtupleOptions{}
+      .setMode(mode)
+      .setOverwriteContents(overwriteContents)
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
@@ -403,9 +804,9 @@ Ntuple(hid_t file,
   Ntuple{File(file),
     std::move(name),
     std::move(columns),
-    mode,
-    NtupleOverwriteFlag::NO,
-    bufsize,
+    NtupleOptions{}
+      .setMode(mode)
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
@@ -420,9 +821,9 @@ Ntuple(hid_t file,
   Ntuple{File(file),
     std::move(name),
     std::move(columns),
-    TranslationMode::NONE,
-    overwriteContents,
-    bufsize,
+    NtupleOptions{}
+      .setOverwriteContents(overwriteContents)
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
@@ -436,9 +837,8 @@ Ntuple(hid_t file,
   Ntuple{File(file),
     std::move(name),
     std::move(columns),
-    TranslationMode::NONE,
-    NtupleOverwriteFlag::NO,
-    bufsize,
+    NtupleOptions{}
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
@@ -451,13 +851,13 @@ Ntuple(std::string filename,
        TranslationMode const mode,
        NtupleOverwriteFlag const overwriteContents,
        std::size_t const bufsize) :
-  Ntuple{File(std::move(filename), H5F_ACC_TRUNC, {},
-              NtupleDetail::fileAccessProperties()),
+  Ntuple{NtupleDetail::openFile(std::move(filename), overwriteContents),
     std::move(name),
     std::move(columns),
-    mode,
-    overwriteContents,
-    bufsize,
+    NtupleOptions{}
+      .setMode(mode)
+      .setOverwriteContents(overwriteContents)
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
@@ -473,9 +873,9 @@ Ntuple(std::string filename,
               NtupleDetail::fileAccessProperties()),
     std::move(name),
     std::move(columns),
-    mode,
-    NtupleOverwriteFlag::NO,
-    bufsize,
+    NtupleOptions{}
+      .setMode(mode)
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
@@ -487,13 +887,12 @@ Ntuple(std::string filename,
        column_info_t columns,
        NtupleOverwriteFlag const overwriteContents,
        std::size_t const bufsize) :
-  Ntuple{File(std::move(filename), H5F_ACC_TRUNC, {},
-              NtupleDetail::fileAccessProperties()),
+  Ntuple{NtupleDetail::openFile(std::move(filename), overwriteContents),
     std::move(name),
     std::move(columns),
-    TranslationMode::NONE,
-    overwriteContents,
-    bufsize,
+    NtupleOptions{}
+      .setOverwriteContents(overwriteContents)
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
@@ -508,42 +907,258 @@ Ntuple(std::string filename,
               NtupleDetail::fileAccessProperties()),
     std::move(name),
     std::move(columns),
-    TranslationMode::NONE,
-    NtupleOverwriteFlag::NO,
-    bufsize,
+    NtupleOptions{}
+      .setBufsize(bufsize),
     iSequence()}
 {}
 
 // 9.
 template <typename... Args>
+hep_hpc::hdf5::Ntuple<Args...>::
+Ntuple(hid_t file,
+       std::string name,
+       column_info_t columns,
+       NtupleOptions options) :
+  Ntuple{File(file),
+    std::move(name),
+    std::move(columns),
+    options,
+    iSequence()}
+{}
+
+// 10.
+template <typename... Args>
+hep_hpc::hdf5::Ntuple<Args...>::
+Ntuple(std::string filename,
+       std::string name,
+       column_info_t columns,
+       NtupleOptions options) :
+  Ntuple{NtupleDetail::openFile(std::move(filename),
+                                options.overwriteContents(),
+                                options.fileTuning()),
+    std::move(name),
+    std::move(columns),
+    options,
+    iSequence()}
+{}
+
+// 11.
+template <typename... Args>
 template <std::size_t... I>
 hep_hpc::hdf5::Ntuple<Args...>::
 Ntuple(File file,
        std::string name,
        column_info_t columns,
-       TranslationMode mode,
-       NtupleOverwriteFlag overwriteContents,
-       std::size_t const bufsize,
+       NtupleOptions const & options,
        hep_hpc::detail::index_sequence<I...>) :
   file_{NtupleDetail::verifiedFile(std::move(file))},
   name_{std::move(name)},
-  max_{(std::get<I>(columns).elementSize() * bufsize)...},
+  max_{(std::get<I>(columns).elementSize() * options.bufsize())...},
   mutex_{new std::recursive_mutex},
-  dd_(file_, name_, mode, static_cast<bool>(overwriteContents), std::move(std::get<I>(columns))...)
+  dd_{new data_structure_t(file_, name_, options.mode(),
+                           options.overwriteContents(),
+                           options.layout() == NtupleLayout::ROW_COMPOUND,
+                           options.chunkBytes(),
+                           NtupleDetail::
+                           budgetChunkRows(options,
+                                           rowBytes_(columns,
+                                                     hep_hpc::detail::
+                                                     index_sequence<I...>())),
+                           options.shuffle(),
+                           std::move(std::get<I>(columns))...)}
 {
-  // Reserve buffer space.
+  using std::get;
   using swallow = int[];
-  // Reserve the right amount of space in each buffer.
-  (void) swallow {0, (std::get<I>(buffers_).reserve(max_[I]), 0)...};
+  dd_->chunkAligned = options.chunkAlignedFlush();
+  if (options.chunkStatistics()) {
+    dd_->enableStatistics();
+  }
+  if (!options.keyColumns().empty()) {
+    if (options.swmr()) {
+      throw std::runtime_error("A key index is not supported in SWMR mode "
+                               "(Ntuple " + name_ + ").");
+    }
+    for (auto const & key : options.keyColumns()) {
+      bool found = false;
+      (void) swallow {0,
+          (found = found ||
+           (get<I>(dd_->columns).name() == key &&
+            std::is_integral<Element_t<Args> >::value &&
+            !std::is_same<Element_t<Args>, bool>::value &&
+            get<I>(dd_->columns).elementSize() == 1ull), 0)...};
+      if (!found) {
+        throw std::runtime_error("Key column " + key + " is not a scalar "
+                                 "integer column of Ntuple " + name_ + ".");
+      }
+    }
+    dd_->keyColumns = options.keyColumns();
+  }
+  if (options.swmr()) {
+    bool fixedSize = true;
+    (void) swallow {0,
+        (fixedSize = fixedSize &&
+         (detail::isRowColumn(get<I>(dd_->columns)) ||
+          std::is_same<Element_t<Args>, bool>::value), 0)...};
+    if (!fixedSize) {
+      throw std::runtime_error("Variable-length string, dictionary-encoded "
+                               "string and jagged columns are not supported "
+                               "in SWMR mode (Ntuple " + name_ + ").");
+    }
+    // Readers see the extent of each dataset, so it must match the rows
+    // written.
+    for (auto & state : dd_->state) {
+      state.exactExtent = true;
+    }
+    dd_->rowState.exactExtent = true;
+    dd_->swmr = true;
+    NtupleDetail::startSWMRWrite(file_);
+  }
+  if (options.compressionThreads() != 0u) {
+    dd_->compressors.reset(new detail::ThreadPool(options.compressionThreads() - 1u));
+    (void) swallow {0,
+        ((dd_->rowOffsets[I] < 0) ?
+         detail::configureDirectChunkWrite(get<I>(dd_->dsets),
+                                           get<I>(dd_->columns).
+                                           engine_type(TranslationMode::NONE),
+                                           dd_->state[I],
+                                           dd_->compressors.get()) :
+         (void) 0, 0)...};
+  }
+  if (options.bufferBytes() != 0ull) {
+    // Derive the buffer size from what is left of the memory budget
+    // after the rows which may be held back to complete a chunk of
+    // each column (reserved now, so that growth does not exceed it).
+    std::size_t carryBytes = 0ull;
+    if (dd_->chunkAligned) {
+      (void) swallow {0,
+          ((dd_->rowOffsets[I] >= 0) ? (void) 0 :
+           (get<I>(dd_->carry).reserve(dd_->state[I].chunkRows *
+                                       get<I>(dd_->columns).elementSize()),
+            (void) (carryBytes +=
+                    detail::capacityBytes(get<I>(dd_->carry)))), 0)...};
+    }
+    // Each row is buffered once per set of buffers, and once more when
+    // packed for the row-wise dataset, if any.
+    std::size_t const sets =
+      (options.flushMode() == NtupleFlushMode::ASYNC &&
+       options.insertMode() == NtupleInsertMode::LOCKED) ? 2ull : 1ull;
+    auto const nRows =
+      NtupleDetail::budgetRows((options.bufferBytes() > carryBytes) ?
+                               options.bufferBytes() - carryBytes : 0ull,
+                               sets * rowBytes_(dd_->columns,
+                                                hep_hpc::detail::
+                                                index_sequence<I...>()) +
+                               dd_->rowSize,
+                               {dd_->state[I].chunkRows...});
+    max_ = {(get<I>(dd_->columns).elementSize() * nRows)...};
+  }
+  if (options.memoryPool() &&
+      options.insertMode() == NtupleInsertMode::PER_THREAD) {
+    throw std::runtime_error("NtupleMemoryPool is not supported with "
+                             "NtupleInsertMode::PER_THREAD.");
+  }
+  if (options.insertMode() == NtupleInsertMode::PER_THREAD) {
+    // Buffers are per-thread staging blocks, allocated on demand.
+    staging_.reset(new Staging_(NtupleDetail::nextStagingID()));
+  } else if (!options.memoryPool() || options.bufferBytes() != 0ull) {
+    // Reserve the right amount of space in each buffer (so that a
+    // memory budget is not exceeded by their growth).
+    reserve_(*buffers_, iSequence());
+  }
+  if (options.flushMode() == NtupleFlushMode::ASYNC) {
+    NtupleDetail::verifyThreadSafeLibrary();
+    if (staging_) {
+      writer_.reset(new detail::NtupleWriterThread
+                    ([staging = staging_.get(), dd = dd_.get()]()
+                     { return drain_(*staging, *dd,
+                                     staging->flushAll.exchange(false)); }));
+    } else {
+      writerBuffers_.reset(new buffers_t);
+      if (!options.memoryPool() || options.bufferBytes() != 0ull) {
+        reserve_(*writerBuffers_, iSequence());
+      }
+      writer_.reset(new detail::NtupleWriterThread
+                    ([buffers = writerBuffers_.get(), dd = dd_.get()]()
+                     {
+                       int const result =
+                         flush_(*buffers, *dd, false, iSequence());
+                       recordHeldBytes_(*dd, buffers, iSequence());
+                       return result;
+                     }));
+    }
+  }
+  if (options.memoryPool()) {
+    // Forced flush: write everything and release the memory.
+    poolClient_ = options.memoryPool()->enroll
+      ([mutex = mutex_.get(),
+        writer = writer_.get(),
+        buffers = buffers_.get(),
+        writerBuffers = writerBuffers_.get(),
+        dd = dd_.get()](NtupleMemoryPool::Client & client)
+       {
+         std::lock_guard<std::recursive_mutex> lock {*mutex};
+         if (writer) {
+           writer->wait();
+         }
+         if (flush_(*buffers, *dd, true, iSequence()) != 0) {
+           throw std::runtime_error("HDF5 write failure.");
+         }
+         *buffers = buffers_t{};
+         if (writerBuffers) {
+           *writerBuffers = buffers_t{};
+         }
+         dd->carry = decltype(dd->carry){};
+         dd->rowBuffer = decltype(dd->rowBuffer){};
+         recordHeldBytes_(*dd, writerBuffers, iSequence());
+         (void) client.charge(heldBytes_(*dd, *buffers, iSequence()));
+       });
+  }
 }
 
 template <typename... Args>
 hep_hpc::hdf5::Ntuple<Args...>::~Ntuple<Args...>() noexcept
 {
+  if (!dd_) { // Moved-from.
+    return;
+  }
+  // Leave the pool before we are dismantled.
+  poolClient_.reset();
   ScopedErrorHandler seh(ErrorMode::HDF5_DEFAULT);
-  if (flush_(iSequence()) != 0) {
+  if (writer_) {
+    try {
+      if (staging_) {
+        writer_->submit();
+      }
+      writer_->wait();
+    }
+    catch (std::exception const & e) {
+      std::cerr << "HDF5 failure while flushing asynchronously: "
+                << e.what() << "\n";
+    }
+    writer_.reset();
+  }
+  int result = 0;
+  if (staging_) {
+    // Completed blocks first, then all partially-filled blocks.
+    result = drain_(*staging_, *dd_, false);
+    for (auto const & block : staging_->blocks) {
+      result |= flush_(block->buffers, *dd_, false, iSequence());
+    }
+    NtupleDetail::threadStagingBlocks().erase(staging_->id);
+  }
+  // Everything, including carried-over rows.
+  if ((flush_(*buffers_, *dd_, true, iSequence()) | result) != 0) {
     std::cerr << "HDF5 failure while flushing.\n";
   }
+  if (!dd_->keyColumns.empty()) {
+    try {
+      detail::writeKeyIndex(dd_->group, dd_->keyColumns, dd_->rowsWritten());
+    }
+    catch (std::exception const & e) {
+      std::cerr << "HDF5 failure while writing key index: "
+                << e.what() << "\n";
+    }
+  }
 }
 
 template <typename... Args>
@@ -567,7 +1182,7 @@ inline
 hep_hpc::hdf5::Group const &
 hep_hpc::hdf5::Ntuple<Args...>::group() const
 {
-  return dd_.group;
+  return dd_->group;
 }
 
 template <typename... Args>
@@ -576,7 +1191,7 @@ auto
 hep_hpc::hdf5::Ntuple<Args...>::datasets() const
 -> std::array<Dataset, nColumns()> const &
 {
-  return dd_.dsets;
+  return dd_->dsets;
 }
 
 template <typename... Args>
@@ -587,60 +1202,735 @@ hep_hpc::hdf5::Ntuple<Args...>::insert(T && ... args)
   static_assert(sizeof...(T) == nColumns(),
                 "Number of arguments to insert() must match nColumns().");
 
+  if (staging_) {
+    insertStaged_(std::forward<T>(args)...);
+    return;
+  }
   using std::get;
-  std::lock_guard<decltype(*mutex_)> lock {*mutex_};
-  if (get<0>(buffers_).size() >= max_[0]) {
-    flush();
+  bool reclaim;
+  {
+    std::lock_guard<decltype(*mutex_)> lock {*mutex_};
+    if (get<0>(*buffers_).size() >= max_[0]) {
+      handoff_();
+    }
+    NtupleDetail::insert<0>(*buffers_, dd_->columns, std::forward<T>(args)...);
+    reclaim = charge_();
+  }
+  if (reclaim) {
+    poolClient_->pool().reclaim();
   }
-  NtupleDetail::insert<0>(buffers_, dd_.columns, std::forward<T>(args)...);
+}
+
+template <typename... Args>
+void
+hep_hpc::hdf5::Ntuple<Args...>::
+insert_columns(std::size_t const nRows,
+               Element_t<Args> const * ... columns)
+{
+  using std::get;
+  if (nRows == 0ull) {
+    return;
+  }
+  auto const bufRows = bufRows_();
+  if (staging_) {
+    // Fill (and release) staging blocks as necessary.
+    for (std::size_t done = 0ull; done != nRows; ) {
+      auto & block = stagingBlock_();
+      auto const nBlock = std::min(nRows - done,
+                                   bufRows - get<0>(block.buffers).size() /
+                                   get<0>(dd_->columns).elementSize());
+      appendColumns_(block.buffers, done, nBlock, iSequence(), columns...);
+      done += nBlock;
+      if (get<0>(block.buffers).size() >= max_[0]) {
+        releaseStagingBlock_();
+        drainStaged_(false);
+      }
+    }
+    return;
+  }
+  bool reclaim;
+  {
+    std::lock_guard<decltype(*mutex_)> lock {*mutex_};
+    if (nRows > bufRows) {
+      // Write what we have, then the new data directly.
+      if (writer_) {
+        writer_->wait();
+      }
+      if (flush_(*buffers_, *dd_, false, iSequence()) != 0 ||
+          writeColumns_(*dd_, nRows, iSequence(), columns...) != 0) {
+        throw std::runtime_error("HDF5 write failure.");
+      }
+      recordHeldBytes_(*dd_, writerBuffers_.get(), iSequence());
+      return;
+    }
+    if (get<0>(*buffers_).size() +
+        nRows * get<0>(dd_->columns).elementSize() > max_[0]) {
+      handoff_();
+    }
+    appendColumns_(*buffers_, 0ull, nRows, iSequence(), columns...);
+    reclaim = charge_();
+  }
+  if (reclaim) {
+    poolClient_->pool().reclaim();
+  }
+}
+
+template <typename... Args>
+void
+hep_hpc::hdf5::Ntuple<Args...>::
+insert_strided(std::size_t const nRows,
+               std::size_t const stride,
+               Element_t<Args> const * ... columns)
+{
+  using std::get;
+  auto const bufRows = bufRows_();
+  auto const rowElements = get<0>(dd_->columns).elementSize();
+  if (staging_) {
+    for (std::size_t done = 0ull; done != nRows; ) {
+      auto & block = stagingBlock_();
+      auto const nBlock = std::min(nRows - done,
+                                   bufRows - get<0>(block.buffers).size() /
+                                   rowElements);
+      appendStrided_(block.buffers, done, nBlock, stride, iSequence(),
+                     columns...);
+      done += nBlock;
+      if (get<0>(block.buffers).size() >= max_[0]) {
+        releaseStagingBlock_();
+        drainStaged_(false);
+      }
+    }
+    return;
+  }
+  bool reclaim;
+  {
+    std::lock_guard<decltype(*mutex_)> lock {*mutex_};
+    for (std::size_t done = 0ull; done != nRows; ) {
+      if (get<0>(*buffers_).size() >= max_[0]) {
+        handoff_();
+      }
+      auto const nBuf = std::min(nRows - done,
+                                 bufRows - get<0>(*buffers_).size() /
+                                 rowElements);
+      appendStrided_(*buffers_, done, nBuf, stride, iSequence(), columns...);
+      done += nBuf;
+    }
+    reclaim = charge_();
+  }
+  if (reclaim) {
+    poolClient_->pool().reclaim();
+  }
+}
+
+template <typename... Args>
+template <size_t... I>
+void
+hep_hpc::hdf5::Ntuple<Args...>::
+appendStrided_(buffers_t & buffers,
+               std::size_t const firstRow,
+               std::size_t const nRows,
+               std::size_t const stride,
+               hep_hpc::detail::index_sequence<I...>,
+               Element_t<Args> const * ... columns) const
+{
+  using std::get;
+  using swallow = int[];
+  (void) swallow {0,
+      (NtupleDetail::append_rows_strided(get<I>(buffers),
+                                         get<I>(dd_->columns),
+                                         (columns == nullptr) ? nullptr :
+                                         reinterpret_cast<Element_t<Args> const *>
+                                         (reinterpret_cast<char const *>(columns) +
+                                          firstRow * stride),
+                                         stride,
+                                         nRows), 0)...};
+}
+
+template <typename... Args>
+template <size_t... I>
+void
+hep_hpc::hdf5::Ntuple<Args...>::
+appendColumns_(buffers_t & buffers,
+               std::size_t const firstRow,
+               std::size_t const nRows,
+               hep_hpc::detail::index_sequence<I...>,
+               Element_t<Args> const * ... columns) const
+{
+  using std::get;
+  using swallow = int[];
+  (void) swallow {0,
+      (NtupleDetail::append_rows(get<I>(buffers),
+                                 get<I>(dd_->columns),
+                                 (columns == nullptr) ? nullptr :
+                                 columns + firstRow *
+                                 get<I>(dd_->columns).elementSize(),
+                                 nRows), 0)...};
 }
 
 template <typename... Args>
 template <size_t... I>
 int
-hep_hpc::hdf5::Ntuple<Args...>::flush_(hep_hpc::detail::index_sequence<I...>)
+hep_hpc::hdf5::Ntuple<Args...>::
+writeColumns_(data_structure_t & dd,
+              std::size_t const nRows,
+              hep_hpc::detail::index_sequence<I...>,
+              Element_t<Args> const * ... columns)
 {
   using std::get;
-  std::lock_guard<decltype(*mutex_)> lock {*mutex_};
+  // Default-constructed data for columns for which none were provided,
+  // or copies of columns of reduced precision, rounded. (N.B. not
+  // std::vector, so as to have an array of bool.)
+  std::tuple<std::unique_ptr<Element_t<Args>[]>...> copies;
+  using swallow = int[];
+  (void) swallow {0,
+      ((columns == nullptr) ?
+       (get<I>(copies).reset(new Element_t<Args>
+                             [nRows * get<I>(dd.columns).elementSize()]()), 0) :
+       0)...};
+  std::tuple<Element_t<Args> const *...> const data
+    {detail::reducedPrecision(get<I>(dd.columns),
+                              (columns == nullptr) ?
+                              get<I>(copies).get() : columns,
+                              nRows * get<I>(dd.columns).elementSize(),
+                              get<I>(copies))...};
+  std::array<void const *, nColumns()> const rowData
+    {{static_cast<void const *>(get<I>(data))...}};
+  if (writeRows_(dd, nRows, hep_hpc::detail::index_sequence<I...>(),
+                 rowData) != 0) {
+    return 1;
+  }
   auto const results =
-    {(herr_t) 0, NtupleDetail::flush_one(get<I>(buffers_),
-                                         get<I>(dd_.dsets),
-                                         get<I>(dd_.columns))...};
+    {0, writeColumn_<I>(dd,
+                        get<I>(data),
+                        nRows,
+                        false)...};
   return std::any_of(std::begin(results),
                      std::end(results),
-                     [](herr_t const res) { return res != 0; });
+                     [](int const res) { return res != 0; }) ||
+    dd.writeStatistics(false) != 0;
+}
+
+template <typename... Args>
+template <typename... T>
+void
+hep_hpc::hdf5::Ntuple<Args...>::insertStaged_(T && ... args)
+{
+  using std::get;
+  auto & block = stagingBlock_();
+  NtupleDetail::insert<0>(block.buffers, dd_->columns, std::forward<T>(args)...);
+  if (get<0>(block.buffers).size() >= max_[0]) {
+    releaseStagingBlock_();
+    drainStaged_(false);
+  }
 }
 
-template <typename BUFFER, typename COL>
+template <typename... Args>
+auto
+hep_hpc::hdf5::Ntuple<Args...>::stagingBlock_()
+-> StagingBlock_ &
+{
+  auto & current = NtupleDetail::threadStagingBlocks()[staging_->id];
+  if (current == nullptr) {
+    current = acquireStagingBlock_();
+  }
+  return *static_cast<StagingBlock_ *>(current);
+}
+
+template <typename... Args>
+auto
+hep_hpc::hdf5::Ntuple<Args...>::acquireStagingBlock_()
+-> StagingBlock_ *
+{
+  // Take all the free blocks (see AtomicStack), keep one and return the
+  // rest.
+  StagingBlock_ * result = staging_->free.takeAll();
+  if (result != nullptr) {
+    if (result->next != nullptr) {
+      auto last = result->next;
+      while (last->next != nullptr) {
+        last = last->next;
+      }
+      staging_->free.pushChain(result->next, last);
+    }
+    result->next = nullptr;
+    return result;
+  }
+  std::unique_ptr<StagingBlock_> block {new StagingBlock_};
+  reserve_(block->buffers, iSequence());
+  result = block.get();
+  std::lock_guard<std::mutex> lock {staging_->blocksMutex};
+  staging_->blocks.emplace_back(std::move(block));
+  return result;
+}
+
+template <typename... Args>
+void
+hep_hpc::hdf5::Ntuple<Args...>::releaseStagingBlock_()
+{
+  auto & current = NtupleDetail::threadStagingBlocks()[staging_->id];
+  if (current != nullptr) {
+    staging_->full.push(static_cast<StagingBlock_ *>(current));
+    current = nullptr;
+  }
+}
+
+template <typename... Args>
+void
+hep_hpc::hdf5::Ntuple<Args...>::drainStaged_(bool const flushAll)
+{
+  if (writer_) {
+    if (flushAll) {
+      staging_->flushAll = true;
+    }
+    writer_->submit();
+    if (flushAll) {
+      writer_->wait();
+    }
+    return;
+  }
+  // If another thread is already draining, it will pick up our
+  // completed block: it checks for new arrivals after it has finished.
+  do {
+    while (staging_->draining.exchange(true)) {
+      if (!flushAll) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    int const result = drain_(*staging_, *dd_, flushAll);
+    staging_->draining = false;
+    if (result != 0) {
+      throw std::runtime_error("HDF5 write failure.");
+    }
+  } while (!staging_->full.empty());
+}
+
+template <typename... Args>
+int
+hep_hpc::hdf5::Ntuple<Args...>::drain_(Staging_ & staging,
+                                      data_structure_t & dd,
+                                      bool const force)
+{
+  int result = 0;
+  while (auto block = detail::reverseChain(staging.full.takeAll())) {
+    while (block != nullptr) {
+      auto const next = block->next;
+      result |= flush_(block->buffers, dd, false, iSequence());
+      // Discard any data we failed to write (error is reported).
+      clear_(block->buffers, iSequence());
+      staging.free.push(block);
+      block = next;
+    }
+  }
+  if (force) {
+    buffers_t none;
+    result |= flush_(none, dd, true, iSequence());
+  }
+  return result;
+}
+
+template <typename... Args>
+template <size_t... I>
+std::size_t
+hep_hpc::hdf5::Ntuple<Args...>::
+rowBytes_(column_info_t const & columns,
+          hep_hpc::detail::index_sequence<I...>)
+{
+  std::size_t result = 0ull;
+  using swallow = int[];
+  (void) swallow {0,
+      (result += sizeof(Element_t<Args>) *
+       std::get<I>(columns).elementSize(), 0)...};
+  return result;
+}
+
+template <typename... Args>
+template <size_t... I>
+void
+hep_hpc::hdf5::Ntuple<Args...>::
+reserve_(buffers_t & buffers,
+         hep_hpc::detail::index_sequence<I...>) const
+{
+  using swallow = int[];
+  (void) swallow {0, (std::get<I>(buffers).reserve(max_[I]), 0)...};
+}
+
+template <typename... Args>
+template <size_t... I>
+void
+hep_hpc::hdf5::Ntuple<Args...>::
+clear_(buffers_t & buffers,
+       hep_hpc::detail::index_sequence<I...>)
+{
+  using swallow = int[];
+  (void) swallow {0, (std::get<I>(buffers).clear(), 0)...};
+}
+
+template <typename... Args>
+template <size_t... I>
+void
+hep_hpc::hdf5::Ntuple<Args...>::
+recordHeldBytes_(data_structure_t & dd,
+                 buffers_t const * const writerBuffers,
+                 hep_hpc::detail::index_sequence<I...>)
+{
+  using std::get;
+  std::size_t result = dd.rowBuffer.capacity();
+  using swallow = int[];
+  (void) swallow {0,
+      (result += detail::capacityBytes(get<I>(dd.carry)) +
+       ((writerBuffers == nullptr) ? 0ull :
+        detail::capacityBytes(get<I>(*writerBuffers))), 0)...};
+  dd.heldBytes = result;
+}
+
+template <typename... Args>
+template <size_t... I>
+std::size_t
+hep_hpc::hdf5::Ntuple<Args...>::
+heldBytes_(data_structure_t const & dd,
+           buffers_t const & buffers,
+           hep_hpc::detail::index_sequence<I...>)
+{
+  // N.B. buffers may be read here, but (in NtupleFlushMode::ASYNC) not
+  // the rest, which the writer thread may be modifying.
+  std::size_t result = dd.heldBytes;
+  using swallow = int[];
+  (void) swallow {0,
+      (result += detail::capacityBytes(std::get<I>(buffers)), 0)...};
+  return result;
+}
+
+template <typename... Args>
+inline
+bool
+hep_hpc::hdf5::Ntuple<Args...>::charge_()
+{
+  return poolClient_ &&
+    poolClient_->charge(heldBytes_(*dd_, *buffers_, iSequence()));
+}
+
+template <typename... Args>
+void
+hep_hpc::hdf5::Ntuple<Args...>::handoff_()
+{
+  if (writer_) {
+    writer_->wait();
+    std::swap(*buffers_, *writerBuffers_);
+    recordHeldBytes_(*dd_, writerBuffers_.get(), iSequence());
+    writer_->submit();
+  } else if (flush_(*buffers_, *dd_, false, iSequence()) != 0) {
+    throw std::runtime_error("HDF5 write failure.");
+  } else {
+    recordHeldBytes_(*dd_, nullptr, iSequence());
+  }
+}
+
+template <typename... Args>
+template <size_t... I>
+int
+hep_hpc::hdf5::Ntuple<Args...>::
+flush_(buffers_t & buffers,
+       data_structure_t & dd,
+       bool const force,
+       hep_hpc::detail::index_sequence<I...>)
+{
+  using std::get;
+  // Only the buffers of columns stored in rows are required here.
+  std::array<void const *, nColumns()> const rowData
+    {{((dd.rowOffsets[I] < 0) ? nullptr :
+       static_cast<void const *>(get<I>(buffers).data()))...}};
+  if (writeRows_(dd, get<0>(buffers).size() / get<0>(dd.columns).elementSize(),
+                 hep_hpc::detail::index_sequence<I...>(), rowData) != 0) {
+    return 1;
+  }
+  auto const results =
+    {0, writeColumn_<I>(dd,
+                        get<I>(buffers).data(),
+                        get<I>(buffers).size() /
+                        get<I>(dd.columns).elementSize(),
+                        force)...};
+  if (std::any_of(std::begin(results),
+                  std::end(results),
+                  [](int const res) { return res != 0; })) {
+    return 1;
+  }
+  clear_(buffers, hep_hpc::detail::index_sequence<I...>());
+  if (dd.writeStatistics(force) != 0 ||
+      (force && dd.trim() != 0)) {
+    return 1;
+  }
+  // Make the rows written visible to SWMR readers.
+  return (dd.swmr && dd.flushDatasets() != 0) ? 1 : 0;
+}
+
+template <typename... Args>
+template <size_t... I>
+int
+hep_hpc::hdf5::Ntuple<Args...>::
+writeRows_(data_structure_t & dd,
+           std::size_t const nRows,
+           hep_hpc::detail::index_sequence<I...>,
+           std::array<void const *, nColumns()> const & data)
+{
+  if (!dd.rows || nRows == 0ull) {
+    return 0;
+  }
+  std::array<std::size_t, nColumns()> const rowBytes
+    {{(sizeof(Element_t<Args>) * std::get<I>(dd.columns).elementSize())...}};
+  dd.rowBuffer.resize(nRows * dd.rowSize);
+  for (std::size_t i = 0; i != nColumns(); ++i) {
+    if (dd.rowOffsets[i] >= 0) {
+      detail::packColumn(dd.rowBuffer.data(), dd.rowSize, dd.rowOffsets[i],
+                         data[i], rowBytes[i], nRows);
+    }
+  }
+  if (detail::writeRows(dd.rows, dd.rowMemType, dd.rowBuffer.data(),
+                        nRows, dd.rowState) != 0) {
+    return 1;
+  }
+  using swallow = int[];
+  (void) swallow {0,
+      ((dd.rowOffsets[I] >= 0) ?
+       std::get<I>(dd.statistics).
+       accumulate(static_cast<Element_t<Args> const *>(data[I]), nRows) :
+       (void) 0, 0)...};
+  return 0;
+}
+
+template <typename... Args>
+template <size_t I, typename T>
+int
+hep_hpc::hdf5::Ntuple<Args...>::
+writeColumn_(data_structure_t & dd,
+             T const * data,
+             std::size_t nRows,
+             bool const force)
+{
+  using std::get;
+  if (dd.rowOffsets[I] >= 0) { // Written by writeRows_().
+    return 0;
+  }
+  auto & carry = get<I>(dd.carry);
+  auto const & col = get<I>(dd.columns);
+  auto const elementSize = col.elementSize();
+  auto & state = dd.state[I];
+  hsize_t const chunkRows = state.chunkRows;
+  hsize_t const & size = state.size;
+  // N.B. the carried-over rows of a string column are char const *.
+  auto const write = [&](auto const * const rows, hsize_t const n)
+    {
+      if (n != 0ull && chunkRows != 0ull && size % chunkRows != 0ull) {
+        // HDF5 must read back (and decompress) the partial chunk.
+        ++dd.chunkRewrites;
+      }
+      herr_t const rc =
+        NtupleDetail::write_rows(get<I>(dd.companions), rows, n,
+                                 get<I>(dd.dsets), col, state);
+      if (rc == 0) {
+        get<I>(dd.statistics).accumulate(rows, n);
+      }
+      return rc;
+    };
+  auto const hold = [&](T const * const rows, std::size_t const n)
+    {
+      NtupleDetail::append_rows(carry, col, rows, n);
+    };
+  hsize_t const carryRows = carry.size() / elementSize;
+  herr_t rc = 0;
+  if (force || !dd.chunkAligned || chunkRows == 0ull) {
+    // Write everything we have.
+    if (carryRows == 0ull) {
+      return write(data, nRows);
+    }
+    hold(data, nRows);
+    if ((rc = write(carry.data(), carry.size() / elementSize)) == 0) {
+      carry.clear();
+    }
+    return rc;
+  }
+  // Write up to the last chunk boundary we can reach.
+  hsize_t const total = size + carryRows + nRows;
+  hsize_t const end = total - total % chunkRows;
+  if (end <= size + carryRows) {
+    hold(data, nRows);
+    return 0;
+  }
+  if (carryRows != 0ull) {
+    // Complete the chunk begun by the carried-over rows.
+    std::size_t const fill = (chunkRows - (size + carryRows) % chunkRows) % chunkRows;
+    hold(data, fill);
+    data += fill * elementSize;
+    nRows -= fill;
+    if ((rc = write(carry.data(), carry.size() / elementSize)) != 0) {
+      return rc;
+    }
+    carry.clear();
+  }
+  std::size_t const nWrite = end - size;
+  if ((rc = write(data, nWrite)) == 0) {
+    hold(data + nWrite * elementSize, nRows - nWrite);
+  }
+  return rc;
+}
+
+template <typename T, typename COL, typename U>
+inline
+void
+hep_hpc::hdf5::NtupleDetail::
+append_rows(std::vector<T> & buf, COL const & col,
+            U const * const data,
+            std::size_t const nRows)
+{
+  auto const nElements = nRows * col.elementSize();
+  if (data != nullptr) {
+    buf.insert(buf.end(), data, data + nElements);
+    detail::reducePrecision(col, buf.data() + buf.size() - nElements, nElements);
+  } else { // Insert empty
+    buf.resize(buf.size() + nElements);
+  }
+}
+
+template <typename COL, typename U>
+inline
+void
+hep_hpc::hdf5::NtupleDetail::
+append_rows(detail::StringArena & buf, COL const & col,
+            U const * const data,
+            std::size_t const nRows)
+{
+  buf.append(data, nRows * col.elementSize());
+}
+
+template <typename T, typename COL, typename U>
+inline
+void
+hep_hpc::hdf5::NtupleDetail::
+append_rows_strided(std::vector<T> & buf, COL const & col,
+                    U const * const data,
+                    std::size_t const stride,
+                    std::size_t const nRows)
+{
+  auto const nElements = col.elementSize();
+  auto const first = buf.size();
+  buf.resize(first + nRows * nElements);
+  if (data == nullptr) {
+    return;
+  }
+  auto const in = reinterpret_cast<char const *>(data);
+  auto const out = buf.data() + first;
+  if (nElements == 1ull) {
+    for (std::size_t i = 0; i != nRows; ++i) {
+      out[i] = *reinterpret_cast<U const *>(in + i * stride);
+    }
+  } else {
+    for (std::size_t i = 0; i != nRows; ++i) {
+      std::copy_n(reinterpret_cast<U const *>(in + i * stride),
+                  nElements,
+                  out + i * nElements);
+    }
+  }
+  detail::reducePrecision(col, out, nRows * nElements);
+}
+
+template <typename COL, typename U>
+inline
+void
+hep_hpc::hdf5::NtupleDetail::
+append_rows_strided(detail::StringArena & buf, COL const & col,
+                    U const * const data,
+                    std::size_t const stride,
+                    std::size_t const nRows)
+{
+  if (data == nullptr) {
+    buf.append(data, nRows * col.elementSize());
+    return;
+  }
+  auto const in = reinterpret_cast<char const *>(data);
+  for (std::size_t i = 0; i != nRows; ++i) {
+    buf.append(reinterpret_cast<U const *>(in + i * stride),
+               col.elementSize());
+  }
+}
+
+template <typename T, typename COL>
+inline
+void
+hep_hpc::hdf5::NtupleDetail::
+append_rows(detail::JaggedBuffer<T> & buf, COL const &,
+            jagged_span<T> const * const data,
+            std::size_t const nRows)
+{
+  buf.append(data, nRows);
+}
+
+template <typename T, typename COL>
+inline
+void
+hep_hpc::hdf5::NtupleDetail::
+append_rows_strided(detail::JaggedBuffer<T> & buf, COL const &,
+                    jagged_span<T> const * const data,
+                    std::size_t const stride,
+                    std::size_t const nRows)
+{
+  if (data == nullptr) {
+    buf.append(data, nRows);
+    return;
+  }
+  auto const in = reinterpret_cast<char const *>(data);
+  for (std::size_t i = 0; i != nRows; ++i) {
+    buf.append(reinterpret_cast<jagged_span<T> const *>(in + i * stride), 1ull);
+  }
+}
+
+template <typename T, typename COL>
 herr_t
 hep_hpc::hdf5::NtupleDetail::
-flush_one(BUFFER & buf, Dataset & dset, COL const & col)
+write_rows(T const * const data, hsize_t const nRows,
+           Dataset & dset, COL const & col,
+           detail::ColumnWriteState & state)
 {
-  using std::get;
   herr_t rc = -1;
-  // Obtain the current dataspace for this dataset.
-  auto dspace = Dataspace{ErrorController::call(&H5Dget_space, dset)};
+  if (nRows == 0ull) { // Nothing to do.
+    return 0;
+  }
   std::array<hsize_t, COL::nDims() + 1ull>
-    filedims, filemaxdims, offsets {0}, nElements, blockCount;
+    filedims, offsets {0}, nElements, blockCount;
   blockCount.fill(1);
-  if (H5Sget_simple_extent_dims(dspace, filedims.data(), filemaxdims.data()) !=
-      static_cast<int>(COL::nDims() + 1ull)) {
-    return rc;
-  }
-  nElements[0] = buf.size() / col.elementSize();
+  nElements[0] = nRows;
   std::copy(col.dims(), col.dims() + col.nDims(), std::begin(nElements) + 1ull);
-  offsets[0] = filedims[0];
-  // Extend long dimension.
-  filedims[0] += nElements[0];
-  // Update dataset.
-  if ((rc = ErrorController::call(&H5Dset_extent,dset, filedims.data())) != 0) {
-    return rc;
+  hsize_t const newSize = state.size + nRows;
+  if (newSize > state.extent) {
+    // Extend long dimension (see detail::nextExtent()).
+    filedims = nElements;
+    filedims[0] = detail::nextExtent(state, newSize);
+    // Update dataset.
+    if ((rc = ErrorController::call(&H5Dset_extent, dset, filedims.data())) != 0) {
+      return rc;
+    }
+    state.extent = filedims[0];
+    // Need to get fresh dataspace info after updating dataset.
+    state.fileSpace = Dataspace{ErrorController::call(&H5Dget_space, dset)};
   }
-  // Need to get fresh dataspace info after updating dataset.
-  dspace = Dataspace{ErrorController::call(&H5Dget_space, dset)};
+  if (state.compressors != nullptr &&
+      state.size % state.chunkRows == 0ull &&
+      nRows >= state.chunkRows) {
+    // Compress and write whole chunks ourselves.
+    hsize_t const nDirect = nRows - nRows % state.chunkRows;
+    if ((rc = detail::writeChunksDirect(dset, state, data, nDirect,
+                                        sizeof(T) * col.elementSize())) != 0) {
+      return rc;
+    }
+    state.size += nDirect;
+    if (nDirect == nRows) {
+      return 0;
+    }
+    return write_rows(data + nDirect * col.elementSize(),
+                      nRows - nDirect, dset, col, state);
+  }
+  offsets[0] = state.size;
   // Data selection for write.
   if ((rc = ErrorController::call(&H5Sselect_hyperslab,
-                                  dspace,
+                                  state.fileSpace,
                                   H5S_SELECT_SET,
                                   offsets.data(),
                                   nullptr,
@@ -648,14 +1938,21 @@ flush_one(BUFFER & buf, Dataset & dset, COL const & col)
                                   nElements.data())) != 0) {
     return rc;
   }
+  if (state.memRows != nRows) {
+    state.memSpace = Dataspace{int (col.nDims() + 1ull),
+                               nElements.data(),
+                               nElements.data()};
+    state.memRows = nRows;
+  }
   // Write the data.
-  if ((rc = dset.write(col.engine_type(TranslationMode::NONE),
-                       buf.data(),
-                       Dataspace{int (col.nDims() + 1ull),
-                           nElements.data(),
-                           nElements.data()},
-                       std::move(dspace))) == 0) {
-    buf.clear(); // Clear the buffer.
+  if ((rc = ErrorController::call(&H5Dwrite,
+                                  dset,
+                                  col.engine_type(TranslationMode::NONE),
+                                  state.memSpace,
+                                  state.fileSpace,
+                                  H5P_DEFAULT,
+                                  data)) == 0) {
+    state.size = newSize;
   }
   return rc;
 }
@@ -664,52 +1961,94 @@ template <typename COL>
 inline
 herr_t
 hep_hpc::hdf5::NtupleDetail::
-flush_one(std::vector<std::string> & buf,
-          Dataset & dset,
-          COL const & col)
+write_rows(std::string const * const data, hsize_t const nRows,
+           Dataset & dset, COL const & col,
+           detail::ColumnWriteState & state)
 {
-  herr_t rc = -1;
   std::vector<char const *> cbuf;
-  cbuf.reserve(buf.size());
-  std::transform(buf.cbegin(), buf.cend(),
+  cbuf.reserve(nRows * col.elementSize());
+  std::transform(data, data + nRows * col.elementSize(),
                  std::back_insert_iterator<std::vector<char const *> >(cbuf),
                  [](std::string const & s) { return s.data(); });
-  rc = flush_one(cbuf, dset, col);
-  if (rc == 0) {
-    buf.clear();
-  }
-  return rc;
+  return write_rows(cbuf.data(), nRows, dset, col, state);
 }
 
-template <int SZ, typename COL>
+template <typename T, typename COL>
 inline
 herr_t
 hep_hpc::hdf5::NtupleDetail::
-flush_one(std::vector<std::array<char, SZ> > & buf,
-          Dataset & dset,
-          COL const & col)
+write_rows(detail::NoCompanion &,
+           T const * const data, hsize_t const nRows,
+           Dataset & dset, COL const & col,
+           detail::ColumnWriteState & state)
 {
-  herr_t rc = -1;
-  std::vector<char const *> cbuf;
-  cbuf.reserve(buf.size());
-  std::transform(buf.cbegin(), buf.cend(),
-                 std::back_insert_iterator<std::vector<char const *> >(cbuf),
-                 [](std::array<char, SZ> const & s) { return s.data(); });
-  rc = flush_one(cbuf, dset, col);
-  if (rc == 0) {
-    buf.clear();
+  return write_rows(data, nRows, dset, col, state);
+}
+
+template <typename T, typename COL>
+herr_t
+hep_hpc::hdf5::NtupleDetail::
+write_rows(detail::StringDictionary & dictionary,
+           T const * const data, hsize_t const nRows,
+           Dataset & dset, COL const & col,
+           detail::ColumnWriteState & state)
+{
+  if (nRows == 0ull) {
+    return 0;
   }
-  return rc;
+  // Write any new strings first, so that every code on file is defined.
+  auto const & codes = dictionary.encode(data, nRows * col.elementSize());
+  herr_t const rc = dictionary.write();
+  return (rc != 0) ? rc : write_rows(codes.data(), nRows, dset, col, state);
+}
+
+template <typename T, typename COL>
+herr_t
+hep_hpc::hdf5::NtupleDetail::
+write_rows(detail::JaggedValues<T> & values,
+           jagged_span<T> const * const data, hsize_t const nRows,
+           Dataset & dset, COL const & col,
+           detail::ColumnWriteState & state)
+{
+  if (nRows == 0ull) {
+    return 0;
+  }
+  // Values first, so that every offset on file is valid.
+  herr_t const rc = values.write(data, nRows);
+  return (rc != 0) ? rc :
+    write_rows(values.offsets().data(), nRows, dset, col, state);
+}
+
+template <typename B, typename COL>
+inline
+herr_t
+hep_hpc::hdf5::NtupleDetail::
+write_rows(detail::BitPacker & packer,
+           B const * const data, hsize_t const nRows,
+           Dataset & dset, COL const &,
+           detail::ColumnWriteState & state)
+{
+  return write_rows(packer.pack(data, nRows), nRows, dset,
+                    packer.packed(), state);
 }
 
 template <typename... Args>
 void
 hep_hpc::hdf5::Ntuple<Args...>::flush()
 {
-  // No lock here -- lock held by flush_();
-  if (flush_(iSequence()) != 0) {
+  if (staging_) {
+    releaseStagingBlock_();
+    drainStaged_(true);
+    return;
+  }
+  std::lock_guard<decltype(*mutex_)> lock {*mutex_};
+  if (writer_) {
+    writer_->wait();
+  }
+  if (flush_(*buffers_, *dd_, true, iSequence()) != 0) {
     throw std::runtime_error("HDF5 write failure.");
   }
+  recordHeldBytes_(*dd_, writerBuffers_.get(), iSequence());
 }
 
 template <size_t I, typename TUPLE, typename COLS, typename... Tail>
@@ -734,23 +2073,7 @@ insert(TUPLE & buffers,
        Tail && ... tail)
 {
   using std::get;
-  auto & col = get<I>(cols);
-  auto & buffer = get<I>(buffers);
-  if (head != nullptr) {
-    buffer.insert(buffer.end(),
-                  head,
-                  head + col.elementSize());
-  } else { // Insert empty
-#pragma GCC diagnostic push
-#if (defined __GNUC__) && ! GCC_IS_AT_LEAST(5,0,0)
-    // Overaggressive warning with GCC < 5.0
-    // (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=36750,
-    // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=61489).
-    _Pragma("GCC diagnostic ignored \"-Wmissing-field-initializers\"")
-#endif
-    buffer.insert(buffer.end(), col.elementSize(), {});
-#pragma GCC diagnostic pop
-  }
+  append_rows(get<I>(buffers), get<I>(cols), head, 1ull);
   insert<I + 1>(buffers, cols, std::forward<Tail>(tail)...);
 }
 
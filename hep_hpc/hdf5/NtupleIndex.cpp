@@ -0,0 +1,276 @@
+#include "hep_hpc/hdf5/NtupleIndex.hpp"
+
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/Datatype.hpp"
+#include "hep_hpc/hdf5/Resource.hpp"
+#include "hep_hpc/hdf5/detail/KeyIndex.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace {
+  using hep_hpc::hdf5::ErrorController;
+
+  hep_hpc::hdf5::Resource openAttribute(hid_t const object,
+                                        char const * const name)
+  {
+    return hep_hpc::hdf5::Resource(ErrorController::call(&H5Aopen, object,
+                                                         name, H5P_DEFAULT),
+                                   &H5Aclose);
+  }
+
+  std::uint64_t readCount(hid_t const object, char const * const name)
+  {
+    std::uint64_t result = 0ull;
+    auto const attr = openAttribute(object, name);
+    ErrorController::call(&H5Aread, *attr, H5T_NATIVE_UINT64, &result);
+    return result;
+  }
+
+  // A scalar (one-element) fixed-length string attribute.
+  std::string readString(hid_t const object, char const * const name)
+  {
+    auto const attr = openAttribute(object, name);
+    hep_hpc::hdf5::Datatype const
+      dtype(ErrorController::call(&H5Aget_type, *attr));
+    std::string result(H5Tget_size(dtype), '\0');
+    ErrorController::call(&H5Aread, *attr, dtype, &result[0]);
+    result.resize(result.find('\0'));
+    return result;
+  }
+
+  // A variable-length string array attribute.
+  std::vector<std::string> readStrings(hid_t const object,
+                                       char const * const name)
+  {
+    auto const attr = openAttribute(object, name);
+    hep_hpc::hdf5::Dataspace const
+      space(ErrorController::call(&H5Aget_space, *attr));
+    std::vector<char *> values(H5Sget_simple_extent_npoints(space));
+    hep_hpc::hdf5::Datatype const
+      dtype(ErrorController::call(&H5Tcopy, H5T_C_S1));
+    H5Tset_size(dtype, H5T_VARIABLE);
+    ErrorController::call(&H5Aread, *attr, dtype, values.data());
+    std::vector<std::string> result;
+    for (auto const value : values) {
+      result.emplace_back(value);
+      H5free_memory(value);
+    }
+    return result;
+  }
+
+  // Read rows [first, first + nRows) of the two-dimensional dataset of
+  // keys.
+  std::vector<long long> readKeys(hep_hpc::hdf5::Dataset & dset,
+                                  hsize_t const first,
+                                  hsize_t const nRows,
+                                  std::size_t const nKeys)
+  {
+    std::vector<long long> result(nRows * nKeys);
+    hep_hpc::hdf5::Dataspace
+      fileSpace(ErrorController::call(&H5Dget_space, dset));
+    hsize_t const offsets[2] {first, 0ull}, counts[2] {nRows, nKeys};
+    ErrorController::call(&H5Sselect_hyperslab, fileSpace, H5S_SELECT_SET,
+                          offsets, nullptr, counts, nullptr);
+    dset.read(H5T_NATIVE_LLONG, result.data(),
+              hep_hpc::hdf5::Dataspace{2, counts, counts},
+              std::move(fileSpace));
+    return result;
+  }
+
+  // Compare the leading part of key with prefix.
+  int comparePrefix(long long const * const key,
+                    std::vector<long long> const & prefix)
+  {
+    for (std::size_t k = 0; k != prefix.size(); ++k) {
+      if (key[k] != prefix[k]) {
+        return (key[k] < prefix[k]) ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+}
+
+hep_hpc::hdf5::NtupleIndex::
+NtupleIndex(std::string const & filename,
+            std::string const & tablename)
+  : NtupleIndex(File(filename), tablename)
+{
+}
+
+hep_hpc::hdf5::NtupleIndex::
+NtupleIndex(File file,
+            std::string const & tablename)
+  : file_(std::move(file)),
+    table_(file_, tablename, Group::OPEN_MODE),
+    index_()
+{
+  // Cause an exception to be thrown if we have an HDF5 issue.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  if (H5Lexists(table_, detail::KEY_INDEX_GROUP, H5P_DEFAULT) <= 0) {
+    throw std::runtime_error("Ntuple " + tablename + " has no key index.");
+  }
+  index_ = Group(table_, detail::KEY_INDEX_GROUP, Group::OPEN_MODE);
+  keyColumns_ = readStrings(index_, "columns");
+  rows_ = readCount(index_, "nRows");
+  sparse_ = (readString(index_, "layout") == "sparse");
+  if (sparse_) {
+    blockRows_ = readCount(index_, "blockRows");
+    hsize_t const nBlocks = (rows_ + blockRows_ - 1ull) / blockRows_;
+    if (nBlocks != 0ull) {
+      Dataset first(index_, "first"), last(index_, "last");
+      first_ = readKeys(first, 0ull, nBlocks, keyColumns_.size());
+      last_ = readKeys(last, 0ull, nBlocks, keyColumns_.size());
+    }
+  } else if (rows_ != 0ull) {
+    keys_ = openDatasetWithChunkCache(index_, "keys", ChunkAccess::RANDOM,
+                                      keysCache_);
+    rowNumbers_ = openDatasetWithChunkCache(index_, "rows",
+                                            ChunkAccess::SEQUENTIAL,
+                                            rowNumbersCache_);
+  }
+}
+
+std::vector<std::pair<hsize_t, hsize_t> >
+hep_hpc::hdf5::NtupleIndex::
+lookup(std::vector<long long> const & key) const
+{
+  if (key.size() > keyColumns_.size()) {
+    throw std::runtime_error("Key has more components than key columns.");
+  }
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  std::vector<std::pair<hsize_t, hsize_t> > result;
+  if (rows_ == 0ull) {
+    return result;
+  }
+  if (sparse_) {
+    auto const range = lookupSparse_(key);
+    if (range.first != range.second) {
+      result.push_back(range);
+    }
+    return result;
+  }
+  hsize_t const lo = denseBound_(key, false), hi = denseBound_(key, true);
+  if (lo == hi) {
+    return result;
+  }
+  // Row numbers of the matching keys, coalesced into ranges.
+  std::vector<std::uint64_t> rowNumbers(hi - lo);
+  Dataspace fileSpace(ErrorController::call(&H5Dget_space, rowNumbers_));
+  hsize_t const count = hi - lo;
+  ErrorController::call(&H5Sselect_hyperslab, fileSpace, H5S_SELECT_SET,
+                        &lo, nullptr, &count, nullptr);
+  rowNumbers_.read(H5T_NATIVE_UINT64, rowNumbers.data(),
+                   Dataspace{1, &count, &count}, std::move(fileSpace));
+  std::sort(rowNumbers.begin(), rowNumbers.end());
+  for (auto const row : rowNumbers) {
+    if (!result.empty() && result.back().second == row) {
+      ++result.back().second;
+    } else {
+      result.emplace_back(row, row + 1ull);
+    }
+  }
+  return result;
+}
+
+std::pair<hsize_t, hsize_t>
+hep_hpc::hdf5::NtupleIndex::
+lookupSparse_(std::vector<long long> const & key) const
+{
+  std::size_t const nKeys = keyColumns_.size();
+  hsize_t const nBlocks = first_.size() / nKeys;
+  // Blocks [bLo, bHi) may hold matching rows: those whose last key is
+  // not less than key, and whose first key is not greater.
+  hsize_t bLo = 0ull, bHi = nBlocks;
+  {
+    hsize_t lo = 0ull, hi = nBlocks;
+    while (lo < hi) {
+      hsize_t const mid = lo + (hi - lo) / 2ull;
+      if (comparePrefix(&last_[mid * nKeys], key) < 0) {
+        lo = mid + 1ull;
+      } else {
+        hi = mid;
+      }
+    }
+    bLo = lo;
+    hi = nBlocks;
+    while (lo < hi) {
+      hsize_t const mid = lo + (hi - lo) / 2ull;
+      if (comparePrefix(&first_[mid * nKeys], key) <= 0) {
+        lo = mid + 1ull;
+      } else {
+        hi = mid;
+      }
+    }
+    bHi = lo;
+  }
+  if (bLo >= bHi) {
+    return {0ull, 0ull};
+  }
+  // Since the rows are in key order, those of blocks strictly between
+  // bLo and bHi - 1 all match: only the two end blocks need refining
+  // from the key columns.
+  auto const readBlock = [this, nKeys](hsize_t const block)
+    {
+      hsize_t const first = block * blockRows_;
+      hsize_t const n = std::min(rows_, first + blockRows_) - first;
+      std::vector<std::vector<long long> > columns(nKeys);
+      for (std::size_t k = 0; k != nKeys; ++k) {
+        columns[k].resize(n);
+        if (detail::readKeyColumn(table_, keyColumns_[k], first, n,
+                                  columns[k].data()) != 0) {
+          throw std::runtime_error("Unable to read key column " +
+                                   keyColumns_[k] + ".");
+        }
+      }
+      // Transpose to row-wise keys.
+      std::vector<long long> result(n * nKeys);
+      for (hsize_t i = 0ull; i != n; ++i) {
+        for (std::size_t k = 0; k != nKeys; ++k) {
+          result[i * nKeys + k] = columns[k][i];
+        }
+      }
+      return result;
+    };
+  auto const bound = [&key, nKeys](std::vector<long long> const & keys,
+                                   bool const upper)
+    {
+      hsize_t lo = 0ull, hi = keys.size() / nKeys;
+      while (lo < hi) {
+        hsize_t const mid = lo + (hi - lo) / 2ull;
+        int const c = comparePrefix(&keys[mid * nKeys], key);
+        if (upper ? c <= 0 : c < 0) {
+          lo = mid + 1ull;
+        } else {
+          hi = mid;
+        }
+      }
+      return lo;
+    };
+  auto const keysLo = readBlock(bLo);
+  hsize_t const begin = bLo * blockRows_ + bound(keysLo, false);
+  hsize_t const end = (bHi - 1ull) * blockRows_ +
+    bound((bHi - 1ull == bLo) ? keysLo : readBlock(bHi - 1ull), true);
+  return {begin, std::max(begin, end)};
+}
+
+hsize_t
+hep_hpc::hdf5::NtupleIndex::
+denseBound_(std::vector<long long> const & key, bool const upper) const
+{
+  std::size_t const nKeys = keyColumns_.size();
+  hsize_t lo = 0ull, hi = rows_;
+  while (lo < hi) {
+    hsize_t const mid = lo + (hi - lo) / 2ull;
+    auto const probe = readKeys(keys_, mid, 1ull, nKeys);
+    int const c = comparePrefix(probe.data(), key);
+    if (upper ? c <= 0 : c < 0) {
+      lo = mid + 1ull;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
@@ -0,0 +1,115 @@
+#ifndef hep_hpc_hdf5_NtupleIndex_hpp
+#define hep_hpc_hdf5_NtupleIndex_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::NtupleIndex
+//
+// Find the rows of an Ntuple (see hep_hpc/hdf5/Ntuple.hpp) with a given
+// key using the index written when it was closed (see
+// NtupleOptions::setKeyColumns()), without scanning the table:
+//
+//   NtupleIndex index("data.hdf5", "events"); // Key: run, subrun, event.
+//   for (auto const & range : index.lookup({run, subrun, event})) {
+//     // Read rows [range.first, range.second) of the columns of interest.
+//   }
+//
+////////////////////////////////////
+// Interface.
+//
+// NtupleIndex(std::string const & filename, std::string const & tablename);
+// NtupleIndex(File file, std::string const & tablename);
+//
+//   Open the key index of table tablename (an exception is thrown if
+//   there is none). If filename is provided, the file is opened
+//   read-only.
+//
+// std::vector<std::string> const & keyColumns() const;
+//
+//   The names of the key columns, in order of significance.
+//
+// bool sparse() const;
+//
+//   Whether the table is in key order, so that the index holds only the
+//   first and last keys of each block of rows (see
+//   hep_hpc/hdf5/detail/KeyIndex.hpp). Any rows with a given key are
+//   then contiguous.
+//
+// hsize_t rows() const;
+//
+//   The number of rows indexed.
+//
+// std::vector<std::pair<hsize_t, hsize_t> >
+// lookup(std::vector<long long> const & key) const;
+//
+//   The ranges [first, second) of rows, in ascending order, whose key
+//   matches the specified key or leading part of a key (e.g. {run} or
+//   {run, subrun}). A sparse index yields at most one range, found by a
+//   binary search of the blocks in memory followed by reading the key
+//   columns of at most two blocks; a dense one, by binary searches of
+//   the sorted keys on file followed by reading the matching row
+//   numbers. The sorted keys are read with a chunk cache sized for
+//   random access (see hep_hpc/hdf5/ChunkCache.hpp), so that the later
+//   steps of each search, and successive lookups of nearby keys, need
+//   not read and decompress their chunks again.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/ChunkCache.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/Group.hpp"
+
+#include "hdf5.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    class NtupleIndex;
+  }
+}
+
+class hep_hpc::hdf5::NtupleIndex {
+public:
+  NtupleIndex(std::string const & filename, std::string const & tablename);
+
+  NtupleIndex(File file, std::string const & tablename);
+
+  std::vector<std::string> const & keyColumns() const { return keyColumns_; }
+  bool sparse() const { return sparse_; }
+  hsize_t rows() const { return rows_; }
+
+  std::vector<std::pair<hsize_t, hsize_t> >
+  lookup(std::vector<long long> const & key) const;
+
+private:
+  // Sparse index: the range of rows matching key.
+  std::pair<hsize_t, hsize_t>
+  lookupSparse_(std::vector<long long> const & key) const;
+
+  // Dense index: the first position in the sorted keys at which key
+  // compares greater than (if upper) or not less than the key there.
+  hsize_t denseBound_(std::vector<long long> const & key, bool upper) const;
+
+  File file_;
+  Group table_;
+  Group index_;
+  std::vector<std::string> keyColumns_ {};
+  bool sparse_ {false};
+  hsize_t rows_ {0ull};
+  // Sparse only.
+  hsize_t blockRows_ {0ull};
+  std::vector<long long> first_ {};
+  std::vector<long long> last_ {};
+  // Dense only.
+  ChunkCacheReservation keysCache_ {};
+  ChunkCacheReservation rowNumbersCache_ {};
+  mutable Dataset keys_ {};
+  mutable Dataset rowNumbers_ {};
+};
+
+#endif /* hep_hpc_hdf5_NtupleIndex_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
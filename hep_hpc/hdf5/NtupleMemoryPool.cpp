@@ -0,0 +1,78 @@
+#include "hep_hpc/hdf5/NtupleMemoryPool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+std::shared_ptr<hep_hpc::hdf5::NtupleMemoryPool>
+hep_hpc::hdf5::NtupleMemoryPool::create(std::size_t const capacity,
+                                        Policy const policy)
+{
+  return std::shared_ptr<NtupleMemoryPool>(new NtupleMemoryPool(capacity, policy));
+}
+
+hep_hpc::hdf5::NtupleMemoryPool::
+NtupleMemoryPool(std::size_t const capacity, Policy const policy)
+  : capacity_(capacity), policy_(policy)
+{
+}
+
+std::unique_ptr<hep_hpc::hdf5::NtupleMemoryPool::Client>
+hep_hpc::hdf5::NtupleMemoryPool::enroll(std::function<void(Client &)> release)
+{
+  std::unique_ptr<Client> result(new Client(shared_from_this(), std::move(release)));
+  std::lock_guard<std::mutex> lock(mutex_);
+  clients_.push_back(result.get());
+  return result;
+}
+
+void
+hep_hpc::hdf5::NtupleMemoryPool::reclaim()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (usage_ <= capacity_) { // Already done by another thread.
+    return;
+  }
+  // Candidates in order of preference, each flushed at most once. N.B.
+  // clients may charge concurrently, so they are sorted by a snapshot
+  // of their size (largest first) or last use (oldest first).
+  std::vector<std::pair<std::uint64_t, Client *> > victims;
+  victims.reserve(clients_.size());
+  for (auto const client : clients_) {
+    if (client->bytes_ != 0ull) {
+      victims.emplace_back((policy_ == Policy::LARGEST) ?
+                           client->bytes_.load() :
+                           client->lastUse_.load(), client);
+    }
+  }
+  if (policy_ == Policy::LARGEST) {
+    std::sort(victims.begin(), victims.end(),
+              [](auto const & left, auto const & right)
+              { return left.first > right.first; });
+  } else {
+    std::sort(victims.begin(), victims.end(),
+              [](auto const & left, auto const & right)
+              { return left.first < right.first; });
+  }
+  for (auto const & victim : victims) {
+    if (usage_ <= capacity_) {
+      break;
+    }
+    victim.second->release_(*victim.second);
+    ++forcedFlushes_;
+  }
+}
+
+hep_hpc::hdf5::NtupleMemoryPool::Client::
+Client(std::shared_ptr<NtupleMemoryPool> pool,
+       std::function<void(Client &)> release)
+  : pool_(std::move(pool)), release_(std::move(release))
+{
+}
+
+hep_hpc::hdf5::NtupleMemoryPool::Client::~Client()
+{
+  auto & pool = *pool_;
+  std::lock_guard<std::mutex> lock(pool.mutex_);
+  pool.clients_.erase(std::find(pool.clients_.begin(), pool.clients_.end(), this));
+  pool.usage_ -= bytes_;
+}
@@ -0,0 +1,150 @@
+#ifndef hep_hpc_hdf5_NtupleMemoryPool_hpp
+#define hep_hpc_hdf5_NtupleMemoryPool_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::NtupleMemoryPool
+//
+// A process-wide ceiling on the memory used by the buffers of any
+// number of Ntuples (see hep_hpc/hdf5/Ntuple.hpp). Ntuples created with
+// a pool (NtupleOptions::setMemoryPool()) allocate buffer memory only
+// as rows are inserted, and report the bytes they hold to the pool. If
+// an insertion takes the total over the pool's capacity, the pool
+// forces flushes of (and releases the memory held by) other Ntuples,
+// or the inserting one, chosen according to its policy, until the
+// total is once again within capacity. Idle Ntuples therefore need not
+// hold on to memory that busy ones could use, and the peak memory used
+// by buffers is bounded without having to shrink each one's bufsize.
+//
+// Forced flushes are performed by the thread whose insertion crossed
+// the capacity, and are equivalent to Ntuple::flush().
+//
+////////////////////////////////////
+// Interface.
+//
+// static std::shared_ptr<NtupleMemoryPool>
+// create(std::size_t capacity, Policy policy = Policy::LARGEST);
+//
+//   Create a pool with a ceiling of capacity bytes, to be shared by
+//   the Ntuples using it.
+//
+// enum class Policy
+//
+//   * LARGEST: flush the Ntuples holding the most memory first.
+//
+//   * LEAST_RECENTLY_USED: flush the Ntuples least recently inserted
+//     into first.
+//
+// std::size_t capacity() const;
+// std::size_t usage() const;
+//
+//   The ceiling, and the total number of bytes currently held by all
+//   Ntuples using the pool.
+//
+// std::size_t forcedFlushes() const;
+//
+//   The number of flushes forced by the pool to date.
+//
+////////////////////////////////////////////////////////////////////////
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    class NtupleMemoryPool;
+  }
+}
+
+class hep_hpc::hdf5::NtupleMemoryPool :
+  public std::enable_shared_from_this<NtupleMemoryPool> {
+public:
+  enum class Policy : uint8_t { LARGEST, LEAST_RECENTLY_USED };
+
+  static std::shared_ptr<NtupleMemoryPool>
+  create(std::size_t capacity, Policy policy = Policy::LARGEST);
+
+  std::size_t capacity() const { return capacity_; }
+  std::size_t usage() const { return usage_; }
+  std::size_t forcedFlushes() const { return forcedFlushes_; }
+
+  // Membership of the pool, held by an Ntuple. Unregisters on
+  // destruction.
+  class Client;
+
+  // Register a client, whose memory is released on demand by calling
+  // release (which must report the bytes then held via
+  // Client::charge()).
+  std::unique_ptr<Client> enroll(std::function<void(Client &)> release);
+
+  // Force flushes until usage() is within capacity() (or there is
+  // nothing left to flush). Must not be called with any lock held that
+  // a client's release function takes.
+  void reclaim();
+
+  NtupleMemoryPool(NtupleMemoryPool const &) = delete;
+  NtupleMemoryPool & operator = (NtupleMemoryPool const &) = delete;
+
+private:
+  NtupleMemoryPool(std::size_t capacity, Policy policy);
+
+  std::size_t const capacity_;
+  Policy const policy_;
+  std::atomic<std::size_t> usage_ {0ull};
+  std::atomic<std::size_t> forcedFlushes_ {0ull};
+  // Insertion clock for Policy::LEAST_RECENTLY_USED.
+  std::atomic<std::uint64_t> clock_ {0ull};
+  // Serializes registration and reclamation.
+  std::mutex mutex_ {};
+  std::vector<Client *> clients_ {};
+};
+
+class hep_hpc::hdf5::NtupleMemoryPool::Client {
+public:
+  ~Client();
+
+  // Report the number of bytes now held by the client. Returns true if
+  // the pool is over capacity, in which case the caller should call
+  // pool().reclaim() (see above).
+  bool charge(std::size_t bytes);
+
+  NtupleMemoryPool & pool() const { return *pool_; }
+
+  Client(Client const &) = delete;
+  Client & operator = (Client const &) = delete;
+
+private:
+  friend class NtupleMemoryPool;
+
+  Client(std::shared_ptr<NtupleMemoryPool> pool,
+         std::function<void(Client &)> release);
+
+  std::shared_ptr<NtupleMemoryPool> const pool_;
+  std::function<void(Client &)> const release_;
+  std::atomic<std::size_t> bytes_ {0ull};
+  std::atomic<std::uint64_t> lastUse_ {0ull};
+};
+
+inline
+bool
+hep_hpc::hdf5::NtupleMemoryPool::Client::charge(std::size_t const bytes)
+{
+  auto & pool = *pool_;
+  auto const old = bytes_.exchange(bytes, std::memory_order_relaxed);
+  if (bytes != old) {
+    // N.B. modular arithmetic takes care of shrinkage.
+    pool.usage_ += bytes - old;
+  }
+  if (pool.policy_ == Policy::LEAST_RECENTLY_USED) {
+    lastUse_.store(++pool.clock_, std::memory_order_relaxed);
+  }
+  return bytes > old && pool.usage_ > pool.capacity_;
+}
+
+#endif /* hep_hpc_hdf5_NtupleMemoryPool_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,352 @@
+#ifndef hep_hpc_hdf5_NtupleOptions_hpp
+#define hep_hpc_hdf5_NtupleOptions_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::NtupleOptions
+//
+// A small value class collecting the non-column-specific settings
+// controlling the behavior of an hep_hpc::hdf5::Ntuple (see
+// hep_hpc/hdf5/Ntuple.hpp). It may be provided to an Ntuple
+// constructor or to hep_hpc::hdf5::NtupleInitializer (see
+// hep_hpc/hdf5/make_ntuple.hpp) in place of the individual
+// mode / overwriteContents / bufsize arguments, and is the only way to
+// specify the less commonly-used settings.
+//
+// Setters return a reference to the object so that they may be
+// chained, e.g.:
+//
+//   NtupleOptions{}.setBufsize(10000).setFlushMode(NtupleFlushMode::ASYNC)
+//
+////////////////////////////////////
+// Settings
+//
+// TranslationMode mode (default TranslationMode::NONE)
+// NtupleOverwriteFlag overwriteContents (default NtupleOverwriteFlag::NO)
+// std::size_t bufsize (default 1000)
+//
+//   As for the corresponding Ntuple constructor arguments (including
+//   NtupleOverwriteFlag::APPEND to resume writing an existing table).
+//
+// std::size_t bufferBytes (default 0)
+//
+//   If non-zero, a memory budget in bytes for the Ntuple's buffers
+//   which overrides bufsize. It includes the rows which may be held
+//   back to complete a chunk of each column (see chunkAlignedFlush),
+//   for which default chunking (see chunkBytes) is limited to the
+//   number of rows whose in-memory size is half the budget. The
+//   number of rows buffered is derived from the remainder and the
+//   in-memory size of a row, and is rounded down to a multiple of the
+//   chunk row count of every column (their least common multiple)
+//   where the budget allows, so that each flush of a full buffer
+//   writes whole chunks. In NtupleFlushMode::ASYNC, the remainder is
+//   shared by both sets of buffers; in NtupleInsertMode::PER_THREAD,
+//   it applies to each staging block; with NtupleLayout::ROW_COMPOUND,
+//   it also holds the packed rows being written. Variable-length
+//   string columns are accounted by the size of their in-buffer
+//   representation only (e.g. sizeof(std::string)). At least one row
+//   is always buffered, so the budget is exceeded if it is too small
+//   for that, or for the chunks of columns with explicit chunking (or
+//   of an existing table, when appending).
+//
+// std::size_t chunkBytes (default DEFAULT_CHUNK_BYTES, 1 MiB)
+//
+//   The target size in bytes of the chunks of each column dataset
+//   created without explicit chunking (see hep_hpc/hdf5/make_column.hpp):
+//   the number of rows per chunk is chunkBytes divided by the size in
+//   file of one row of the column (of all members, for the compound
+//   dataset of NtupleLayout::ROW_COMPOUND), between 1 and
+//   MAX_DEFAULT_CHUNKING. Small elements thereby get chunks large
+//   enough to compress well and to keep the chunk index small, and
+//   large ones (e.g. waveforms) chunks of a few rows. Variable-length
+//   strings are counted by the size of their reference only. If 0,
+//   every such dataset has DEFAULT_CHUNKING rows per chunk regardless
+//   of its row size. With bufferBytes or memoryPool set, however, a
+//   chunk has at most as many rows as take (all columns together) half
+//   the smaller of bufferBytes and the pool's capacity in memory, so
+//   that the rows held back to complete a chunk of each column (see
+//   chunkAlignedFlush) fit. Not applicable when appending, where the
+//   existing chunking is kept. Either way, each column dataset without
+//   dataset access properties of its own is given a chunk cache
+//   holding one chunk, out of a process-wide budget (see
+//   hep_hpc/hdf5/ChunkCache.hpp).
+//
+// Shuffle shuffle (default Shuffle::BYTE)
+//
+//   The shuffle pre-filter (see hep_hpc/hdf5/Codec.hpp) included in the
+//   default dataset creation properties (deflate, level 6) of columns of
+//   arithmetic type (or arrays thereof): BYTE applies only to
+//   multi-byte types, BIT to all; NONE disables it. Not applicable to
+//   columns with dataset creation properties of their own, nor to the
+//   compound dataset of NtupleLayout::ROW_COMPOUND.
+//
+// bool chunkAlignedFlush (default true)
+//
+//   If true, flushing a full buffer writes only whole chunks of each
+//   column's dataset: any remaining rows are held back (in addition to
+//   the buffer) until they can complete a chunk, or until flush() or
+//   destruction of the Ntuple. This avoids HDF5 having to read back,
+//   decompress, merge and recompress a partially-written chunk on the
+//   next write (see Ntuple::chunkRewrites()). The rows held back are
+//   copies, strings included, so that the lifetime requirements of
+//   Ntuple::insert() are unaffected.
+//
+// unsigned int compressionThreads (default 0)
+//
+//   If non-zero, whole chunks are compressed by this many threads
+//   (including the one writing) and written directly to file
+//   (H5Dwrite_chunk()), bypassing the HDF5 filter pipeline, so that
+//   compression is no longer limited to one core. The files produced
+//   are identical in format to those written via the filter pipeline.
+//   This applies only to columns of fixed-size types written without
+//   translation (see TranslationMode) whose chunks span whole rows and
+//   whose filter pipeline is a single compression codec (see
+//   hep_hpc/hdf5/Codec.hpp), optionally preceded by shuffle, as for
+//   the default dataset creation properties; other columns, and
+//   incomplete chunks, are written as usual. Requires HDF5 >= 1.10.3
+//   and the library for the codec (zlib for deflate) at build time,
+//   else ignored. Most effective with large buffers (see bufferBytes)
+//   and chunkAlignedFlush.
+//
+// bool chunkStatistics (default false)
+//
+//   If true, the minimum, maximum and sum of the values of each
+//   arithmetic column, and the number of values and of NaNs (which are
+//   excluded from the others), are accumulated as rows are written, one
+//   record per chunk of the column's dataset (chunk k covering rows
+//   [k * chunkRows, (k + 1) * chunkRows)). The records are written to a
+//   one-dimensional dataset of compound type (members min, max, sum,
+//   count and nulls) named for the column in the subgroup _chunk_stats
+//   of the Ntuple's group, so that a reader may skip chunks which
+//   cannot satisfy a range selection without reading them. The record
+//   for an incomplete final chunk covers the rows written so far; a
+//   chunk with no values other than NaNs has min > max. When appending,
+//   the existing table must also have chunk statistics.
+//
+// std::vector<std::string> keyColumns (default none)
+//
+//   If set, the names of scalar integer columns (e.g. run, subrun,
+//   event) forming the key of each row, in order of significance. On
+//   destruction of the Ntuple, the key columns are read back from file
+//   and an index is written to the subgroup _key_index of the Ntuple's
+//   group, with which hep_hpc::hdf5::NtupleIndex (see
+//   hep_hpc/hdf5/NtupleIndex.hpp) finds the rows matching a key (or a
+//   leading part of one) in O(log n) without scanning the table. If the
+//   rows are in key order (as is usual for event data), the index is
+//   sparse, holding only the first and last key of each chunk; otherwise
+//   it is a dense, sorted list of every row's key and row number, built
+//   by an external merge sort in bounded memory (using a temporary file
+//   alongside the table's: see hep_hpc/hdf5/detail/KeyIndex.hpp). Keys
+//   are compared as signed 64-bit integers. When appending, the index
+//   is rebuilt over the whole table. Not supported with swmr (an
+//   exception is thrown).
+//
+// std::shared_ptr<NtupleMemoryPool> memoryPool (default none)
+//
+//   If set, the Ntuple's buffers are subject to the memory ceiling of
+//   the pool, shared with other Ntuples (see
+//   hep_hpc/hdf5/NtupleMemoryPool.hpp): buffer memory is allocated only
+//   as rows are inserted (rather than reserved for bufsize rows in
+//   advance, unless bufferBytes is set), and is released when the
+//   pool forces a flush. Not supported with
+//   NtupleInsertMode::PER_THREAD. Since each forced flush generally
+//   ends within a chunk, which must be read back and recompressed by
+//   the next write, a small chunkBytes is advisable when flushes are
+//   forced often (default chunking is in any case limited by the
+//   pool's capacity: see chunkBytes).
+//
+// NtupleLayout layout (default NtupleLayout::COLUMNAR)
+//
+//   * COLUMNAR: each column is written to its own dataset in the
+//     Ntuple's group.
+//
+//   * ROW_COMPOUND: all columns of fixed-size type are written as
+//     members of a single chunked dataset "rows" of compound type (one
+//     element per row), which favors analyses reading whole rows;
+//     variable-length and dictionary-encoded string columns, jagged
+//     columns and columns of bool are still written to datasets of
+//     their own, as are columns given link creation, dataset creation
+//     or dataset access properties of their own (e.g. compression or
+//     chunking), so that those properties apply. When appending, the
+//     columns must be given properties of their own as when the table
+//     was written. The entries of Ntuple::datasets() for compound
+//     members are invalid. compressionThreads does not apply to the
+//     compound dataset.
+//
+// bool swmr (default false)
+//
+//   If true, the file is switched to single-writer/multiple-reader
+//   mode (H5Fstart_swmr_write()) once the Ntuple's datasets have been
+//   created, so that other processes may read the table while it is
+//   being written (see hep_hpc/hdf5/NtupleTail.hpp). Dataset extents
+//   then track the rows written exactly rather than growing
+//   geometrically, and each flush of the buffers (whole chunks, with
+//   chunkAlignedFlush) is followed by H5Dflush() of every dataset, so
+//   that a reader sees only complete rows. The file must have been
+//   opened for writing with the latest file format (as it is by the
+//   constructors taking a filename), and since no objects may be
+//   created in a file in SWMR mode, the Ntuple must be the last object
+//   created in it. Variable-length and dictionary-encoded string
+//   columns and jagged columns are not supported (an exception is
+//   thrown). Requires HDF5 >= 1.10: with older libraries, setSWMR(true)
+//   throws.
+//
+// NtupleFlushMode flushMode (default NtupleFlushMode::SYNC)
+//
+//   * SYNC: buffered data are written to file by the thread calling
+//     insert() when the buffer is full.
+//
+//   * ASYNC: each column is double-buffered, and a dedicated writer
+//     thread owned by the Ntuple writes (and compresses) one set of
+//     buffers while insert() continues to fill the other. insert()
+//     blocks only if the writer has not finished with the previous set
+//     by the time the current one is full. Requires an HDF5 library
+//     configured for thread safety. Errors encountered by the writer
+//     thread are reported by the next call to insert() or flush().
+//
+// NtupleInsertMode insertMode (default NtupleInsertMode::LOCKED)
+//
+//   * LOCKED: all threads insert into a single set of buffers,
+//     serialized by a lock taken for each row.
+//
+//   * PER_THREAD: each inserting thread fills its own staging block of
+//     bufsize rows without taking any lock. Completed blocks are passed
+//     via a lock-free queue to the flush path: they are written by
+//     whichever inserting thread finds the flush path idle (SYNC), or
+//     by the writer thread (ASYNC). Rows inserted by one thread retain
+//     their relative order, but the rows of the table are interleaved
+//     block-wise in order of block completion. flush() writes the rows
+//     staged by the calling thread and all completed blocks; rows
+//     staged by other threads are written when their blocks are
+//     complete, or on destruction of the Ntuple (which must not
+//     therefore be concurrent with any insert()).
+//
+// FileTuning fileTuning (default FileTuning{}: HDF5 defaults)
+//
+//   File-level settings (alignment, paged file space and page
+//   buffering, metadata cache, metadata and small data block sizes)
+//   for the file opened by an Ntuple constructor taking a filename,
+//   e.g. FileTuning::parallelFS() (see hep_hpc/hdf5/FileTuning.hpp).
+//   The file space settings apply only to a file being created; when
+//   appending to an existing file without paged file space, the page
+//   buffer is omitted. Not applicable to an Ntuple given an open file.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Codec.hpp"
+#include "hep_hpc/hdf5/Column.hpp"
+#include "hep_hpc/hdf5/FileTuning.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    class NtupleOptions;
+
+    class NtupleMemoryPool;
+
+    enum class NtupleOverwriteFlag : uint8_t { NO, YES, APPEND };
+
+    enum class NtupleLayout : uint8_t { COLUMNAR, ROW_COMPOUND };
+
+    enum class NtupleFlushMode : uint8_t { SYNC, ASYNC };
+
+    enum class NtupleInsertMode : uint8_t { LOCKED, PER_THREAD };
+  } // Namespace hdf5.
+} // Namespace hep_hpc.
+
+class hep_hpc::hdf5::NtupleOptions {
+public:
+  NtupleOptions() = default;
+
+  TranslationMode mode() const { return mode_; }
+  NtupleOverwriteFlag overwriteContents() const { return overwriteContents_; }
+  std::size_t bufsize() const { return bufsize_; }
+  std::size_t bufferBytes() const { return bufferBytes_; }
+  std::size_t chunkBytes() const { return chunkBytes_; }
+  Shuffle shuffle() const { return shuffle_; }
+  bool chunkAlignedFlush() const { return chunkAlignedFlush_; }
+  unsigned int compressionThreads() const { return compressionThreads_; }
+  bool chunkStatistics() const { return chunkStatistics_; }
+  std::vector<std::string> const & keyColumns() const { return keyColumns_; }
+  std::shared_ptr<NtupleMemoryPool> const & memoryPool() const
+    { return memoryPool_; }
+  NtupleLayout layout() const { return layout_; }
+  bool swmr() const { return swmr_; }
+  NtupleFlushMode flushMode() const { return flushMode_; }
+  NtupleInsertMode insertMode() const { return insertMode_; }
+  FileTuning const & fileTuning() const { return fileTuning_; }
+
+  NtupleOptions & setMode(TranslationMode mode)
+    { mode_ = mode; return *this; }
+  NtupleOptions & setOverwriteContents(NtupleOverwriteFlag overwriteContents)
+    { overwriteContents_ = overwriteContents; return *this; }
+  NtupleOptions & setBufsize(std::size_t bufsize)
+    { bufsize_ = bufsize; return *this; }
+  NtupleOptions & setBufferBytes(std::size_t bufferBytes)
+    { bufferBytes_ = bufferBytes; return *this; }
+  NtupleOptions & setChunkBytes(std::size_t chunkBytes)
+    { chunkBytes_ = chunkBytes; return *this; }
+  NtupleOptions & setShuffle(Shuffle shuffle)
+    { shuffle_ = shuffle; return *this; }
+  NtupleOptions & setChunkAlignedFlush(bool chunkAlignedFlush)
+    { chunkAlignedFlush_ = chunkAlignedFlush; return *this; }
+  NtupleOptions & setCompressionThreads(unsigned int compressionThreads)
+    { compressionThreads_ = compressionThreads; return *this; }
+  NtupleOptions & setChunkStatistics(bool chunkStatistics)
+    { chunkStatistics_ = chunkStatistics; return *this; }
+  NtupleOptions & setKeyColumns(std::vector<std::string> keyColumns)
+    { keyColumns_ = std::move(keyColumns); return *this; }
+  NtupleOptions & setMemoryPool(std::shared_ptr<NtupleMemoryPool> memoryPool)
+    { memoryPool_ = std::move(memoryPool); return *this; }
+  NtupleOptions & setLayout(NtupleLayout layout)
+    { layout_ = layout; return *this; }
+  NtupleOptions & setSWMR(bool swmr);
+  NtupleOptions & setFlushMode(NtupleFlushMode flushMode)
+    { flushMode_ = flushMode; return *this; }
+  NtupleOptions & setInsertMode(NtupleInsertMode insertMode)
+    { insertMode_ = insertMode; return *this; }
+  NtupleOptions & setFileTuning(FileTuning fileTuning)
+    { fileTuning_ = fileTuning; return *this; }
+
+private:
+  TranslationMode mode_ {TranslationMode::NONE};
+  NtupleOverwriteFlag overwriteContents_ {NtupleOverwriteFlag::NO};
+  std::size_t bufsize_ {1000ull};
+  std::size_t bufferBytes_ {0ull};
+  std::size_t chunkBytes_ {DEFAULT_CHUNK_BYTES};
+  Shuffle shuffle_ {Shuffle::BYTE};
+  bool chunkAlignedFlush_ {true};
+  unsigned int compressionThreads_ {0u};
+  bool chunkStatistics_ {false};
+  std::vector<std::string> keyColumns_ {};
+  std::shared_ptr<NtupleMemoryPool> memoryPool_ {};
+  NtupleLayout layout_ {NtupleLayout::COLUMNAR};
+  bool swmr_ {false};
+  NtupleFlushMode flushMode_ {NtupleFlushMode::SYNC};
+  NtupleInsertMode insertMode_ {NtupleInsertMode::LOCKED};
+  FileTuning fileTuning_ {};
+};
+
+inline
+hep_hpc::hdf5::NtupleOptions &
+hep_hpc::hdf5::NtupleOptions::
+setSWMR(bool const swmr)
+{
+#if ! (H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR >= 10))
+  if (swmr) {
+    throw std::runtime_error("SWMR mode requires HDF5 >= 1.10.");
+  }
+#endif
+  swmr_ = swmr;
+  return *this;
+}
+
+#endif /* hep_hpc_hdf5_NtupleOptions_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,139 @@
+#include "hep_hpc/hdf5/NtupleTail.hpp"
+
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+  herr_t collectDataset(hid_t const group, char const * const name,
+                        H5L_info_t const *, void * const names)
+  {
+    hid_t const object = H5Oopen(group, name, H5P_DEFAULT);
+    if (object < 0) {
+      return -1;
+    }
+    if (H5Iget_type(object) == H5I_DATASET) {
+      static_cast<std::vector<std::string> *>(names)->emplace_back(name);
+    }
+    return H5Oclose(object);
+  }
+}
+
+hep_hpc::hdf5::NtupleTail::
+NtupleTail(std::string const & filename,
+           std::string const & tablename,
+           std::vector<std::string> columns)
+  : NtupleTail(openFile(filename), tablename, std::move(columns))
+{
+}
+
+hep_hpc::hdf5::NtupleTail::
+NtupleTail(File file,
+           std::string const & tablename,
+           std::vector<std::string> columns)
+  : file_(std::move(file)),
+    group_(file_, tablename, Group::OPEN_MODE),
+    columns_(std::move(columns))
+{
+  if (columns_.empty() &&
+      ErrorController::call(&H5Literate, group_, H5_INDEX_NAME, H5_ITER_INC,
+                            nullptr, &collectDataset, &columns_) < 0) {
+    throw std::runtime_error("Unable to list the columns of Ntuple " +
+                             tablename + ".");
+  }
+  if (columns_.empty()) {
+    throw std::runtime_error("Ntuple " + tablename + " has no columns.");
+  }
+  cacheReservations_.resize(columns_.size());
+  dsets_.reserve(columns_.size());
+  for (std::size_t i = 0; i != columns_.size(); ++i) {
+    dsets_.push_back(openDatasetWithChunkCache(group_, columns_[i],
+                                               ChunkAccess::SEQUENTIAL,
+                                               cacheReservations_[i]));
+  }
+  refresh();
+}
+
+hep_hpc::hdf5::File
+hep_hpc::hdf5::NtupleTail::openFile(std::string const & filename)
+{
+#if H5_VERS_MAJOR > 1 || (H5_VERS_MAJOR == 1 && H5_VERS_MINOR >= 10)
+  PropertyList plist(H5P_FILE_ACCESS);
+  H5Pset_libver_bounds(plist, H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+  return File(filename, H5F_ACC_RDONLY | H5F_ACC_SWMR_READ, {},
+              std::move(plist));
+#else
+  (void) filename;
+  throw std::runtime_error("NtupleTail requires HDF5 >= 1.10 (SWMR).");
+#endif
+}
+
+hsize_t
+hep_hpc::hdf5::NtupleTail::refresh()
+{
+  hsize_t rows = std::numeric_limits<hsize_t>::max();
+  for (auto & dset : dsets_) {
+    if (dset.refresh() != 0) {
+      throw std::runtime_error("Unable to refresh Ntuple column.");
+    }
+    Dataspace const space(ErrorController::call(&H5Dget_space, dset));
+    hsize_t dims[H5S_MAX_RANK];
+    if (ErrorController::call(&H5Sget_simple_extent_dims,
+                              space, dims, nullptr) < 0) {
+      throw std::runtime_error("Unable to obtain extent of Ntuple column.");
+    }
+    rows = std::min(rows, dims[0]);
+  }
+  // N.B. extents do not shrink.
+  available_ = std::max(rows, available_);
+  return available_ - position_;
+}
+
+herr_t
+hep_hpc::hdf5::NtupleTail::read(std::size_t const column,
+                                hid_t const memType,
+                                void * const buf)
+{
+  auto & dset = dsets_.at(column);
+  hsize_t const nRows = available_ - position_;
+  if (nRows == 0ull) {
+    return 0;
+  }
+  Dataspace fileSpace(ErrorController::call(&H5Dget_space, dset));
+  int const rank = H5Sget_simple_extent_ndims(fileSpace);
+  if (rank < 1) {
+    return -1;
+  }
+  hsize_t dims[H5S_MAX_RANK];
+  H5Sget_simple_extent_dims(fileSpace, dims, nullptr);
+  hsize_t offsets[H5S_MAX_RANK] {0};
+  offsets[0] = position_;
+  dims[0] = nRows;
+  herr_t rc;
+  if ((rc = ErrorController::call(&H5Sselect_hyperslab, fileSpace,
+                                  H5S_SELECT_SET, offsets, nullptr,
+                                  dims, nullptr)) != 0) {
+    return rc;
+  }
+  return dset.read(memType, buf, Dataspace{rank, dims, dims},
+                   std::move(fileSpace));
+}
+
+std::size_t
+hep_hpc::hdf5::NtupleTail::rowElements_(std::size_t const column) const
+{
+  Dataspace const space(ErrorController::call(&H5Dget_space,
+                                              dsets_.at(column)));
+  int const rank = H5Sget_simple_extent_ndims(space);
+  hsize_t dims[H5S_MAX_RANK];
+  H5Sget_simple_extent_dims(space, dims, nullptr);
+  std::size_t result = 1ull;
+  for (int i = 1; i < rank; ++i) {
+    result *= dims[i];
+  }
+  return result;
+}
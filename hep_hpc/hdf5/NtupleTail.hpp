@@ -0,0 +1,157 @@
+#ifndef hep_hpc_hdf5_NtupleTail_hpp
+#define hep_hpc_hdf5_NtupleTail_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::NtupleTail
+//
+// Read the rows of an Ntuple (see hep_hpc/hdf5/Ntuple.hpp) as they are
+// written by another process in SWMR mode (see
+// NtupleOptions::setSWMR()), e.g. for online monitoring (requires HDF5
+// >= 1.10: with older libraries, opening a file throws):
+//
+//   NtupleTail tail("data.hdf5", "events", {"run", "energy"});
+//   while (...) {
+//     if (tail.refresh() != 0ull) {
+//       auto const energy = tail.read<double>(1);
+//       ...
+//       tail.advance();
+//     }
+//     ...
+//   }
+//
+////////////////////////////////////
+// Interface.
+//
+// NtupleTail(std::string filename,
+//            std::string tablename,
+//            std::vector<std::string> columns = {});
+//
+// NtupleTail(File file,
+//            std::string tablename,
+//            std::vector<std::string> columns = {});
+//
+//   Follow the named columns (datasets) of table tablename, or all of
+//   its datasets in name order if none are specified. If filename is
+//   provided, the file is opened read-only in SWMR mode; a provided
+//   file should have been opened similarly (see openFile()). Each
+//   column's dataset has a chunk cache sized for reading it in order
+//   (see hep_hpc/hdf5/ChunkCache.hpp), so that the chunk holding the
+//   last rows read is not read and decompressed again by the next
+//   read().
+//
+// static File openFile(std::string const & filename);
+//
+//   Open the named file read-only for SWMR reading.
+//
+// std::vector<std::string> const & columns() const;
+// Dataset const & dataset(std::size_t column) const;
+//
+//   The names and datasets of the columns followed.
+//
+// hsize_t refresh();
+//
+//   Refresh the columns' metadata from file (H5Drefresh()) and return
+//   the number of rows available to read, i.e. the rows written to all
+//   of the columns so far and not yet consumed via advance(). N.B. the
+//   writer flushes each column in turn, so a reader may momentarily see
+//   more rows in some columns than in others: only rows complete in
+//   every column are counted.
+//
+// hsize_t position() const;
+// hsize_t available() const;
+//
+//   The number of rows consumed, and the number of rows found in every
+//   column at the last refresh().
+//
+// herr_t read(std::size_t column, hid_t memType, void * buf);
+//
+//   Read the rows [position(), available()) of the specified column to
+//   buf, converting to memType.
+//
+// template <typename T>
+// std::vector<T> read(std::size_t column);
+//
+//   As above, for a column of basic element type T (see
+//   hep_hpc/hdf5/Column.hpp): available() - position() rows of each
+//   column's element size items of type T.
+//
+// void advance();
+//
+//   Mark the rows read as consumed: position() becomes available().
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/ChunkCache.hpp"
+#include "hep_hpc/hdf5/Column.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/Group.hpp"
+
+#include "hdf5.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    class NtupleTail;
+  }
+}
+
+class hep_hpc::hdf5::NtupleTail {
+public:
+  NtupleTail(std::string const & filename,
+             std::string const & tablename,
+             std::vector<std::string> columns = {});
+
+  NtupleTail(File file,
+             std::string const & tablename,
+             std::vector<std::string> columns = {});
+
+  static File openFile(std::string const & filename);
+
+  std::vector<std::string> const & columns() const { return columns_; }
+  Dataset const & dataset(std::size_t column) const
+    { return dsets_.at(column); }
+
+  hsize_t refresh();
+  hsize_t position() const { return position_; }
+  hsize_t available() const { return available_; }
+
+  herr_t read(std::size_t column, hid_t memType, void * buf);
+
+  template <typename T>
+  std::vector<T> read(std::size_t column);
+
+  void advance() { position_ = available_; }
+
+private:
+  // Items per row of a column.
+  std::size_t rowElements_(std::size_t column) const;
+
+  File file_;
+  Group group_;
+  std::vector<std::string> columns_;
+  std::vector<ChunkCacheReservation> cacheReservations_ {};
+  std::vector<Dataset> dsets_ {};
+  hsize_t position_ {0ull};
+  hsize_t available_ {0ull};
+};
+
+template <typename T>
+std::vector<T>
+hep_hpc::hdf5::NtupleTail::read(std::size_t const column)
+{
+  std::vector<T> result((available_ - position_) * rowElements_(column));
+  if (!result.empty() &&
+      read(column, Column<T, 1ull>::engine_type(TranslationMode::NONE),
+           result.data()) != 0) {
+    result.clear();
+  }
+  return result;
+}
+
+#endif /* hep_hpc_hdf5_NtupleTail_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,477 @@
+#ifndef hep_hpc_hdf5_ParallelNtuple_hpp
+#define hep_hpc_hdf5_ParallelNtuple_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::ParallelNtuple
+//
+// An Ntuple written collectively by all ranks of an MPI communicator to
+// a single table in a single shared file, using parallel HDF5 (MPI-IO),
+// thus removing the need to write one file per rank and concatenate
+// them afterwards (see hep_hpc/concat_hdf5).
+//
+// Each rank inserts rows into its own buffers without communication.
+// At each flush, the offset of each rank's rows in the table is
+// obtained via an MPI_Exscan() of the number of rows buffered by each
+// rank, the extent of each dataset is extended collectively to
+// accommodate the rows of all ranks, and each rank then writes its rows
+// to its own slice of each dataset with a collective write. The rows of
+// each flush therefore appear in the table in rank order.
+//
+// Available only if hep_hpc was built with MPI support
+// (HEP_HPC_USE_MPI), with an HDF5 library configured for parallel I/O.
+// Clients must link with hep_hpc_MPI.
+//
+////////////////////////////////////
+// Interface.
+//
+// ParallelNtuple(MPICommunicator comm,
+//                std::string const & filename,
+//                std::string tablename,
+//                column_info_t columns,
+//                NtupleOptions const & options = {});
+//
+//   Create (or truncate) the file filename collectively, opened for
+//   MPI-IO with communicator comm, and create the table tablename
+//   within it. With NtupleOverwriteFlag::APPEND, an existing file is
+//   opened instead and an existing table extended (see Ntuple). All
+//   ranks of comm must call the constructor with the same arguments. Of
+//   options, only mode, overwriteContents, bufsize, chunkBytes, shuffle
+//   and fileTuning (without its page buffer, which HDF5 does not
+//   support with MPI-IO) are used (bufsize is the number of rows for
+//   which space is reserved in each rank's buffers). Variable-length
+//   string columns are not supported, as they may not be written
+//   collectively by parallel HDF5.
+//
+// ParallelNtuple(MPICommunicator comm,
+//                File file,
+//                std::string tablename,
+//                column_info_t columns,
+//                NtupleOptions const & options = {});
+//
+//   As above, with a file already opened for MPI-IO (see
+//   parallelFileAccessProperties()) by all ranks of comm.
+//
+// ~ParallelNtuple();
+//
+//   Collective: flush remaining rows of all ranks.
+//
+// void insert(T...);
+// void insert_columns(std::size_t nRows,
+//                     Element_t<Args> const * ... columns);
+//
+//   As for Ntuple, with no communication. N.B. a rank's buffers grow as
+//   necessary between flushes: they are never written other than by
+//   flush() (or the destructor), since writing is collective.
+//
+// void flush();
+//
+//   Collective: write the rows buffered by all ranks of the
+//   communicator. Must be called by all ranks the same number of times,
+//   whether or not they have buffered rows; e.g. once per some fixed
+//   number of events processed.
+//
+// std::size_t size() const;
+//
+//   The number of rows in the table written by all ranks to date.
+//
+// File const & file() const;
+// Group const & group() const;
+// std::array<Dataset, nColumns()> const & datasets() const;
+// static constexpr std::size_t nColumns();
+//
+//   As for Ntuple.
+//
+////////////////////////////////////
+// Non-member functions.
+//
+// PropertyList parallelFileAccessProperties(MPI_Comm comm);
+//
+//   File access properties to open a file for MPI-IO with communicator
+//   comm (H5Pset_fapl_mpio()).
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/detail/config.hpp"
+
+#ifndef HEP_HPC_USE_MPI
+#error "hep_hpc/hdf5/ParallelNtuple.hpp requires hep_hpc to be built with MPI support."
+#endif
+
+#include "hep_hpc/MPI/MPICommunicator.hpp"
+#include "hep_hpc/MPI/throwOnMPIError.hpp"
+#include "hep_hpc/hdf5/Ntuple.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+
+#include "hdf5.h"
+#include "mpi.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    template <typename... Args>
+    class ParallelNtuple;
+
+    PropertyList parallelFileAccessProperties(MPI_Comm comm);
+  }
+}
+
+template <typename... Args>
+class hep_hpc::hdf5::ParallelNtuple {
+public:
+  using column_info_t = std::tuple<detail::permissive_column<Args>...>;
+
+  // Basic element type of a column described by T.
+  template <typename T>
+  using Element_t = typename detail::permissive_column<T>::element_type;
+
+  ParallelNtuple(MPICommunicator comm,
+                 std::string const & filename,
+                 std::string tablename,
+                 column_info_t columns,
+                 NtupleOptions const & options = {});
+
+  ParallelNtuple(MPICommunicator comm,
+                 File file,
+                 std::string tablename,
+                 column_info_t columns,
+                 NtupleOptions const & options = {});
+
+  ~ParallelNtuple() noexcept;
+
+  File const & file() const { return file_; }
+  Group const & group() const { return dd_->group; }
+  std::size_t size() const { return size_; }
+  static constexpr std::size_t nColumns() { return sizeof...(Args); }
+  std::array<Dataset, nColumns()> const & datasets() const
+    { return dd_->dsets; }
+
+  template <typename... T>
+  void insert(T && ... args)
+    { NtupleDetail::insert<0>(buffers_, dd_->columns, std::forward<T>(args)...); }
+  void insert_columns(std::size_t nRows,
+                      Element_t<Args> const * ... columns)
+    { appendColumns_(nRows, iSequence(), columns...); }
+  void flush();
+
+  // Enable moving
+  ParallelNtuple(ParallelNtuple &&) = default;
+  ParallelNtuple & operator=(ParallelNtuple &&) = default;
+
+  // Disable copying
+  ParallelNtuple(ParallelNtuple const&) = delete;
+  ParallelNtuple & operator=(ParallelNtuple const&) = delete;
+
+private:
+  static_assert(sizeof...(Args) > 0,
+                "ParallelNtuple with zero types is meaningless");
+  static_assert(!(std::is_same<detail::column_buffer_t<Element_t<Args> >,
+                 detail::StringArena>::value || ...),
+                "ParallelNtuple does not support variable-length string columns.");
+
+  using buffers_t = std::tuple<detail::column_buffer_t<Element_t<Args> >...>;
+  using data_structure_t = detail::NtupleDataStructure<Args...>;
+
+  static constexpr hep_hpc::detail::make_index_sequence<nColumns()> iSequence()
+    { return hep_hpc::detail::make_index_sequence<nColumns()>(); }
+
+  template <std::size_t... I>
+  static std::unique_ptr<data_structure_t>
+  makeDataStructure_(File const & file,
+                     std::string const & tablename,
+                     column_info_t columns,
+                     NtupleOptions const & options,
+                     hep_hpc::detail::index_sequence<I...>);
+
+  static File openFile_(std::string const & filename,
+                        NtupleOverwriteFlag overwriteContents,
+                        FileTuning const & tuning,
+                        MPI_Comm comm);
+
+  // Set up transfer properties, reserve space in the buffers and note
+  // any existing rows.
+  template <std::size_t... I>
+  void init_(NtupleOptions const & options,
+             hep_hpc::detail::index_sequence<I...>);
+
+  template <std::size_t... I>
+  void appendColumns_(std::size_t nRows,
+                      hep_hpc::detail::index_sequence<I...>,
+                      Element_t<Args> const * ... columns);
+
+  // Collective: extend each dataset to newSize rows and write the nRows
+  // buffered rows of this rank starting at row offset.
+  template <std::size_t... I>
+  herr_t write_(hsize_t offset,
+                hsize_t nRows,
+                hsize_t newSize,
+                hep_hpc::detail::index_sequence<I...>);
+
+  template <std::size_t I>
+  herr_t writeColumn_(hsize_t offset, hsize_t nRows, hsize_t newSize);
+
+  template <std::size_t... I>
+  void clear_(hep_hpc::detail::index_sequence<I...>);
+
+  MPICommunicator comm_;
+  File file_;
+  std::unique_ptr<data_structure_t> dd_;
+  buffers_t buffers_;
+  PropertyList xferProperties_;
+  hsize_t size_ {0ull};
+};
+
+template <typename... Args>
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+ParallelNtuple(MPICommunicator comm,
+               std::string const & filename,
+               std::string tablename,
+               column_info_t columns,
+               NtupleOptions const & options)
+  :
+  comm_{std::move(comm)},
+  file_{openFile_(filename, options.overwriteContents(),
+                  options.fileTuning(), comm_)},
+  dd_{makeDataStructure_(file_, tablename, std::move(columns), options,
+                         iSequence())},
+  xferProperties_(H5P_DATASET_XFER)
+{
+  init_(options, iSequence());
+}
+
+template <typename... Args>
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+ParallelNtuple(MPICommunicator comm,
+               File file,
+               std::string tablename,
+               column_info_t columns,
+               NtupleOptions const & options)
+  :
+  comm_{std::move(comm)},
+  file_{std::move(file)},
+  dd_{makeDataStructure_(file_, tablename, std::move(columns), options,
+                         iSequence())},
+  xferProperties_(H5P_DATASET_XFER)
+{
+  init_(options, iSequence());
+}
+
+template <typename... Args>
+template <std::size_t... I>
+auto
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+makeDataStructure_(File const & file,
+                   std::string const & tablename,
+                   column_info_t columns,
+                   NtupleOptions const & options,
+                   hep_hpc::detail::index_sequence<I...>)
+-> std::unique_ptr<data_structure_t>
+{
+  if (!file) {
+    throw std::runtime_error("Attempt to create ParallelNtuple with invalid file.");
+  }
+  return std::unique_ptr<data_structure_t>
+    (new data_structure_t(file, tablename, options.mode(),
+                          options.overwriteContents(),
+                          false,
+                          options.chunkBytes(),
+                          0ull,
+                          options.shuffle(),
+                          std::move(std::get<I>(columns))...));
+}
+
+template <typename... Args>
+hep_hpc::hdf5::File
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+openFile_(std::string const & filename,
+          NtupleOverwriteFlag const overwriteContents,
+          FileTuning const & tuning,
+          MPI_Comm const comm)
+{
+  htri_t exists = 0;
+  if (overwriteContents == NtupleOverwriteFlag::APPEND) {
+    ScopedErrorHandler seh;
+    exists = H5Fis_hdf5(filename.c_str());
+  }
+  // No page buffering with MPI-IO.
+  PropertyList fapl = parallelFileAccessProperties(comm);
+  setFileAccessTuning(fapl, tuning, false);
+  if (exists > 0) {
+    return File(filename, H5F_ACC_RDWR, {}, std::move(fapl));
+  }
+  PropertyList fcpl(H5P_FILE_CREATE);
+  setFileCreationTuning(fcpl, tuning);
+  return File(filename, H5F_ACC_TRUNC, std::move(fcpl), std::move(fapl));
+}
+
+template <typename... Args>
+template <std::size_t... I>
+void
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+init_(NtupleOptions const & options, hep_hpc::detail::index_sequence<I...>)
+{
+  size_ = dd_->state[0].size;
+  (void) ErrorController::call(&H5Pset_dxpl_mpio, xferProperties_,
+                               H5FD_MPIO_COLLECTIVE);
+  using swallow = int[];
+  (void) swallow {0,
+      (std::get<I>(buffers_).reserve(options.bufsize() *
+                                     std::get<I>(dd_->columns).elementSize()), 0)...};
+}
+
+template <typename... Args>
+hep_hpc::hdf5::ParallelNtuple<Args...>::~ParallelNtuple() noexcept
+{
+  if (!dd_) { // Moved-from.
+    return;
+  }
+  try {
+    flush();
+  }
+  catch (std::exception const & e) {
+    std::cerr << "Exception caught while flushing ParallelNtuple "
+              << "in destructor: " << e.what() << "\n";
+  }
+}
+
+template <typename... Args>
+void
+hep_hpc::hdf5::ParallelNtuple<Args...>::flush()
+{
+  unsigned long long nRows =
+    std::get<0>(buffers_).size() / std::get<0>(dd_->columns).elementSize();
+  unsigned long long offset = 0ull, total = 0ull;
+  throwOnMPIError("MPI_Exscan()", &MPI_Exscan, &nRows, &offset, 1,
+                  MPI_UNSIGNED_LONG_LONG, MPI_SUM, static_cast<MPI_Comm>(comm_));
+  if (comm_.rank() == 0) { // Result of MPI_Exscan() undefined.
+    offset = 0ull;
+  }
+  throwOnMPIError("MPI_Allreduce()", &MPI_Allreduce, &nRows, &total, 1,
+                  MPI_UNSIGNED_LONG_LONG, MPI_SUM, static_cast<MPI_Comm>(comm_));
+  if (total == 0ull) { // Nothing to do on any rank.
+    return;
+  }
+  if (write_(size_ + offset, nRows, size_ + total, iSequence()) != 0) {
+    throw std::runtime_error("HDF5 collective write failure.");
+  }
+  size_ += total;
+  clear_(iSequence());
+}
+
+template <typename... Args>
+template <std::size_t... I>
+void
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+appendColumns_(std::size_t const nRows,
+               hep_hpc::detail::index_sequence<I...>,
+               Element_t<Args> const * ... columns)
+{
+  using swallow = int[];
+  (void) swallow {0,
+      (NtupleDetail::append_rows(std::get<I>(buffers_),
+                                 std::get<I>(dd_->columns),
+                                 columns,
+                                 nRows), 0)...};
+}
+
+template <typename... Args>
+template <std::size_t... I>
+herr_t
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+write_(hsize_t const offset,
+       hsize_t const nRows,
+       hsize_t const newSize,
+       hep_hpc::detail::index_sequence<I...>)
+{
+  // Every rank must take part in every collective operation, so carry
+  // on after a failure.
+  herr_t result = 0;
+  using swallow = int[];
+  (void) swallow {0,
+      (result |= writeColumn_<I>(offset, nRows, newSize), 0)...};
+  return result;
+}
+
+template <typename... Args>
+template <std::size_t I>
+herr_t
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+writeColumn_(hsize_t const offset,
+             hsize_t const nRows,
+             hsize_t const newSize)
+{
+  auto const & col = std::get<I>(dd_->columns);
+  auto & dset = dd_->dsets[I];
+  std::array<hsize_t, std::tuple_element<I, column_info_t>::type::nDims() + 1ull>
+    filedims, offsets {0}, nElements, blockCount;
+  blockCount.fill(1);
+  nElements[0] = nRows;
+  std::copy(col.dims(), col.dims() + col.nDims(), std::begin(nElements) + 1ull);
+  filedims = nElements;
+  filedims[0] = newSize;
+  herr_t rc;
+  // Collective.
+  if ((rc = ErrorController::call(&H5Dset_extent, dset, filedims.data())) != 0) {
+    return rc;
+  }
+  Dataspace fileSpace{ErrorController::call(&H5Dget_space, dset)};
+  Dataspace memSpace{ErrorController::call(&H5Screate_simple,
+                                           static_cast<int>(nElements.size()),
+                                           nElements.data(),
+                                           nElements.data())};
+  if (nRows == 0ull) { // Participate with an empty selection.
+    rc = ErrorController::call(&H5Sselect_none, fileSpace) |
+         ErrorController::call(&H5Sselect_none, memSpace);
+  } else {
+    offsets[0] = offset;
+    rc = ErrorController::call(&H5Sselect_hyperslab,
+                               fileSpace,
+                               H5S_SELECT_SET,
+                               offsets.data(),
+                               nullptr,
+                               blockCount.data(),
+                               nElements.data());
+  }
+  if (rc != 0) {
+    return rc;
+  }
+  // Collective.
+  return ErrorController::call(&H5Dwrite,
+                               dset,
+                               col.engine_type(),
+                               memSpace,
+                               fileSpace,
+                               xferProperties_,
+                               std::get<I>(buffers_).data());
+}
+
+template <typename... Args>
+template <std::size_t... I>
+void
+hep_hpc::hdf5::ParallelNtuple<Args...>::
+clear_(hep_hpc::detail::index_sequence<I...>)
+{
+  using swallow = int[];
+  (void) swallow {0, (std::get<I>(buffers_).clear(), 0)...};
+}
+
+inline
+hep_hpc::hdf5::PropertyList
+hep_hpc::hdf5::parallelFileAccessProperties(MPI_Comm const comm)
+{
+  PropertyList result(H5P_FILE_ACCESS);
+  (void) ErrorController::call(&H5Pset_fapl_mpio, result, comm, MPI_INFO_NULL);
+  return result;
+}
+
+#endif /* hep_hpc_hdf5_ParallelNtuple_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,216 @@
+#ifndef hep_hpc_hdf5_StructNtuple_hpp
+#define hep_hpc_hdf5_StructNtuple_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::StructNtuple
+//
+// An Ntuple (see hep_hpc/hdf5/Ntuple.hpp) filled from user-defined
+// structs (or classes), each of whose columns is the value of a data
+// member of the struct.
+//
+// Construct one with hep_hpc::hdf5::make_struct_ntuple(), describing
+// each column with hep_hpc::hdf5::make_field():
+//
+//   struct Hit {
+//     int id;
+//     float pos[3];
+//     double energy;
+//   };
+//
+//   auto hits =
+//     make_struct_ntuple<Hit>({"hits.h5", "hits"},
+//                             make_field(&Hit::id,
+//                                        make_scalar_column<int>("id")),
+//                             make_field(&Hit::pos,
+//                                        make_column<float>("pos", 3)),
+//                             make_field(&Hit::energy,
+//                                        make_scalar_column<double>("e")));
+//
+//   std::vector<Hit> const event_hits = ...;
+//   hits.insert(event_hits.data(), event_hits.size());
+//
+// The first argument to make_struct_ntuple() is as for make_ntuple()
+// (see hep_hpc/hdf5/make_ntuple.hpp).
+//
+// The type of each data member must be the basic element type of its
+// column (or, for columns with Column::elementSize() > 1, an array
+// thereof of the right size, e.g. T[N] or std::array<T, N>).
+//
+////////////////////////////////////
+// Interface
+//
+// void insert(S const & s);
+//
+//   Insert one row.
+//
+// void insert(S const * structs, std::size_t n);
+//
+//   Insert n rows from a contiguous array of structs. The fields of
+//   the structs are copied directly into the column buffers (see
+//   Ntuple::insert_strided()) with no per-row function call.
+//
+// template <typename CONTAINER>
+// void insert_range(CONTAINER const & structs);
+//
+//   Insert all the structs of a contiguous container (providing data()
+//   and size(), e.g. std::vector<S> or std::array<S, N>).
+//
+// ntuple_t & ntuple();
+// void flush();
+//
+//   Access to the underlying Ntuple and its flush() function.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/Utilities/detail/index_sequence.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    template <typename S, typename M, typename COL>
+    struct StructField;
+
+    template <typename S, typename... FIELDS>
+    class StructNtuple;
+
+    template <typename S, typename M, typename COL>
+    StructField<S, M, COL>
+    make_field(M S::* member, COL column);
+
+    template <typename S, typename... FIELDS>
+    StructNtuple<S, FIELDS...>
+    make_struct_ntuple(NtupleInitializer ntInit, FIELDS ... fields);
+
+    namespace StructNtupleDetail {
+      // Is M the element type E, or an array thereof?
+      template <typename M, typename E>
+      struct is_element_storage : std::is_same<M, E> { };
+
+      template <typename M, std::size_t N, typename E>
+      struct is_element_storage<M[N], E> : is_element_storage<M, E> { };
+
+      template <typename M, std::size_t N, typename E>
+      struct is_element_storage<std::array<M, N>, E> :
+        std::integral_constant<bool,
+                               std::is_same<std::array<M, N>, E>::value ||
+                               is_element_storage<M, E>::value> { };
+    }
+  }
+}
+
+template <typename S, typename M, typename COL>
+struct hep_hpc::hdf5::StructField {
+  using struct_type = S;
+  using member_type = M;
+  using column_type = COL;
+  using element_type = typename detail::permissive_column<COL>::element_type;
+
+  static_assert(StructNtupleDetail::is_element_storage<M, element_type>::value,
+                "Struct member type must be the element type of its column "
+                "or an array thereof.");
+
+  M S::* member;
+  COL column;
+};
+
+template <typename S, typename... FIELDS>
+class hep_hpc::hdf5::StructNtuple {
+public:
+  using ntuple_t = Ntuple<typename FIELDS::column_type...>;
+
+  StructNtuple(NtupleInitializer ntInit, FIELDS... fields);
+
+  void insert(S const & s) { insert(&s, 1ull); }
+  void insert(S const * structs, std::size_t n);
+
+  template <typename CONTAINER>
+  void insert_range(CONTAINER const & structs)
+    { insert(structs.data(), structs.size()); }
+
+  ntuple_t & ntuple() { return ntuple_; }
+  void flush() { ntuple_.flush(); }
+
+private:
+  static constexpr hep_hpc::detail::make_index_sequence<sizeof...(FIELDS)>
+  iSequence()
+    { return hep_hpc::detail::make_index_sequence<sizeof...(FIELDS)>(); }
+
+  template <std::size_t... I>
+  void insert_(S const * structs,
+               std::size_t n,
+               hep_hpc::detail::index_sequence<I...>);
+
+  std::tuple<typename FIELDS::member_type S::* ...> members_;
+  ntuple_t ntuple_;
+};
+
+template <typename S, typename M, typename COL>
+inline
+hep_hpc::hdf5::StructField<S, M, COL>
+hep_hpc::hdf5::make_field(M S::* const member, COL column)
+{
+  auto const nElements = sizeof(M) /
+    sizeof(typename StructField<S, M, COL>::element_type);
+  if (column.elementSize() != nElements) {
+    throw std::runtime_error("Size of struct member does not match that of "
+                             "column " + column.name() + ".");
+  }
+  return {member, std::move(column)};
+}
+
+template <typename S, typename... FIELDS>
+hep_hpc::hdf5::StructNtuple<S, FIELDS...>::
+StructNtuple(NtupleInitializer ntInit, FIELDS... fields)
+  :
+  members_(fields.member...),
+  ntuple_(make_ntuple(std::move(ntInit), std::move(fields.column)...))
+{
+}
+
+template <typename S, typename... FIELDS>
+inline
+void
+hep_hpc::hdf5::StructNtuple<S, FIELDS...>::
+insert(S const * const structs, std::size_t const n)
+{
+  if (n != 0ull) {
+    insert_(structs, n, iSequence());
+  }
+}
+
+template <typename S, typename... FIELDS>
+template <std::size_t... I>
+inline
+void
+hep_hpc::hdf5::StructNtuple<S, FIELDS...>::
+insert_(S const * const structs,
+        std::size_t const n,
+        hep_hpc::detail::index_sequence<I...>)
+{
+  using std::get;
+  ntuple_.insert_strided
+    (n, sizeof(S),
+     reinterpret_cast<typename FIELDS::element_type const *>
+     (&(structs->*get<I>(members_)))...);
+}
+
+template <typename S, typename... FIELDS>
+inline
+hep_hpc::hdf5::StructNtuple<S, FIELDS...>
+hep_hpc::hdf5::make_struct_ntuple(NtupleInitializer ntInit,
+                                  FIELDS ... fields)
+{
+  return StructNtuple<S, FIELDS...>(std::move(ntInit), std::move(fields)...);
+}
+
+#endif /* hep_hpc_hdf5_StructNtuple_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
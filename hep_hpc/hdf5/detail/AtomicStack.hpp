@@ -0,0 +1,70 @@
+#ifndef hep_hpc_hdf5_detail_AtomicStack_hpp
+#define hep_hpc_hdf5_detail_AtomicStack_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::AtomicStack<T>
+//
+// A minimal lock-free intrusive stack of T, which must have a data
+// member T * next. Any number of threads may push(); items are only
+// ever removed all at once via takeAll(), which avoids the ABA problem
+// inherent in popping single items from a lock-free stack.
+//
+// The stack does not own its items.
+//
+////////////////////////////////////////////////////////////////////////
+#include <atomic>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      template <typename T>
+      class AtomicStack;
+
+      // Reverse a chain of items linked via next, returning the new
+      // head (e.g. to obtain the items of takeAll() in push order).
+      template <typename T>
+      T * reverseChain(T * head);
+    }
+  }
+}
+
+template <typename T>
+class hep_hpc::hdf5::detail::AtomicStack {
+public:
+  // Push a single item.
+  void push(T * item) { pushChain(item, item); }
+
+  // Push a chain of items first -> ... -> last linked via next.
+  void pushChain(T * first, T * last)
+    {
+      last->next = head_.load();
+      while (!head_.compare_exchange_weak(last->next, first)) { }
+    }
+
+  // Remove and return all items (most recently pushed first).
+  T * takeAll() { return head_.exchange(nullptr); }
+
+  bool empty() const { return head_.load() == nullptr; }
+
+private:
+  std::atomic<T *> head_ {nullptr};
+};
+
+template <typename T>
+T *
+hep_hpc::hdf5::detail::reverseChain(T * head)
+{
+  T * result = nullptr;
+  while (head != nullptr) {
+    T * const next = head->next;
+    head->next = result;
+    result = head;
+    head = next;
+  }
+  return result;
+}
+
+#endif /* hep_hpc_hdf5_detail_AtomicStack_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
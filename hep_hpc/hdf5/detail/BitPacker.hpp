@@ -0,0 +1,86 @@
+#ifndef hep_hpc_hdf5_detail_BitPacker_hpp
+#define hep_hpc_hdf5_detail_BitPacker_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::BitPacker
+//
+// The companion of a column of bool (see hep_hpc/hdf5/Column.hpp): the
+// column is buffered with one byte per flag, and its rows are packed
+// (see hep_hpc/hdf5/pack_bits.hpp) as they are written.
+//
+// hep_hpc::hdf5::detail::PackedBitsColumn
+//
+// The column as stored on file: one-dimensional elements of
+// packed_row_bytes(elementSize()) 8-bit bitfields, with the name and
+// properties of the original column. BitPacker::packed() provides the
+// shape for writing.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Column.hpp"
+#include "hep_hpc/hdf5/pack_bits.hpp"
+
+#include "hdf5.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      class BitPacker;
+      struct PackedBitsColumn;
+    }
+  }
+}
+
+struct hep_hpc::hdf5::detail::PackedBitsColumn : column_base<1ull> {
+  PackedBitsColumn(std::string colName, std::size_t rowFlags)
+    : column_base<1ull>(std::move(colName), packed_row_bytes(rowFlags))
+    { }
+
+  template <typename COL>
+  explicit PackedBitsColumn(COL const & col)
+    : PackedBitsColumn(col.name(), col.elementSize())
+    {
+      setLinkCreationProperties(col.linkCreationProperties());
+      setDatasetCreationProperties(col.datasetCreationProperties());
+      setDatasetAccessProperties(col.datasetAccessProperties());
+    }
+
+  static hid_t engine_type(TranslationMode mode = TranslationMode::NONE)
+    { ENGINE_TYPE(H5T_NATIVE_B8, H5T_STD_B8LE, H5T_STD_B8BE) }
+};
+
+class hep_hpc::hdf5::detail::BitPacker {
+public:
+  void open(std::string const & name, std::size_t rowFlags)
+    { packed_ = PackedBitsColumn(name, rowFlags); rowFlags_ = rowFlags; }
+
+  // Pack n rows, valid until the next call.
+  template <typename B>
+  unsigned char const * pack(B const * rows, std::size_t n);
+
+  PackedBitsColumn const & packed() const { return packed_; }
+
+private:
+  PackedBitsColumn packed_ {std::string{}, 0ull};
+  std::size_t rowFlags_ {0ull};
+  std::vector<unsigned char> buffer_ {};
+};
+
+template <typename B>
+inline
+unsigned char const *
+hep_hpc::hdf5::detail::BitPacker::pack(B const * const rows, std::size_t const n)
+{
+  buffer_.resize(n * packed_.elementSize());
+  packBits(rows, n, rowFlags_, buffer_.data());
+  return buffer_.data();
+}
+
+#endif /* hep_hpc_hdf5_detail_BitPacker_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
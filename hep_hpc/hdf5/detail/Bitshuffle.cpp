@@ -0,0 +1,132 @@
+#include "hep_hpc/hdf5/detail/Bitshuffle.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+  constexpr std::size_t TARGET_BLOCK_BYTES = 8192ull;
+  constexpr std::size_t MIN_BLOCK = 128ull;
+
+  // Transpose the 8x8 bit matrix whose row k is byte k of x: afterwards
+  // bit m of byte k is bit k of the original byte m. An involution.
+  inline std::uint64_t transpose8x8(std::uint64_t x)
+  {
+    std::uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+    return x ^ t ^ (t << 28);
+  }
+
+  // Shuffle one block of n (a multiple of 8) elements. Each group of 8
+  // elements contributes one byte to each of the 8 * size bit planes.
+  // The loops have no dependencies between iterations of the innermost
+  // two, and compile to vector code where available.
+  void shuffleBlock(unsigned char const * const in,
+                    unsigned char * const out,
+                    std::size_t const n,
+                    std::size_t const size)
+  {
+    std::size_t const planeBytes = n / 8;
+    for (std::size_t j = 0; j != size; ++j) {
+      unsigned char * const planes = out + 8 * j * planeBytes;
+      for (std::size_t g = 0; g != planeBytes; ++g) {
+        unsigned char const * const elements = in + 8 * g * size + j;
+        std::uint64_t x = 0u;
+        for (std::size_t m = 0; m != 8; ++m) {
+          x |= std::uint64_t(elements[m * size]) << (8 * m);
+        }
+        x = transpose8x8(x);
+        for (std::size_t b = 0; b != 8; ++b) {
+          planes[b * planeBytes + g] = static_cast<unsigned char>(x >> (8 * b));
+        }
+      }
+    }
+  }
+
+  void unshuffleBlock(unsigned char const * const in,
+                      unsigned char * const out,
+                      std::size_t const n,
+                      std::size_t const size)
+  {
+    std::size_t const planeBytes = n / 8;
+    for (std::size_t j = 0; j != size; ++j) {
+      unsigned char const * const planes = in + 8 * j * planeBytes;
+      for (std::size_t g = 0; g != planeBytes; ++g) {
+        std::uint64_t x = 0u;
+        for (std::size_t b = 0; b != 8; ++b) {
+          x |= std::uint64_t(planes[b * planeBytes + g]) << (8 * b);
+        }
+        x = transpose8x8(x);
+        unsigned char * const elements = out + 8 * g * size + j;
+        for (std::size_t m = 0; m != 8; ++m) {
+          elements[m * size] = static_cast<unsigned char>(x >> (8 * m));
+        }
+      }
+    }
+  }
+
+  template <typename BLOCK_FUNC>
+  void forEachBlock(BLOCK_FUNC blockFunc,
+                    unsigned char const * in,
+                    unsigned char * out,
+                    std::size_t const nElements,
+                    std::size_t const size,
+                    std::size_t blockSize)
+  {
+    using hep_hpc::hdf5::detail::defaultBitshuffleBlock;
+    if (blockSize == 0ull) {
+      blockSize = defaultBitshuffleBlock(size);
+    }
+    std::size_t const blockBytes = blockSize * size;
+    std::size_t const nBlocks = nElements / blockSize;
+    for (std::size_t i = 0; i != nBlocks; ++i) {
+      blockFunc(in, out, blockSize, size);
+      in += blockBytes;
+      out += blockBytes;
+    }
+    std::size_t const remaining = nElements - nBlocks * blockSize;
+    std::size_t const lastBlock = remaining - remaining % 8;
+    if (lastBlock != 0ull) {
+      blockFunc(in, out, lastBlock, size);
+      in += lastBlock * size;
+      out += lastBlock * size;
+    }
+    std::memcpy(out, in, (remaining - lastBlock) * size);
+  }
+}
+
+std::size_t
+hep_hpc::hdf5::detail::defaultBitshuffleBlock(std::size_t const elementSize)
+{
+  std::size_t const blockSize = TARGET_BLOCK_BYTES / elementSize;
+  return std::max(blockSize - blockSize % 8, MIN_BLOCK);
+}
+
+void
+hep_hpc::hdf5::detail::bitshuffle(void const * const src,
+                                  void * const dest,
+                                  std::size_t const nElements,
+                                  std::size_t const elementSize,
+                                  std::size_t const blockSize)
+{
+  forEachBlock(&shuffleBlock,
+               static_cast<unsigned char const *>(src),
+               static_cast<unsigned char *>(dest),
+               nElements, elementSize, blockSize);
+}
+
+void
+hep_hpc::hdf5::detail::bitunshuffle(void const * const src,
+                                    void * const dest,
+                                    std::size_t const nElements,
+                                    std::size_t const elementSize,
+                                    std::size_t const blockSize)
+{
+  forEachBlock(&unshuffleBlock,
+               static_cast<unsigned char const *>(src),
+               static_cast<unsigned char *>(dest),
+               nElements, elementSize, blockSize);
+}
@@ -0,0 +1,49 @@
+#ifndef hep_hpc_hdf5_detail_Bitshuffle_hpp
+#define hep_hpc_hdf5_detail_Bitshuffle_hpp
+////////////////////////////////////////////////////////////////////////
+// Bit shuffle of arrays of fixed-size elements, in the format of the
+// bitshuffle HDF5 filter (ID 32008) without its own compression.
+//
+// The elements are taken in blocks of blockSize elements (a multiple of
+// 8; 0 selects defaultBitshuffleBlock()), with a final block of the
+// remaining elements rounded down to a multiple of 8. Within a block of
+// n elements, bit b of byte j of each element i is stored in bit i % 8
+// of byte (8 * j + b) * n / 8 + i / 8 of the block: the block is
+// rewritten as the 8 * elementSize bit planes of its elements, which
+// are then typically long runs of zeros (or ones) for the slowly-varying
+// high-order bits of numeric data. The final (fewer than 8) elements are
+// copied unchanged.
+//
+////////////////////////////////////////////////////////////////////////
+#include <cstddef>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      // Block size (in elements) used for blockSize 0: 8 KiB, in a
+      // multiple of 8 elements, and at least 128 elements.
+      std::size_t defaultBitshuffleBlock(std::size_t elementSize);
+
+      // Shuffle nElements elements of elementSize bytes from src to
+      // dest (which must not overlap).
+      void bitshuffle(void const * src,
+                      void * dest,
+                      std::size_t nElements,
+                      std::size_t elementSize,
+                      std::size_t blockSize = 0);
+
+      // The inverse of bitshuffle().
+      void bitunshuffle(void const * src,
+                        void * dest,
+                        std::size_t nElements,
+                        std::size_t elementSize,
+                        std::size_t blockSize = 0);
+    }
+  }
+}
+
+#endif /* hep_hpc_hdf5_detail_Bitshuffle_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
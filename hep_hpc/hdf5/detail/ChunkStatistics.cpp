@@ -0,0 +1,87 @@
+#include "hep_hpc/hdf5/detail/ChunkStatistics.hpp"
+
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+hep_hpc::hdf5::Dataset
+hep_hpc::hdf5::detail::makeStatisticsDataset(hid_t const group,
+                                             std::string const & name,
+                                             hid_t const recordType,
+                                             bool const append,
+                                             hsize_t & nRecords)
+{
+  // Cause an exception to be thrown if we have an HDF5 issue.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  nRecords = 0ull;
+  if (append &&
+      H5Lexists(group, name.c_str(), H5P_DEFAULT) > 0) {
+    Dataset dset(group, name);
+    Datatype const dtype(H5Dget_type(dset));
+    if (H5Tequal(dtype, recordType) <= 0) {
+      throw std::runtime_error("Chunk statistics for column " + name +
+                               " are of an incompatible type.");
+    }
+    Dataspace const space(H5Dget_space(dset));
+    H5Sget_simple_extent_dims(space, &nRecords, nullptr);
+    return dset;
+  }
+  hsize_t const dims = 0ull, maxdims = H5S_UNLIMITED, chunking = 1024ull;
+  PropertyList cprops(H5P_DATASET_CREATE);
+  H5Pset_chunk(cprops, 1, &chunking);
+  H5Pset_deflate(cprops, 6u);
+  return Dataset(group, name, recordType,
+                 Dataspace{1, &dims, &maxdims},
+                 {},
+                 std::move(cprops));
+}
+
+herr_t
+hep_hpc::hdf5::detail::writeStatisticsRecords(hid_t const dset,
+                                              hid_t const recordType,
+                                              void const * const records,
+                                              hsize_t const first,
+                                              hsize_t const nRecords)
+{
+  herr_t rc = 0;
+  Dataspace fileSpace(ErrorController::call(&H5Dget_space, dset));
+  hsize_t extent = 0ull;
+  if ((rc = ErrorController::call(&H5Sget_simple_extent_dims,
+                                  fileSpace, &extent, nullptr)) < 0) {
+    return rc;
+  }
+  if (first + nRecords > extent) {
+    extent = first + nRecords;
+    if ((rc = ErrorController::call(&H5Dset_extent, dset, &extent)) != 0) {
+      return rc;
+    }
+    fileSpace = Dataspace{ErrorController::call(&H5Dget_space, dset)};
+  }
+  if ((rc = ErrorController::call(&H5Sselect_hyperslab, fileSpace,
+                                  H5S_SELECT_SET, &first, nullptr,
+                                  &nRecords, nullptr)) != 0) {
+    return rc;
+  }
+  return ErrorController::call(&H5Dwrite, dset, recordType,
+                               Dataspace{1, &nRecords, &nRecords},
+                               fileSpace, H5P_DEFAULT, records);
+}
+
+herr_t
+hep_hpc::hdf5::detail::readStatisticsRecord(hid_t const dset,
+                                            hid_t const recordType,
+                                            hsize_t const index,
+                                            void * const record)
+{
+  herr_t rc = 0;
+  Dataspace fileSpace(ErrorController::call(&H5Dget_space, dset));
+  hsize_t const one = 1ull;
+  if ((rc = ErrorController::call(&H5Sselect_hyperslab, fileSpace,
+                                  H5S_SELECT_SET, &index, nullptr,
+                                  &one, nullptr)) != 0) {
+    return rc;
+  }
+  return ErrorController::call(&H5Dread, dset, recordType,
+                               Dataspace{1, &one, &one},
+                               fileSpace, H5P_DEFAULT, record);
+}
@@ -0,0 +1,248 @@
+#ifndef hep_hpc_hdf5_detail_ChunkStatistics_hpp
+#define hep_hpc_hdf5_detail_ChunkStatistics_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::ChunkStatistics<T>
+//
+// Summary statistics (minimum, maximum, sum, count of values and of
+// NaNs) of the rows of an arithmetic column, accumulated as they are
+// written, one record per chunk of the column's dataset. Records are
+// written to a dataset of compound type named for the column in the
+// Ntuple's statistics group (see NtupleOptions::setChunkStatistics()).
+// For non-arithmetic columns, all operations are no-ops.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Column.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/Datatype.hpp"
+
+#include "hdf5.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      template <typename T,
+                bool = std::is_arithmetic<T>::value &&
+                !std::is_same<T, bool>::value>
+      class ChunkStatistics;
+
+      // Name of the group (within the Ntuple's group) holding the
+      // statistics datasets.
+      constexpr char const * const STATISTICS_GROUP = "_chunk_stats";
+
+      // Create the statistics dataset name of group with records of type
+      // recordType, or open it if append is set, returning also the
+      // number of records it holds.
+      Dataset makeStatisticsDataset(hid_t group,
+                                    std::string const & name,
+                                    hid_t recordType,
+                                    bool append,
+                                    hsize_t & nRecords);
+
+      // Write nRecords records of type recordType to dset starting at
+      // record first, growing its extent if necessary.
+      herr_t writeStatisticsRecords(hid_t dset,
+                                    hid_t recordType,
+                                    void const * records,
+                                    hsize_t first,
+                                    hsize_t nRecords);
+
+      // Read record index of dset.
+      herr_t readStatisticsRecord(hid_t dset,
+                                  hid_t recordType,
+                                  hsize_t index,
+                                  void * record);
+    }
+  }
+}
+
+template <typename T>
+class hep_hpc::hdf5::detail::ChunkStatistics<T, false> {
+public:
+  static constexpr bool enabled() { return false; }
+  void open(hid_t, std::string const &, hsize_t, std::size_t, hsize_t, bool)
+    { }
+  template <typename U>
+  void accumulate(U const *, hsize_t) { }
+  herr_t write(bool) { return 0; }
+  herr_t flush() { return 0; }
+};
+
+template <typename T>
+class hep_hpc::hdf5::detail::ChunkStatistics<T, true> {
+public:
+  struct Record {
+    T min;
+    T max;
+    double sum;
+    std::uint64_t count;
+    std::uint64_t nulls;
+  };
+
+  static constexpr bool enabled() { return true; }
+
+  // Create (or, if append, open) the dataset name in group for a column
+  // with chunkRows rows per chunk and rowElements items per row, of
+  // which rowsWritten have already been written.
+  void open(hid_t group,
+            std::string const & name,
+            hsize_t chunkRows,
+            std::size_t rowElements,
+            hsize_t rowsWritten,
+            bool append);
+
+  // Add nRows rows (following those already seen) to the statistics.
+  void accumulate(T const * data, hsize_t nRows);
+
+  // Write the records of completed chunks and, if force, that of the
+  // current incomplete chunk (which will be rewritten when it is
+  // complete).
+  herr_t write(bool force);
+
+  herr_t flush()
+    { return dset_ ? dset_.flush() : 0; }
+
+private:
+  static Record emptyRecord_()
+    { return {std::numeric_limits<T>::max(),
+              std::numeric_limits<T>::lowest(), 0.0, 0ull, 0ull}; }
+
+  // Fold n items into current_.
+  void reduce_(T const * data, std::size_t n);
+
+  Dataset dset_ {};
+  Datatype recordType_ {};
+  hsize_t chunkRows_ {0ull};
+  std::size_t rowElements_ {1ull};
+  // Records of completed chunks written so far.
+  hsize_t written_ {0ull};
+  // Completed records awaiting write.
+  std::vector<Record> complete_ {};
+  Record current_ = emptyRecord_();
+  hsize_t currentRows_ {0ull};
+};
+
+template <typename T>
+void
+hep_hpc::hdf5::detail::ChunkStatistics<T, true>::
+open(hid_t const group,
+     std::string const & name,
+     hsize_t const chunkRows,
+     std::size_t const rowElements,
+     hsize_t const rowsWritten,
+     bool const append)
+{
+  chunkRows_ = (chunkRows == 0ull) ? DEFAULT_CHUNKING : chunkRows;
+  rowElements_ = rowElements;
+  hid_t const valueType = Column<T, 1ull>::engine_type(TranslationMode::NONE);
+  recordType_ = Datatype(H5Tcreate(H5T_COMPOUND, sizeof(Record)));
+  H5Tinsert(recordType_, "min", HOFFSET(Record, min), valueType);
+  H5Tinsert(recordType_, "max", HOFFSET(Record, max), valueType);
+  H5Tinsert(recordType_, "sum", HOFFSET(Record, sum), H5T_NATIVE_DOUBLE);
+  H5Tinsert(recordType_, "count", HOFFSET(Record, count), H5T_NATIVE_UINT64);
+  H5Tinsert(recordType_, "nulls", HOFFSET(Record, nulls), H5T_NATIVE_UINT64);
+  hsize_t nRecords = 0ull;
+  dset_ = makeStatisticsDataset(group, name, recordType_, append, nRecords);
+  // Resume from the rows already written.
+  written_ = rowsWritten / chunkRows_;
+  currentRows_ = rowsWritten % chunkRows_;
+  if (nRecords != written_ + ((currentRows_ == 0ull) ? 0ull : 1ull)) {
+    throw std::runtime_error("Chunk statistics for column " + name +
+                             " do not match the rows already written.");
+  }
+  if (currentRows_ != 0ull &&
+      readStatisticsRecord(dset_, recordType_, written_, &current_) != 0) {
+    throw std::runtime_error("Unable to read chunk statistics for column " +
+                             name + ".");
+  }
+}
+
+template <typename T>
+void
+hep_hpc::hdf5::detail::ChunkStatistics<T, true>::
+accumulate(T const * data, hsize_t nRows)
+{
+  if (!dset_) {
+    return;
+  }
+  while (nRows != 0ull) {
+    hsize_t const n = std::min(nRows, chunkRows_ - currentRows_);
+    reduce_(data, n * rowElements_);
+    data += n * rowElements_;
+    nRows -= n;
+    if ((currentRows_ += n) == chunkRows_) {
+      complete_.push_back(current_);
+      current_ = emptyRecord_();
+      currentRows_ = 0ull;
+    }
+  }
+}
+
+template <typename T>
+herr_t
+hep_hpc::hdf5::detail::ChunkStatistics<T, true>::write(bool const force)
+{
+  herr_t rc = 0;
+  if (!complete_.empty()) {
+    if ((rc = writeStatisticsRecords(dset_, recordType_, complete_.data(),
+                                     written_, complete_.size())) != 0) {
+      return rc;
+    }
+    written_ += complete_.size();
+    complete_.clear();
+  }
+  if (force && currentRows_ != 0ull) {
+    rc = writeStatisticsRecords(dset_, recordType_, &current_, written_, 1ull);
+  }
+  return rc;
+}
+
+template <typename T>
+void
+hep_hpc::hdf5::detail::ChunkStatistics<T, true>::
+reduce_(T const * const data, std::size_t const n)
+{
+  // Simple loops over contiguous data, amenable to vectorization.
+  std::uint64_t nulls = 0ull;
+  if (std::is_floating_point<T>::value) {
+    for (std::size_t i = 0; i != n; ++i) {
+      nulls += (data[i] != data[i]);
+    }
+  }
+  T lo = current_.min, hi = current_.max;
+  double sum = 0.0;
+  if (nulls == 0ull) {
+    for (std::size_t i = 0; i != n; ++i) {
+      lo = std::min(lo, data[i]);
+      hi = std::max(hi, data[i]);
+      sum += data[i];
+    }
+  } else {
+    for (std::size_t i = 0; i != n; ++i) {
+      if (data[i] == data[i]) {
+        lo = std::min(lo, data[i]);
+        hi = std::max(hi, data[i]);
+        sum += data[i];
+      }
+    }
+  }
+  current_.min = lo;
+  current_.max = hi;
+  current_.sum += sum;
+  current_.count += n - nulls;
+  current_.nulls += nulls;
+}
+
+#endif /* hep_hpc_hdf5_detail_ChunkStatistics_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
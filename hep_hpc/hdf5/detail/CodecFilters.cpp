@@ -0,0 +1,368 @@
+#include "hep_hpc/hdf5/detail/CodecFilters.hpp"
+#include "hep_hpc/detail/config.hpp"
+#include "hep_hpc/hdf5/Codec.hpp"
+#include "hep_hpc/hdf5/detail/Bitshuffle.hpp"
+
+#ifdef HEP_HPC_USE_ZLIB
+#include "zlib.h"
+#endif
+#ifdef HEP_HPC_USE_ZSTD
+#include "zstd.h"
+#endif
+#ifdef HEP_HPC_USE_LZ4
+#include "lz4.h"
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace {
+  // Bitshuffle filter 32008, without compression: cd_values[0-1] are
+  // the format version, cd_values[2] the element size and cd_values[3]
+  // (if present and non-zero) the block size in elements; a non-zero
+  // cd_values[4] (compression within the filter) is not supported.
+  constexpr unsigned int BITSHUFFLE_VERSION_MAJOR = 0u;
+  constexpr unsigned int BITSHUFFLE_VERSION_MINOR = 3u;
+  constexpr std::size_t MAX_BITSHUFFLE_VALUES = 8ull;
+  using hep_hpc::hdf5::H5Z_FILTER_BITSHUFFLE;
+
+  herr_t bitshuffleSetLocal(hid_t const dcpl, hid_t const type, hid_t)
+  {
+    unsigned int flags;
+    std::size_t nValues = MAX_BITSHUFFLE_VALUES - 3;
+    unsigned int userValues[MAX_BITSHUFFLE_VALUES - 3] {};
+    if (H5Pget_filter_by_id2(dcpl, H5Z_FILTER_BITSHUFFLE, &flags, &nValues,
+                             userValues, 0, nullptr, nullptr) < 0) {
+      return -1;
+    }
+    // Any values given (block size, compression) follow the three
+    // reserved ones.
+    unsigned int values[MAX_BITSHUFFLE_VALUES] {BITSHUFFLE_VERSION_MAJOR,
+        BITSHUFFLE_VERSION_MINOR,
+        static_cast<unsigned int>(H5Tget_size(type))};
+    nValues = std::min(nValues, MAX_BITSHUFFLE_VALUES - 3);
+    std::copy(userValues, userValues + nValues, values + 3);
+    if ((nValues > 0 && values[3] % 8u != 0u) ||
+        (nValues > 1 && values[4] != 0u) ||
+        values[2] == 0u) {
+      return -1;
+    }
+    return H5Pmodify_filter(dcpl, H5Z_FILTER_BITSHUFFLE, flags, nValues + 3,
+                            values);
+  }
+
+  std::size_t bitshuffleFilter(unsigned int const flags,
+                               std::size_t const cd_nelmts,
+                               unsigned int const cd_values[],
+                               std::size_t const nbytes,
+                               std::size_t * const buf_size,
+                               void ** const buf)
+  {
+    if (cd_nelmts < 3 || cd_values[2] == 0u ||
+        (cd_nelmts > 3 && cd_values[3] % 8u != 0u) ||
+        (cd_nelmts > 4 && cd_values[4] != 0u) ||
+        nbytes % cd_values[2] != 0u) {
+      return 0;
+    }
+    std::size_t const elementSize = cd_values[2];
+    std::size_t const blockSize = (cd_nelmts > 3) ? cd_values[3] : 0u;
+    void * const result = H5allocate_memory(nbytes, false);
+    if (result == nullptr) {
+      return 0;
+    }
+    if (flags & H5Z_FLAG_REVERSE) {
+      hep_hpc::hdf5::detail::bitunshuffle(*buf, result, nbytes / elementSize,
+                                          elementSize, blockSize);
+    } else {
+      hep_hpc::hdf5::detail::bitshuffle(*buf, result, nbytes / elementSize,
+                                        elementSize, blockSize);
+    }
+    H5free_memory(*buf);
+    *buf = result;
+    *buf_size = nbytes;
+    return nbytes;
+  }
+
+#ifdef HEP_HPC_USE_ZSTD
+  // ZSTD filter 32015: the chunk is a single Zstandard frame;
+  // cd_values[0] is the compression level.
+  constexpr int DEFAULT_ZSTD_LEVEL = 3;
+
+  void zstdEncode(int const level, void const * const src,
+                  std::size_t const nBytes,
+                  std::vector<unsigned char> & out)
+  {
+    out.resize(ZSTD_compressBound(nBytes));
+    std::size_t const n =
+      ZSTD_compress(out.data(), out.size(), src, nBytes, level);
+    if (ZSTD_isError(n)) {
+      throw std::runtime_error(std::string("ZSTD compression failure: ") +
+                               ZSTD_getErrorName(n));
+    }
+    out.resize(n);
+  }
+
+  std::size_t zstdFilter(unsigned int const flags,
+                         std::size_t const cd_nelmts,
+                         unsigned int const cd_values[],
+                         std::size_t const nbytes,
+                         std::size_t * const buf_size,
+                         void ** const buf)
+  {
+    void * result = nullptr;
+    std::size_t resultSize = 0ull;
+    if (flags & H5Z_FLAG_REVERSE) {
+      unsigned long long const size =
+        ZSTD_getFrameContentSize(*buf, nbytes);
+      if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR) {
+        return 0;
+      }
+      result = H5allocate_memory(size, false);
+      if (result == nullptr) {
+        return 0;
+      }
+      resultSize = ZSTD_decompress(result, size, *buf, nbytes);
+      if (ZSTD_isError(resultSize)) {
+        H5free_memory(result);
+        return 0;
+      }
+    } else {
+      int const level = (cd_nelmts > 0 && cd_values[0] > 0) ?
+        static_cast<int>(cd_values[0]) : DEFAULT_ZSTD_LEVEL;
+      std::vector<unsigned char> out;
+      try {
+        zstdEncode(level, *buf, nbytes, out);
+      }
+      catch (std::exception const &) {
+        return 0;
+      }
+      result = H5allocate_memory(out.size(), false);
+      if (result == nullptr) {
+        return 0;
+      }
+      std::memcpy(result, out.data(), out.size());
+      resultSize = out.size();
+    }
+    H5free_memory(*buf);
+    *buf = result;
+    *buf_size = resultSize;
+    return resultSize;
+  }
+#endif
+
+#ifdef HEP_HPC_USE_LZ4
+  // LZ4 filter 32004: a header of the uncompressed size (8 bytes) and
+  // block size (4 bytes), then for each block its compressed size (4
+  // bytes) and data, stored uncompressed if compression would not
+  // reduce its size. All integers are big-endian. cd_values[0], if
+  // non-zero, is the block size.
+  constexpr std::size_t DEFAULT_LZ4_BLOCK = 1ull << 30;
+
+  void putBE(unsigned char * out, std::uint64_t value, std::size_t nBytes)
+  {
+    for (std::size_t i = nBytes; i != 0; --i) {
+      out[i - 1] = static_cast<unsigned char>(value & 0xffu);
+      value >>= 8;
+    }
+  }
+
+  std::uint64_t getBE(unsigned char const * in, std::size_t nBytes)
+  {
+    std::uint64_t value = 0u;
+    for (std::size_t i = 0; i != nBytes; ++i) {
+      value = (value << 8) | in[i];
+    }
+    return value;
+  }
+
+  void lz4Encode(std::size_t blockSize, void const * const src,
+                 std::size_t const nBytes,
+                 std::vector<unsigned char> & out)
+  {
+    if (blockSize == 0ull) {
+      blockSize = DEFAULT_LZ4_BLOCK;
+    }
+    blockSize = std::min(blockSize, std::max(nBytes, std::size_t(1)));
+    std::size_t const nBlocks = (nBytes + blockSize - 1) / blockSize;
+    out.resize(12 + nBlocks * (4 + LZ4_compressBound(blockSize)));
+    putBE(out.data(), nBytes, 8);
+    putBE(out.data() + 8, blockSize, 4);
+    auto in = static_cast<char const *>(src);
+    std::size_t pos = 12;
+    for (std::size_t done = 0; done != nBytes; ) {
+      int const n = static_cast<int>(std::min(blockSize, nBytes - done));
+      int compressed =
+        LZ4_compress_default(in + done,
+                             reinterpret_cast<char *>(out.data() + pos + 4),
+                             n, LZ4_compressBound(n));
+      if (compressed <= 0 || compressed >= n) {
+        // Store uncompressed.
+        std::memcpy(out.data() + pos + 4, in + done, n);
+        compressed = n;
+      }
+      putBE(out.data() + pos, compressed, 4);
+      pos += 4 + compressed;
+      done += n;
+    }
+    out.resize(pos);
+  }
+
+  std::size_t lz4Filter(unsigned int const flags,
+                        std::size_t const cd_nelmts,
+                        unsigned int const cd_values[],
+                        std::size_t const nbytes,
+                        std::size_t * const buf_size,
+                        void ** const buf)
+  {
+    void * result = nullptr;
+    std::size_t resultSize = 0ull;
+    if (flags & H5Z_FLAG_REVERSE) {
+      auto const in = static_cast<unsigned char const *>(*buf);
+      if (nbytes < 12) {
+        return 0;
+      }
+      resultSize = getBE(in, 8);
+      std::size_t const blockSize = getBE(in + 8, 4);
+      result = H5allocate_memory(resultSize, false);
+      if (result == nullptr) {
+        return 0;
+      }
+      auto const out = static_cast<char *>(result);
+      std::size_t pos = 12;
+      for (std::size_t done = 0; done != resultSize; ) {
+        std::size_t const n = std::min(blockSize, resultSize - done);
+        if (pos + 4 > nbytes) {
+          H5free_memory(result);
+          return 0;
+        }
+        std::size_t const compressed = getBE(in + pos, 4);
+        pos += 4;
+        if (pos + compressed > nbytes) {
+          H5free_memory(result);
+          return 0;
+        }
+        if (compressed == n) {
+          std::memcpy(out + done, in + pos, n);
+        } else if (LZ4_decompress_safe(reinterpret_cast<char const *>(in + pos),
+                                       out + done,
+                                       static_cast<int>(compressed),
+                                       static_cast<int>(n)) !=
+                   static_cast<int>(n)) {
+          H5free_memory(result);
+          return 0;
+        }
+        pos += compressed;
+        done += n;
+      }
+    } else {
+      std::vector<unsigned char> out;
+      try {
+        lz4Encode((cd_nelmts > 0) ? cd_values[0] : 0u, *buf, nbytes, out);
+      }
+      catch (std::exception const &) {
+        return 0;
+      }
+      result = H5allocate_memory(out.size(), false);
+      if (result == nullptr) {
+        return 0;
+      }
+      std::memcpy(result, out.data(), out.size());
+      resultSize = out.size();
+    }
+    H5free_memory(*buf);
+    *buf = result;
+    *buf_size = resultSize;
+    return resultSize;
+  }
+#endif
+}
+
+void
+hep_hpc::hdf5::detail::registerCodecFilters()
+{
+  static std::once_flag registered;
+  std::call_once(registered, []
+    {
+      H5Z_class2_t const bitshuffle {H5Z_CLASS_T_VERS, H5Z_FILTER_BITSHUFFLE,
+          1, 1, "Bitshuffle (hep_hpc)", nullptr, &bitshuffleSetLocal,
+          &bitshuffleFilter};
+      H5Zregister(&bitshuffle);
+#ifdef HEP_HPC_USE_ZSTD
+      H5Z_class2_t const zstd {H5Z_CLASS_T_VERS, H5Z_FILTER_ZSTD, 1, 1,
+          "Zstandard compression (hep_hpc)", nullptr, nullptr, &zstdFilter};
+      H5Zregister(&zstd);
+#endif
+#ifdef HEP_HPC_USE_LZ4
+      H5Z_class2_t const lz4 {H5Z_CLASS_T_VERS, H5Z_FILTER_LZ4, 1, 1,
+          "LZ4 compression (hep_hpc)", nullptr, nullptr, &lz4Filter};
+      H5Zregister(&lz4);
+#endif
+    });
+}
+
+bool
+hep_hpc::hdf5::detail::canCompressChunk(H5Z_filter_t const filter)
+{
+  switch (filter) {
+#ifdef HEP_HPC_USE_ZLIB
+  case H5Z_FILTER_DEFLATE:
+    return true;
+#endif
+#ifdef HEP_HPC_USE_ZSTD
+  case H5Z_FILTER_ZSTD:
+    return true;
+#endif
+#ifdef HEP_HPC_USE_LZ4
+  case H5Z_FILTER_LZ4:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+void
+hep_hpc::hdf5::detail::compressChunk(H5Z_filter_t const filter,
+                                     unsigned int const value,
+                                     void const * const src,
+                                     std::size_t const nBytes,
+                                     std::vector<unsigned char> & out)
+{
+  switch (filter) {
+#ifdef HEP_HPC_USE_ZLIB
+  case H5Z_FILTER_DEFLATE:
+  {
+    uLongf n = compressBound(nBytes);
+    out.resize(n);
+    if (compress2(out.data(), &n, static_cast<Bytef const *>(src), nBytes,
+                  static_cast<int>(value)) != Z_OK) {
+      throw std::runtime_error("Chunk compression failure.");
+    }
+    out.resize(n);
+    return;
+  }
+#endif
+#ifdef HEP_HPC_USE_ZSTD
+  case H5Z_FILTER_ZSTD:
+    zstdEncode((value > 0u) ? static_cast<int>(value) : DEFAULT_ZSTD_LEVEL,
+               src, nBytes, out);
+    return;
+#endif
+#ifdef HEP_HPC_USE_LZ4
+  case H5Z_FILTER_LZ4:
+    lz4Encode(value, src, nBytes, out);
+    return;
+#endif
+  default:
+    (void) value;
+    (void) src;
+    (void) nBytes;
+    (void) out;
+    throw std::runtime_error("Unsupported filter for chunk compression: " +
+                             std::to_string(filter));
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef hep_hpc_hdf5_detail_CodecFilters_hpp
+#define hep_hpc_hdf5_detail_CodecFilters_hpp
+////////////////////////////////////////////////////////////////////////
+// Built-in implementations of the compression codecs of
+// hep_hpc/hdf5/Codec.hpp: HDF5 filters for ZSTD and LZ4 (if built), and
+// compression of whole chunks for direct chunk writing (see
+// configureDirectChunkWrite() in
+// hep_hpc/hdf5/detail/NtupleDataStructure.hpp).
+//
+////////////////////////////////////////////////////////////////////////
+#include "hdf5.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      // Register the built-in filters with HDF5 (once).
+      void registerCodecFilters();
+
+      // Whether compressChunk() supports filter.
+      bool canCompressChunk(H5Z_filter_t filter);
+
+      // Compress nBytes bytes from src as filter would with parameter
+      // value (its first client data value, if any), replacing the
+      // contents of out. Throws std::runtime_error on failure.
+      void compressChunk(H5Z_filter_t filter, unsigned int value,
+                         void const * src, std::size_t nBytes,
+                         std::vector<unsigned char> & out);
+    }
+  }
+}
+
+#endif /* hep_hpc_hdf5_detail_CodecFilters_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
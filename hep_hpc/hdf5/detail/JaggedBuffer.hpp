@@ -0,0 +1,91 @@
+#ifndef hep_hpc_hdf5_detail_JaggedBuffer_hpp
+#define hep_hpc_hdf5_detail_JaggedBuffer_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::JaggedBuffer<T>
+//
+// Buffer for the contents of a jagged column (see
+// hep_hpc/hdf5/JaggedColumn.hpp): the values of all rows are stored
+// contiguously in a single pool, with a vector of the offset of each
+// row into it. As for StringArena, clear() retains the storage, so that
+// once the pool has grown to hold a full buffer no further allocation
+// is required.
+//
+// data() provides an array of one jagged_span<T> per row, valid until
+// the next modification of the buffer.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/JaggedColumn.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      template <typename T>
+      class JaggedBuffer;
+    }
+  }
+}
+
+template <typename T>
+class hep_hpc::hdf5::detail::JaggedBuffer {
+public:
+  // Number of rows.
+  std::size_t size() const { return offsets_.size(); }
+
+  void reserve(std::size_t nRows) { offsets_.reserve(nRows); }
+
+  // Memory allocated, in bytes.
+  std::size_t capacityBytes() const
+    { return values_.capacity() * sizeof(T) +
+        offsets_.capacity() * sizeof(std::size_t) +
+        spans_.capacity() * sizeof(jagged_span<T>); }
+
+  // Remove all rows, retaining storage.
+  void clear() { values_.clear(); offsets_.clear(); }
+
+  // Append n rows (nullptr: n empty rows).
+  void append(jagged_span<T> const * rows, std::size_t n);
+
+  jagged_span<T> const * data();
+
+private:
+  std::vector<T> values_ {};
+  std::vector<std::size_t> offsets_ {};
+  std::vector<jagged_span<T> > spans_ {};
+};
+
+template <typename T>
+inline
+void
+hep_hpc::hdf5::detail::JaggedBuffer<T>::
+append(jagged_span<T> const * const rows, std::size_t const n)
+{
+  for (std::size_t i = 0; i != n; ++i) {
+    offsets_.push_back(values_.size());
+    if (rows != nullptr && rows[i].size != 0ull) {
+      values_.insert(values_.end(), rows[i].data, rows[i].data + rows[i].size);
+    }
+  }
+}
+
+template <typename T>
+inline
+hep_hpc::hdf5::jagged_span<T> const *
+hep_hpc::hdf5::detail::JaggedBuffer<T>::data()
+{
+  spans_.resize(offsets_.size());
+  for (std::size_t i = 0; i != offsets_.size(); ++i) {
+    std::size_t const end =
+      (i + 1 == offsets_.size()) ? values_.size() : offsets_[i + 1];
+    spans_[i] = {values_.data() + offsets_[i], end - offsets_[i]};
+  }
+  return spans_.data();
+}
+
+#endif /* hep_hpc_hdf5_detail_JaggedBuffer_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,80 @@
+#include "hep_hpc/hdf5/detail/JaggedValues.hpp"
+
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/Datatype.hpp"
+#include "hep_hpc/hdf5/Group.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <stdexcept>
+
+hep_hpc::hdf5::Dataset
+hep_hpc::hdf5::detail::makeJaggedValuesDataset(hid_t const group,
+                                               std::string const & name,
+                                               hid_t const fileType,
+                                               hsize_t const valuesPerChunk,
+                                               bool const append,
+                                               hsize_t & nValues,
+                                               ChunkCacheReservation & reservation)
+{
+  // Cause an exception to be thrown if we have an HDF5 issue.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  nValues = 0ull;
+  bool const exists = (H5Lexists(group, JAGGED_GROUP, H5P_DEFAULT) > 0);
+  Group const values(group, JAGGED_GROUP,
+                     exists ? Group::OPEN_MODE : Group::CREATE_MODE);
+  if (append) {
+    if (!exists || H5Lexists(values, name.c_str(), H5P_DEFAULT) <= 0) {
+      throw std::runtime_error("Cannot append to jagged column " + name +
+                               ": no values found.");
+    }
+    Dataset dset = openDatasetWithChunkCache(values, name,
+                                             ChunkAccess::APPEND,
+                                             reservation);
+    Datatype const dtype(H5Dget_type(dset));
+    if (H5Tequal(dtype, fileType) <= 0) {
+      throw std::runtime_error("Values of jagged column " + name +
+                               " are of an incompatible type.");
+    }
+    Dataspace const space(H5Dget_space(dset));
+    H5Sget_simple_extent_dims(space, &nValues, nullptr);
+    return dset;
+  }
+  hsize_t const dims = 0ull, maxdims = H5S_UNLIMITED;
+  hsize_t const chunking = (valuesPerChunk == 0ull) ?
+    DEFAULT_JAGGED_CHUNKING : valuesPerChunk;
+  PropertyList cprops(H5P_DATASET_CREATE);
+  H5Pset_chunk(cprops, 1, &chunking);
+  H5Pset_deflate(cprops, 6u);
+  PropertyList aprops =
+    chunkCacheProperties(chunkSizeBytes(cprops, fileType),
+                         ChunkAccess::APPEND, reservation);
+  return Dataset(values, name, fileType,
+                 Dataspace{1, &dims, &maxdims},
+                 {},
+                 std::move(cprops),
+                 std::move(aprops));
+}
+
+herr_t
+hep_hpc::hdf5::detail::writeJaggedValues(hid_t const dset,
+                                         hid_t const memType,
+                                         void const * const values,
+                                         hsize_t const first,
+                                         hsize_t const nValues)
+{
+  herr_t rc = 0;
+  hsize_t const extent = first + nValues;
+  if ((rc = ErrorController::call(&H5Dset_extent, dset, &extent)) != 0) {
+    return rc;
+  }
+  Dataspace fileSpace(ErrorController::call(&H5Dget_space, dset));
+  if ((rc = ErrorController::call(&H5Sselect_hyperslab, fileSpace,
+                                  H5S_SELECT_SET, &first, nullptr,
+                                  &nValues, nullptr)) != 0) {
+    return rc;
+  }
+  return ErrorController::call(&H5Dwrite, dset, memType,
+                               Dataspace{1, &nValues, &nValues},
+                               fileSpace, H5P_DEFAULT, values);
+}
@@ -0,0 +1,128 @@
+#ifndef hep_hpc_hdf5_detail_JaggedValues_hpp
+#define hep_hpc_hdf5_detail_JaggedValues_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::JaggedValues<T>
+//
+// The values dataset of a jagged column (see
+// hep_hpc/hdf5/JaggedColumn.hpp). write() appends the values of a
+// number of rows to the dataset (whose extent always matches the
+// values written) and computes the corresponding cumulative offsets
+// for the column's own dataset.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/ChunkCache.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/JaggedColumn.hpp"
+
+#include "hdf5.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      template <typename T>
+      class JaggedValues;
+
+      // Name of the group (within the Ntuple's group) holding the values
+      // datasets.
+      constexpr char const * const JAGGED_GROUP = "_jagged";
+
+      // Create the values dataset name of group with values of type
+      // fileType, or open it if append is set, returning also the
+      // number of values it holds. Its chunk cache (see
+      // hep_hpc/hdf5/ChunkCache.hpp) is reserved in reservation.
+      Dataset makeJaggedValuesDataset(hid_t group,
+                                      std::string const & name,
+                                      hid_t fileType,
+                                      hsize_t valuesPerChunk,
+                                      bool append,
+                                      hsize_t & nValues,
+                                      ChunkCacheReservation & reservation);
+
+      // Write nValues values of type memType to dset starting at value
+      // first, growing its extent to match.
+      herr_t writeJaggedValues(hid_t dset,
+                               hid_t memType,
+                               void const * values,
+                               hsize_t first,
+                               hsize_t nValues);
+    }
+  }
+}
+
+template <typename T>
+class hep_hpc::hdf5::detail::JaggedValues {
+public:
+  // Create (or, if append, open) the values dataset of col in group.
+  template <typename COL>
+  void open(hid_t group, COL const & col, TranslationMode mode, bool append)
+    { dset_ = makeJaggedValuesDataset(group, col.name(), col.value_type(mode),
+                                      col.valuesPerChunk(), append,
+                                      written_, cacheReservation_); }
+
+  // Write the values of nRows rows, and compute their offsets.
+  herr_t write(jagged_span<T> const * rows, hsize_t nRows);
+
+  // The offsets of the rows of the last write().
+  std::vector<std::uint64_t> const & offsets() const { return offsets_; }
+
+private:
+  ChunkCacheReservation cacheReservation_ {};
+  Dataset dset_ {};
+  // Values written so far.
+  hsize_t written_ {0ull};
+  std::vector<std::uint64_t> offsets_ {};
+  // Values gathered from non-contiguous rows.
+  std::vector<T> scratch_ {};
+};
+
+template <typename T>
+herr_t
+hep_hpc::hdf5::detail::JaggedValues<T>::
+write(jagged_span<T> const * const rows, hsize_t const nRows)
+{
+  // Offsets, and whether the values are already contiguous in memory
+  // (as they are in a JaggedBuffer).
+  offsets_.resize(nRows);
+  T const * base = nullptr;
+  bool contiguous = true;
+  hsize_t total = 0ull;
+  for (hsize_t i = 0ull; i != nRows; ++i) {
+    if (rows[i].size != 0ull) {
+      if (base == nullptr) { // First non-empty row: total is 0.
+        base = rows[i].data;
+      } else if (rows[i].data != base + total) {
+        contiguous = false;
+      }
+    }
+    total += rows[i].size;
+    offsets_[i] = written_ + total;
+  }
+  if (total == 0ull) {
+    return 0;
+  }
+  if (!contiguous) {
+    scratch_.clear();
+    for (hsize_t i = 0ull; i != nRows; ++i) {
+      scratch_.insert(scratch_.end(), rows[i].data, rows[i].data + rows[i].size);
+    }
+    base = scratch_.data();
+  }
+  herr_t const rc =
+    writeJaggedValues(dset_, JaggedColumn<T>::value_type(), base,
+                      written_, total);
+  if (rc == 0) {
+    written_ += total;
+  }
+  return rc;
+}
+
+#endif /* hep_hpc_hdf5_detail_JaggedValues_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,427 @@
+#include "hep_hpc/hdf5/detail/KeyIndex.hpp"
+
+#include "hep_hpc/hdf5/Column.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/Datatype.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/Group.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/Resource.hpp"
+#include "hep_hpc/hdf5/detail/NtupleDataStructure.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/write_attribute.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+  // Rows of the key columns read at a time while building the index.
+  constexpr hsize_t READ_ROWS = 1ull << 20;
+
+  // Minimum records of each run read at a time while merging.
+  constexpr hsize_t MIN_MERGE_ROWS = 1024ull;
+
+  void writeCount(hid_t const group, char const * const name,
+                  hsize_t const value)
+  {
+    std::uint64_t const v = value;
+    hep_hpc::hdf5::Resource attr
+      (hep_hpc::hdf5::ErrorController::call(&H5Acreate, group, name,
+                                            H5T_STD_U64LE,
+                                            hep_hpc::hdf5::Dataspace{H5S_SCALAR},
+                                            H5P_DEFAULT, H5P_DEFAULT),
+       &H5Aclose);
+    hep_hpc::hdf5::ErrorController::call(&H5Awrite, *attr,
+                                         H5T_NATIVE_UINT64, &v);
+  }
+
+  // Create a chunked, compressed dataset of the given dimensions.
+  hep_hpc::hdf5::Dataset makeArray(hid_t const group, char const * const name,
+                                   hid_t const fileType,
+                                   std::vector<hsize_t> const & dims)
+  {
+    using namespace hep_hpc::hdf5;
+    PropertyList cprops(H5P_DATASET_CREATE);
+    if (dims[0] != 0ull) {
+      auto chunking = dims;
+      chunking[0] = std::min(dims[0], hsize_t(DEFAULT_CHUNKING * 32ull));
+      H5Pset_chunk(cprops, chunking.size(), chunking.data());
+      H5Pset_deflate(cprops, 6u);
+    }
+    return Dataset(group, name, fileType,
+                   Dataspace{static_cast<int>(dims.size()), dims.data()},
+                   {}, std::move(cprops));
+  }
+
+  // Select rows [first, first + n) of a dataset of one or two
+  // dimensions (of width columns).
+  hep_hpc::hdf5::Dataspace selectRows(hid_t const dset,
+                                      hsize_t const first,
+                                      hsize_t const n,
+                                      hsize_t const width)
+  {
+    using namespace hep_hpc::hdf5;
+    Dataspace fileSpace(ErrorController::call(&H5Dget_space, dset));
+    hsize_t const offsets[2] {first, 0ull};
+    hsize_t const counts[2] {n, width};
+    ErrorController::call(&H5Sselect_hyperslab, fileSpace, H5S_SELECT_SET,
+                          offsets, nullptr, counts, nullptr);
+    return fileSpace;
+  }
+
+  herr_t writeSlab(hep_hpc::hdf5::Dataset & dset, hid_t const memType,
+                   hsize_t const first, hsize_t const n, hsize_t const width,
+                   void const * const data)
+  {
+    using namespace hep_hpc::hdf5;
+    hsize_t const counts[2] {n, width};
+    int const rank = (width == 0ull) ? 1 : 2;
+    return dset.write(memType, data, Dataspace{rank, counts, counts},
+                      selectRows(dset, first, n, width));
+  }
+
+  herr_t readSlab(hep_hpc::hdf5::Dataset & dset, hid_t const memType,
+                  hsize_t const first, hsize_t const n, hsize_t const width,
+                  void * const data)
+  {
+    using namespace hep_hpc::hdf5;
+    hsize_t const counts[2] {n, width};
+    return dset.read(memType, data, Dataspace{2, counts, counts},
+                     selectRows(dset, first, n, width));
+  }
+
+  // Read the keys of rows [start, start + n) and sort them into records
+  // of nKeys keys followed by the row number.
+  void sortRun(hid_t const group,
+               std::vector<std::string> const & keyColumns,
+               hsize_t const start, hsize_t const n,
+               std::vector<std::vector<long long> > & keys,
+               std::vector<long long> & records)
+  {
+    std::size_t const nKeys = keyColumns.size();
+    for (std::size_t k = 0; k != nKeys; ++k) {
+      keys[k].resize(n);
+      if (hep_hpc::hdf5::detail::readKeyColumn(group, keyColumns[k], start,
+                                               n, keys[k].data()) != 0) {
+        throw std::runtime_error("Unable to read key column " +
+                                 keyColumns[k] + ".");
+      }
+    }
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), std::size_t(0ull));
+    std::stable_sort(order.begin(), order.end(),
+                     [&keys](std::size_t const i, std::size_t const j)
+                     {
+                       for (auto const & key : keys) {
+                         if (key[i] != key[j]) {
+                           return key[i] < key[j];
+                         }
+                       }
+                       return false;
+                     });
+    std::size_t const width = nKeys + 1ull;
+    records.resize(n * width);
+    for (hsize_t i = 0ull; i != n; ++i) {
+      for (std::size_t k = 0; k != nKeys; ++k) {
+        records[i * width + k] = keys[k][order[i]];
+      }
+      records[i * width + nKeys] = static_cast<long long>(start + order[i]);
+    }
+  }
+
+  // Write n records to rows [first, first + n) of the keys and rows
+  // datasets of the index.
+  void writeRecords(hep_hpc::hdf5::Dataset & keysOut,
+                    hep_hpc::hdf5::Dataset & rowsOut,
+                    hsize_t const first, hsize_t const n,
+                    std::size_t const nKeys, long long const * const records,
+                    std::vector<long long> & outKeys,
+                    std::vector<std::uint64_t> & outRows)
+  {
+    std::size_t const width = nKeys + 1ull;
+    outKeys.resize(n * nKeys);
+    outRows.resize(n);
+    for (hsize_t i = 0ull; i != n; ++i) {
+      std::copy(records + i * width, records + i * width + nKeys,
+                outKeys.begin() + i * nKeys);
+      outRows[i] = static_cast<std::uint64_t>(records[i * width + nKeys]);
+    }
+    if (writeSlab(keysOut, H5T_NATIVE_LLONG, first, n, nKeys,
+                  outKeys.data()) != 0 ||
+        writeSlab(rowsOut, H5T_NATIVE_UINT64, first, n, 0ull,
+                  outRows.data()) != 0) {
+      throw std::runtime_error("Unable to write key index.");
+    }
+  }
+
+  // A temporary HDF5 file alongside that of the table, holding the
+  // sorted runs of a dense index being built; removed on destruction.
+  class ScratchFile {
+  public:
+    explicit ScratchFile(hid_t const group)
+      : name_(scratchName(group)),
+        file_(name_, H5F_ACC_TRUNC)
+    {
+    }
+
+    ~ScratchFile()
+    {
+      file_.close();
+      std::remove(name_.c_str());
+    }
+
+    ScratchFile(ScratchFile const &) = delete;
+    ScratchFile & operator = (ScratchFile const &) = delete;
+
+    hep_hpc::hdf5::File const & file() const { return file_; }
+
+  private:
+    static std::string scratchName(hid_t const group)
+    {
+      ssize_t const size = H5Fget_name(group, nullptr, 0);
+      if (size <= 0) {
+        throw std::runtime_error("Unable to obtain file name for key index.");
+      }
+      std::string result(size, '\0');
+      H5Fget_name(group, &result[0], size + 1);
+      return result + ".key_index.tmp";
+    }
+
+    std::string name_;
+    hep_hpc::hdf5::File file_;
+  };
+
+  // Lexicographic comparison of the key of row i of the column-wise
+  // keys with another.
+  int compareRows(std::vector<std::vector<long long> > const & keys,
+                  std::size_t const i,
+                  std::vector<long long> const & other)
+  {
+    for (std::size_t k = 0; k != keys.size(); ++k) {
+      if (keys[k][i] != other[k]) {
+        return (keys[k][i] < other[k]) ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+}
+
+void
+hep_hpc::hdf5::detail::writeKeyIndex(hid_t const group,
+                                     std::vector<std::string> const & keyColumns,
+                                     hsize_t const nRows,
+                                     hsize_t runRows)
+{
+  // Cause an exception to be thrown if we have an HDF5 issue.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  if (H5Lexists(group, KEY_INDEX_GROUP, H5P_DEFAULT) > 0) {
+    H5Ldelete(group, KEY_INDEX_GROUP, H5P_DEFAULT);
+  }
+  std::size_t const nKeys = keyColumns.size();
+  hsize_t blockRows = keyChunkRows(group, keyColumns.front());
+  if (blockRows == 0ull) {
+    blockRows = DEFAULT_CHUNKING;
+  }
+  hsize_t const nBlocks = (nRows + blockRows - 1ull) / blockRows;
+  // First pass: are the rows sorted by key? Note the first and last key
+  // of each block in case.
+  std::vector<long long> first(nBlocks * nKeys), last(nBlocks * nKeys);
+  std::vector<std::vector<long long> > keys(nKeys);
+  std::vector<long long> previous;
+  bool sorted = true;
+  for (hsize_t start = 0ull; sorted && start < nRows; start += READ_ROWS) {
+    hsize_t const n = std::min(READ_ROWS, nRows - start);
+    for (std::size_t k = 0; k != nKeys; ++k) {
+      keys[k].resize(n);
+      if (readKeyColumn(group, keyColumns[k], start, n, keys[k].data()) != 0) {
+        throw std::runtime_error("Unable to read key column " +
+                                 keyColumns[k] + ".");
+      }
+    }
+    for (hsize_t i = 0ull; i != n; ++i) {
+      if (!previous.empty() && compareRows(keys, i, previous) < 0) {
+        sorted = false;
+        break;
+      }
+      previous.resize(nKeys);
+      for (std::size_t k = 0; k != nKeys; ++k) {
+        previous[k] = keys[k][i];
+      }
+      hsize_t const row = start + i;
+      if (row % blockRows == 0ull) {
+        std::copy(previous.cbegin(), previous.cend(),
+                  first.begin() + (row / blockRows) * nKeys);
+      }
+      std::copy(previous.cbegin(), previous.cend(),
+                last.begin() + (row / blockRows) * nKeys);
+    }
+  }
+  Group const index(group, KEY_INDEX_GROUP);
+  write_attribute(index, "columns", keyColumns);
+  writeCount(index, "nRows", nRows);
+  if (sorted) {
+    write_attribute(index, "layout", "sparse");
+    writeCount(index, "blockRows", blockRows);
+    std::vector<hsize_t> const dims {nBlocks, nKeys};
+    Dataset firstOut(makeArray(index, "first", H5T_STD_I64LE, dims));
+    Dataset lastOut(makeArray(index, "last", H5T_STD_I64LE, dims));
+    if (nBlocks != 0ull &&
+        (firstOut.write(H5T_NATIVE_LLONG, first.data()) != 0 ||
+         lastOut.write(H5T_NATIVE_LLONG, last.data()) != 0)) {
+      throw std::runtime_error("Unable to write key index.");
+    }
+    return;
+  }
+  // Second pass: sort the keys in runs of at most runRows rows, each
+  // record being a row's key followed by its row number so that equal
+  // keys stay in row order. A single run is written out directly;
+  // otherwise the runs are written to a scratch file and merged.
+  write_attribute(index, "layout", "dense");
+  if (runRows == 0ull) {
+    runRows = SORT_RUN_ROWS;
+  }
+  std::size_t const width = nKeys + 1ull;
+  std::vector<hsize_t> const keyDims {nRows, nKeys};
+  Dataset keysOut(makeArray(index, "keys", H5T_STD_I64LE, keyDims));
+  Dataset rowsOut(makeArray(index, "rows", H5T_STD_U64LE, {nRows}));
+  if (nRows == 0ull) {
+    return;
+  }
+  hsize_t const nRuns = (nRows + runRows - 1ull) / runRows;
+  std::vector<long long> records;
+  std::vector<long long> outKeys;
+  std::vector<std::uint64_t> outRows;
+  if (nRuns == 1ull) {
+    sortRun(group, keyColumns, 0ull, nRows, keys, records);
+    writeRecords(keysOut, rowsOut, 0ull, nRows, nKeys, records.data(),
+                 outKeys, outRows);
+    return;
+  }
+  ScratchFile const scratch(group);
+  hsize_t const runDims[2] {nRows, width};
+  Dataset runs(scratch.file(), "runs", H5T_NATIVE_LLONG,
+               Dataspace{2, runDims, runDims});
+  for (hsize_t start = 0ull; start < nRows; start += runRows) {
+    hsize_t const n = std::min(runRows, nRows - start);
+    sortRun(group, keyColumns, start, n, keys, records);
+    if (writeSlab(runs, H5T_NATIVE_LLONG, start, n, width,
+                  records.data()) != 0) {
+      throw std::runtime_error("Unable to write sorted run of key index.");
+    }
+  }
+  std::vector<std::vector<long long> >().swap(keys);
+  std::vector<long long>().swap(records);
+  // k-way merge, reading each run bufferRows records at a time.
+  hsize_t const bufferRows =
+    std::min(runRows, std::max(runRows / nRuns, MIN_MERGE_ROWS));
+  struct Cursor {
+    hsize_t next;
+    hsize_t end;
+    std::vector<long long> buffer;
+    std::size_t position;
+  };
+  std::vector<Cursor> cursors(nRuns);
+  auto const head = [&cursors, width](std::size_t const run)
+    {
+      auto const & c = cursors[run];
+      return c.buffer.data() + c.position * width;
+    };
+  auto const refill = [&runs, &cursors, width, bufferRows]
+    (std::size_t const run)
+    {
+      auto & c = cursors[run];
+      hsize_t const n = std::min(bufferRows, c.end - c.next);
+      c.buffer.resize(n * width);
+      c.position = 0ull;
+      if (n != 0ull &&
+          readSlab(runs, H5T_NATIVE_LLONG, c.next, n, width,
+                   c.buffer.data()) != 0) {
+        throw std::runtime_error("Unable to read sorted run of key index.");
+      }
+      c.next += n;
+      return n != 0ull;
+    };
+  // Min-heap of runs by their current record.
+  auto const greater = [&head, width](std::size_t const a,
+                                      std::size_t const b)
+    {
+      return std::lexicographical_compare(head(b), head(b) + width,
+                                          head(a), head(a) + width);
+    };
+  std::vector<std::size_t> heap;
+  heap.reserve(nRuns);
+  for (hsize_t run = 0ull; run != nRuns; ++run) {
+    cursors[run].next = run * runRows;
+    cursors[run].end = std::min(nRows, cursors[run].next + runRows);
+    if (refill(run)) {
+      heap.push_back(run);
+    }
+  }
+  std::make_heap(heap.begin(), heap.end(), greater);
+  hsize_t const outRowsMax = std::min(nRows, SORT_RUN_ROWS);
+  records.reserve(outRowsMax * width);
+  hsize_t written = 0ull;
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), greater);
+    std::size_t const run = heap.back();
+    records.insert(records.end(), head(run), head(run) + width);
+    auto & c = cursors[run];
+    if (++c.position * width < c.buffer.size() || refill(run)) {
+      std::push_heap(heap.begin(), heap.end(), greater);
+    } else {
+      heap.pop_back();
+    }
+    hsize_t const n = records.size() / width;
+    if (n == outRowsMax || heap.empty()) {
+      writeRecords(keysOut, rowsOut, written, n, nKeys, records.data(),
+                   outKeys, outRows);
+      written += n;
+      records.clear();
+    }
+  }
+}
+
+herr_t
+hep_hpc::hdf5::detail::readKeyColumn(hid_t const group,
+                                     std::string const & name,
+                                     hsize_t const first,
+                                     hsize_t const nRows,
+                                     long long * const out)
+{
+  bool const own = (H5Lexists(group, name.c_str(), H5P_DEFAULT) > 0);
+  Dataset dset(group, own ? name : std::string("rows"));
+  Datatype memType;
+  if (own) {
+    memType = Datatype(H5Tcopy(H5T_NATIVE_LLONG));
+  } else {
+    // Read just the member of the row-wise compound dataset.
+    memType = Datatype(H5Tcreate(H5T_COMPOUND, sizeof(long long)));
+    H5Tinsert(memType, name.c_str(), 0, H5T_NATIVE_LLONG);
+  }
+  Dataspace fileSpace(ErrorController::call(&H5Dget_space, dset));
+  hsize_t offsets[H5S_MAX_RANK] {0}, counts[H5S_MAX_RANK];
+  std::fill(counts, counts + H5S_MAX_RANK, 1ull);
+  offsets[0] = first;
+  counts[0] = nRows;
+  herr_t rc;
+  if ((rc = ErrorController::call(&H5Sselect_hyperslab, fileSpace,
+                                  H5S_SELECT_SET, offsets, nullptr,
+                                  counts, nullptr)) != 0) {
+    return rc;
+  }
+  return dset.read(memType, out, Dataspace{1, &nRows, &nRows},
+                   std::move(fileSpace));
+}
+
+hsize_t
+hep_hpc::hdf5::detail::keyChunkRows(hid_t const group,
+                                    std::string const & name)
+{
+  bool const own = (H5Lexists(group, name.c_str(), H5P_DEFAULT) > 0);
+  Dataset const dset(group, own ? name : std::string("rows"));
+  return datasetChunkRows(dset);
+}
@@ -0,0 +1,79 @@
+#ifndef hep_hpc_hdf5_detail_KeyIndex_hpp
+#define hep_hpc_hdf5_detail_KeyIndex_hpp
+////////////////////////////////////////////////////////////////////////
+// Writing and reading the key index of an Ntuple (see
+// NtupleOptions::setKeyColumns() and hep_hpc/hdf5/NtupleIndex.hpp).
+//
+// The index is stored in the subgroup _key_index of the Ntuple's group,
+// with attributes:
+//
+//   columns: the names of the key columns, in order of significance;
+//   layout: "sparse" or "dense";
+//   nRows: the number of rows indexed;
+//   blockRows (sparse only): the number of rows per block.
+//
+// If the table is sorted by its key, the index is sparse: datasets
+// first and last, of dimensions [nBlocks][nKeys], hold the first and
+// last key of each block of blockRows rows (the chunks of the key
+// columns). Otherwise, it is dense: the dataset keys, of dimensions
+// [nRows][nKeys], holds every row's key in sorted order, and the dataset
+// rows the corresponding row numbers. Keys are stored as signed 64-bit
+// integers.
+//
+// A dense index is built by an external merge sort, so that memory use
+// is bounded whatever the size of the table: the keys are read and
+// sorted in runs of runRows rows (SORT_RUN_ROWS by default), which, if
+// there is more than one, are written to a temporary HDF5 file
+// alongside the table's (named for it, with the suffix
+// .key_index.tmp) and then merged, writing the index as it is
+// produced. Memory use is then of the order of 16 * (nKeys + 1) *
+// runRows bytes (64 MiB for three keys by default), plus that of
+// reading at least 1024 records of each run at a time during the
+// merge; the temporary file holds 8 * (nKeys + 1) * nRows bytes.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hdf5.h"
+
+#include <string>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      // Name of the group (within the Ntuple's group) holding the index.
+      constexpr char const * const KEY_INDEX_GROUP = "_key_index";
+
+      // Default rows per sorted run when building a dense index.
+      constexpr hsize_t SORT_RUN_ROWS = 1ull << 20;
+
+      // Write the index of the first nRows rows of the table in group
+      // (replacing any existing index), reading back the key columns
+      // from file, sorting them in runs of runRows rows (0 for
+      // SORT_RUN_ROWS) if they are not already in order. Throws on
+      // failure.
+      void writeKeyIndex(hid_t group,
+                         std::vector<std::string> const & keyColumns,
+                         hsize_t nRows,
+                         hsize_t runRows = 0ull);
+
+      // Read nRows rows of the scalar integer column name of the table
+      // in group, starting at row first, whether it is stored in a
+      // dataset of its own or as a member of the row-wise dataset.
+      herr_t readKeyColumn(hid_t group,
+                           std::string const & name,
+                           hsize_t first,
+                           hsize_t nRows,
+                           long long * out);
+
+      // Chunk row count of the dataset holding column name (0 if not
+      // chunked).
+      hsize_t keyChunkRows(hid_t group, std::string const & name);
+    }
+  }
+}
+
+#endif /* hep_hpc_hdf5_detail_KeyIndex_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,50 @@
+#include "hep_hpc/hdf5/detail/MantissaRounding.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+  // Round the IEEE-754 representations of n values of type T (with
+  // unsigned integer representation U) to bits explicit mantissa
+  // bits. The loop is branch-free so that the compiler can vectorize
+  // it.
+  template <typename T, typename U>
+  void roundBits(T * const data, std::size_t const n, unsigned const bits)
+  {
+    static_assert(sizeof(T) == sizeof(U), "Representation size mismatch.");
+    constexpr unsigned mantissa = std::numeric_limits<T>::digits - 1;
+    constexpr U exponentMask =
+      ((U(1) << (sizeof(U) * 8 - 1)) - 1) & ~((U(1) << mantissa) - 1);
+    unsigned const drop = mantissa - bits;
+    U const keep = ~((U(1) << drop) - 1);
+    U const half = U(1) << (drop - 1);
+    for (std::size_t i = 0; i != n; ++i) {
+      U u;
+      std::memcpy(&u, data + i, sizeof(U));
+      U const rounded = (u + half) & keep;
+      // Leave infinities and NaNs alone, and truncate rather than
+      // round to infinity.
+      U const result =
+        ((u & exponentMask) == exponentMask) ? u :
+        ((rounded & exponentMask) == exponentMask) ? (u & keep) :
+        rounded;
+      std::memcpy(data + i, &result, sizeof(U));
+    }
+  }
+}
+
+void
+hep_hpc::hdf5::detail::roundMantissas(float * const data,
+                                      std::size_t const n,
+                                      unsigned const bits)
+{
+  roundBits<float, std::uint32_t>(data, n, bits);
+}
+
+void
+hep_hpc::hdf5::detail::roundMantissas(double * const data,
+                                      std::size_t const n,
+                                      unsigned const bits)
+{
+  roundBits<double, std::uint64_t>(data, n, bits);
+}
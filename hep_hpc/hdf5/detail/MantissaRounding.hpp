@@ -0,0 +1,88 @@
+#ifndef hep_hpc_hdf5_detail_MantissaRounding_hpp
+#define hep_hpc_hdf5_detail_MantissaRounding_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::mantissa_rounding<T>
+//
+// Reduced-precision storage of columns of float or double (see
+// hep_hpc/hdf5/Column.hpp): values are rounded to nearest with the
+// given number of explicit mantissa bits b as they are inserted into
+// an Ntuple's buffers. The discarded bits are zero, so that the values
+// compress well.
+//
+// For a normal value x stored as x', |x' - x| <= 2^-(b + 1) * |x|,
+// except that a value which would round to infinity is truncated
+// instead, with |x' - x| < 2^-b * |x|. Subnormal values are rounded
+// on the same absolute scale as the smallest normal one, m
+// (std::numeric_limits<T>::min()): |x' - x| <= 2^-(b + 1) * m, so
+// that those with no bits set among the b kept are flushed to zero.
+// Infinities and NaNs are stored unchanged.
+//
+// roundMantissas(data, n, bits)
+//
+//   Round n values in place to bits explicit mantissa bits (less than
+//   the full complement).
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Exception.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      template <typename T>
+      class mantissa_rounding;
+
+      void roundMantissas(float * data, std::size_t n, unsigned bits);
+      void roundMantissas(double * data, std::size_t n, unsigned bits);
+    }
+  }
+}
+
+template <typename T>
+class hep_hpc::hdf5::detail::mantissa_rounding {
+public:
+  // Explicit mantissa bits of T (23 for float, 52 for double).
+  static constexpr unsigned fullMantissaBits()
+    { return std::numeric_limits<T>::digits - 1; }
+
+  unsigned mantissaBits() const { return mantissaBits_; }
+
+  void setMantissaBits(unsigned const bits)
+    {
+      if (bits > fullMantissaBits()) {
+        throw Exception("Requested " + std::to_string(bits) +
+                        " mantissa bits exceeds the " +
+                        std::to_string(fullMantissaBits()) + " available.");
+      }
+      mantissaBits_ = bits;
+    }
+
+  // Bound on the relative error of a stored normal value (see above):
+  // 0 at full precision.
+  T relativeErrorBound() const
+    {
+      return (mantissaBits_ == fullMantissaBits()) ? T(0) :
+        std::ldexp(T(1), -static_cast<int>(mantissaBits_ + 1));
+    }
+
+  // Round n values in place to the column's precision.
+  void roundMantissas(T * const data, std::size_t const n) const
+    {
+      if (mantissaBits_ != fullMantissaBits()) {
+        detail::roundMantissas(data, n, mantissaBits_);
+      }
+    }
+
+private:
+  unsigned mantissaBits_ {fullMantissaBits()};
+};
+
+#endif /* hep_hpc_hdf5_detail_MantissaRounding_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
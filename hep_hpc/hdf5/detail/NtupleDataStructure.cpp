@@ -1,8 +1,37 @@
 #include "hep_hpc/hdf5/detail/NtupleDataStructure.hpp"
+#include "hep_hpc/hdf5/Datatype.hpp"
+#include "hep_hpc/hdf5/detail/Bitshuffle.hpp"
+#include "hep_hpc/hdf5/detail/CodecFilters.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+  // Byte shuffle, as for the HDF5 shuffle filter (H5Z_FILTER_SHUFFLE).
+  void
+  shuffleBytes(unsigned char const * const src,
+               std::size_t const nBytes,
+               std::size_t const size,
+               unsigned char * const dest)
+  {
+    std::size_t const nElements = nBytes / size;
+    for (std::size_t j = 0; j != size; ++j) {
+      unsigned char * const out = dest + j * nElements;
+      for (std::size_t i = 0; i != nElements; ++i) {
+        out[i] = src[i * size + j];
+      }
+    }
+    std::size_t const leftover = nBytes - nElements * size;
+    std::memcpy(dest + nBytes - leftover, src + nBytes - leftover, leftover);
+  }
+}
 
 hep_hpc::hdf5::Group
 hep_hpc::hdf5::detail::
-makeGroup(hid_t file, std::string const & name, bool overwriteContents)
+makeGroup(hid_t file, std::string const & name,
+          NtupleOverwriteFlag const overwriteContents)
 {
   Group group;
   {
@@ -10,7 +39,10 @@ makeGroup(hid_t file, std::string const & name, bool overwriteContents)
     group = Group(file, name);
   }
   if (!group) { // Already exists.
-    if (!overwriteContents) {
+    if (overwriteContents == NtupleOverwriteFlag::APPEND) {
+      return Group(file, name, Group::OPEN_MODE);
+    }
+    if (overwriteContents == NtupleOverwriteFlag::NO) {
       throw std::runtime_error("Group " + name +
                                " already exists and overwriting is not specified.");
     }
@@ -21,4 +53,400 @@ makeGroup(hid_t file, std::string const & name, bool overwriteContents)
   }
   return group;
 }
+
+bool
+hep_hpc::hdf5::detail::hasLinks(hid_t const group)
+{
+  H5G_info_t info;
+  ErrorController::call(ErrorMode::EXCEPTION, &H5Gget_info, group, &info);
+  return info.nlinks != 0ull;
+}
+
+hep_hpc::hdf5::Dataset
+hep_hpc::hdf5::detail::openDataset(hid_t const group,
+                                   std::string const & name,
+                                   hid_t const fileType,
+                                   std::vector<hsize_t> const & rowDims,
+                                   ChunkCacheReservation & reservation,
+                                   PropertyList accessProperties)
+{
+  auto const fail = [&name](std::string const & why)
+    {
+      throw std::runtime_error("Cannot append to column " + name +
+                               " of existing Ntuple: " + why + ".");
+    };
+  if (ErrorController::call(ErrorMode::EXCEPTION, &H5Lexists,
+                            group, name.c_str(), H5P_DEFAULT) <= 0) {
+    fail("no such dataset");
+  }
+  Dataset dset;
+  {
+    // Cause an exception to be thrown if we have an HDF5 issue.
+    ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+    dset = accessProperties.is_default() ?
+      openDatasetWithChunkCache(group, name, ChunkAccess::APPEND,
+                                reservation) :
+      Dataset(group, name, std::move(accessProperties));
+  }
+  Datatype const dtype(ErrorController::call(&H5Dget_type, dset));
+  if (H5Tequal(dtype, fileType) <= 0) {
+    fail("type does not match column");
+  }
+  Dataspace const dspace(ErrorController::call(&H5Dget_space, dset));
+  int const rank = H5Sget_simple_extent_ndims(dspace);
+  if (rank != static_cast<int>(rowDims.size() + 1ull)) {
+    fail("rank does not match column");
+  }
+  std::vector<hsize_t> dims(rank), maxdims(rank);
+  H5Sget_simple_extent_dims(dspace, dims.data(), maxdims.data());
+  if (!std::equal(rowDims.cbegin(), rowDims.cend(), dims.cbegin() + 1)) {
+    fail("dimensions do not match column");
+  }
+  if (maxdims[0] != H5S_UNLIMITED || datasetChunkRows(dset) == 0ull) {
+    fail("dataset is not extendible");
+  }
+  return dset;
+}
+
+void
+hep_hpc::hdf5::detail::seedWriteState(hid_t const dset,
+                                      ColumnWriteState & state)
+{
+  state.chunkRows = datasetChunkRows(dset);
+  state.fileSpace =
+    Dataspace{ErrorController::call(ErrorMode::EXCEPTION,
+                                    &H5Dget_space, dset)};
+  // Rows already written (if appending).
+  hsize_t dims[H5S_MAX_RANK];
+  ErrorController::call(ErrorMode::EXCEPTION,
+                        &H5Sget_simple_extent_dims, state.fileSpace,
+                        dims, nullptr);
+  state.size = state.extent = dims[0];
+}
+
+hep_hpc::hdf5::Shuffle
+hep_hpc::hdf5::detail::defaultShuffle(hid_t const fileType,
+                                      Shuffle const shuffle)
+{
+  // Arithmetic types, or arrays of them.
+  Datatype const base((H5Tget_class(fileType) == H5T_ARRAY) ?
+                      H5Tget_super(fileType) : H5Tcopy(fileType));
+  H5T_class_t const typeClass = H5Tget_class(base);
+  if (typeClass != H5T_INTEGER && typeClass != H5T_FLOAT) {
+    return Shuffle::NONE;
+  }
+  return (shuffle == Shuffle::BYTE && H5Tget_size(base) == 1ull) ?
+    Shuffle::NONE : shuffle;
+}
+
+hsize_t
+hep_hpc::hdf5::detail::defaultChunkRows(std::size_t const rowBytes,
+                                        std::size_t const chunkBytes,
+                                        hsize_t const maxRows)
+{
+  hsize_t const rows = (chunkBytes == 0ull || rowBytes == 0ull) ?
+    DEFAULT_CHUNKING :
+    std::min(std::max(chunkBytes / rowBytes, std::size_t(1ull)),
+             MAX_DEFAULT_CHUNKING);
+  return (maxRows == 0ull) ? rows : std::min(rows, maxRows);
+}
+
+hsize_t
+hep_hpc::hdf5::detail::datasetChunkRows(hid_t const dset)
+{
+  PropertyList
+    cdprops(ErrorController::call(&H5Dget_create_plist, dset),
+            ResourceStrategy::handle_tag);
+  if (H5Pget_layout(cdprops) != H5D_CHUNKED) {
+    return 0ull;
+  }
+  hsize_t chunking[H5S_MAX_RANK];
+  int const chunk_rank =
+    ErrorController::call(ErrorMode::NONE,
+                          &H5Pget_chunk, cdprops, H5S_MAX_RANK, chunking);
+  return (chunk_rank > 0) ? chunking[0] : 0ull;
+}
+
+herr_t
+hep_hpc::hdf5::detail::trimExtent(hid_t const dset, ColumnWriteState & state)
+{
+  if (state.extent == state.size) { // Nothing to do.
+    return 0;
+  }
+  hsize_t dims[H5S_MAX_RANK];
+  if (H5Sget_simple_extent_dims(state.fileSpace, dims, nullptr) < 0) {
+    return -1;
+  }
+  dims[0] = state.size;
+  herr_t const rc = ErrorController::call(&H5Dset_extent, dset, dims);
+  if (rc == 0) {
+    state.extent = state.size;
+    state.fileSpace = Dataspace{ErrorController::call(&H5Dget_space, dset)};
+  }
+  return rc;
+}
                
+
+void
+hep_hpc::hdf5::detail::
+configureDirectChunkWrite(hid_t const dset,
+                          hid_t const memType,
+                          ColumnWriteState & state,
+                          ThreadPool * const compressors)
+{
+#if H5_VERSION_GE(1,10,3)
+  if (state.chunkRows == 0ull) {
+    return;
+  }
+  // Data must be written as-is.
+  Datatype const dtype(ErrorController::call(&H5Dget_type, dset));
+  if (H5Tequal(dtype, memType) <= 0 ||
+      H5Tis_variable_str(dtype) != 0 ||
+      H5Tdetect_class(dtype, H5T_VLEN) != 0) {
+    return;
+  }
+  // Chunks must span whole rows.
+  PropertyList
+    cdprops(ErrorController::call(&H5Dget_create_plist, dset),
+            ResourceStrategy::handle_tag);
+  hsize_t dims[H5S_MAX_RANK], chunking[H5S_MAX_RANK];
+  int const rank = H5Sget_simple_extent_dims(state.fileSpace, dims, nullptr);
+  if (rank < 1 || H5Pget_chunk(cdprops, H5S_MAX_RANK, chunking) != rank ||
+      !std::equal(dims + 1, dims + rank, chunking + 1)) {
+    return;
+  }
+  // Filter pipeline must be [shuffle|bitshuffle,] <compression>.
+  int const nFilters = H5Pget_nfilters(cdprops);
+  bool compressed = false;
+  std::size_t shuffleSize = 0ull, shuffleBlock = 0ull;
+  bool bitShuffle = false;
+  for (int i = 0; i < nFilters; ++i) {
+    unsigned int flags;
+    std::size_t nValues = 5;
+    unsigned int values[5] = {0};
+    H5Z_filter_t const filter =
+      H5Pget_filter2(cdprops, i, &flags, &nValues, values, 0, nullptr, nullptr);
+    if (filter == H5Z_FILTER_SHUFFLE && i == 0 && nFilters == 2) {
+      shuffleSize = H5Tget_size(dtype);
+    } else if (filter == H5Z_FILTER_BITSHUFFLE && i == 0 && nFilters == 2 &&
+               nValues >= 3 && (nValues < 5 || values[4] == 0u)) {
+      // See bitshuffleFilter() in CodecFilters.cpp.
+      bitShuffle = true;
+      shuffleSize = values[2];
+      shuffleBlock = (nValues > 3) ? values[3] : 0u;
+    } else if (i == nFilters - 1 && canCompressChunk(filter)) {
+      compressed = true;
+      state.filter = filter;
+      state.filterValue = (nValues > 0) ? values[0] :
+        (filter == H5Z_FILTER_DEFLATE) ? 6u : 0u;
+    } else {
+      return;
+    }
+  }
+  if (!compressed) {
+    return;
+  }
+  state.compressors = compressors;
+  state.shuffleSize = shuffleSize;
+  state.bitShuffle = bitShuffle;
+  state.shuffleBlock = shuffleBlock;
+#else
+  (void) dset;
+  (void) memType;
+  (void) state;
+  (void) compressors;
+#endif
+}
+
+herr_t
+hep_hpc::hdf5::detail::
+writeChunksDirect(hid_t const dset,
+                  ColumnWriteState & state,
+                  void const * const data,
+                  hsize_t const nRows,
+                  std::size_t const rowBytes)
+{
+#if H5_VERSION_GE(1,10,3)
+  std::size_t const nChunks = nRows / state.chunkRows;
+  std::size_t const chunkBytes = state.chunkRows * rowBytes;
+  std::vector<std::vector<unsigned char> > chunks(nChunks);
+  try {
+    state.compressors->parallel_for
+      (nChunks,
+       [&](std::size_t const i)
+       {
+         auto src = static_cast<unsigned char const *>(data) + i * chunkBytes;
+         if (state.bitShuffle) {
+           thread_local std::vector<unsigned char> shuffled;
+           shuffled.resize(chunkBytes);
+           bitshuffle(src, shuffled.data(), chunkBytes / state.shuffleSize,
+                      state.shuffleSize, state.shuffleBlock);
+           src = shuffled.data();
+         } else if (state.shuffleSize > 1ull) {
+           thread_local std::vector<unsigned char> shuffled;
+           shuffled.resize(chunkBytes);
+           shuffleBytes(src, chunkBytes, state.shuffleSize, shuffled.data());
+           src = shuffled.data();
+         }
+         compressChunk(state.filter, state.filterValue, src, chunkBytes,
+                       chunks[i]);
+       });
+  }
+  catch (std::exception const &) {
+    return -1;
+  }
+  hsize_t offsets[H5S_MAX_RANK] = {0};
+  for (std::size_t i = 0; i != nChunks; ++i) {
+    offsets[0] = state.size + i * state.chunkRows;
+    herr_t const rc =
+      ErrorController::call(&H5Dwrite_chunk, dset, H5P_DEFAULT, 0u,
+                            offsets, chunks[i].size(), chunks[i].data());
+    if (rc != 0) {
+      return rc;
+    }
+  }
+  return 0;
+#else
+  (void) dset;
+  (void) state;
+  (void) data;
+  (void) nRows;
+  (void) rowBytes;
+  return -1;
+#endif
+}
+
+bool
+hep_hpc::hdf5::detail::isRowMember(hid_t const engineType)
+{
+  return H5Tis_variable_str(engineType) <= 0;
+}
+
+hep_hpc::hdf5::Dataset
+hep_hpc::hdf5::detail::makeRowDataset(hid_t const group,
+                                      std::vector<RowMember> const & members,
+                                      bool const append,
+                                      std::size_t const chunkBytes,
+                                      hsize_t const maxChunkRows,
+                                      Datatype & memType,
+                                      std::vector<std::size_t> & offsets,
+                                      ChunkCacheReservation & reservation)
+{
+  // Cause an exception to be thrown if we have an HDF5 issue.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  std::vector<Datatype> fileTypes, memTypes;
+  std::size_t fileSize = 0ull, memSize = 0ull;
+  for (auto const & member : members) {
+    if (member.dims.empty()) {
+      fileTypes.emplace_back(H5Tcopy(member.fileType));
+      memTypes.emplace_back(H5Tcopy(member.memType));
+    } else {
+      fileTypes.emplace_back(H5Tarray_create2(member.fileType,
+                                              member.dims.size(),
+                                              member.dims.data()));
+      memTypes.emplace_back(H5Tarray_create2(member.memType,
+                                             member.dims.size(),
+                                             member.dims.data()));
+    }
+    fileSize += H5Tget_size(fileTypes.back());
+    memSize += H5Tget_size(memTypes.back());
+  }
+  Datatype fileType(H5Tcreate(H5T_COMPOUND, fileSize));
+  memType = Datatype(H5Tcreate(H5T_COMPOUND, memSize));
+  offsets.clear();
+  std::size_t fileOffset = 0ull, memOffset = 0ull;
+  for (std::size_t i = 0; i != members.size(); ++i) {
+    H5Tinsert(fileType, members[i].name.c_str(), fileOffset, fileTypes[i]);
+    H5Tinsert(memType, members[i].name.c_str(), memOffset, memTypes[i]);
+    offsets.push_back(memOffset);
+    fileOffset += H5Tget_size(fileTypes[i]);
+    memOffset += H5Tget_size(memTypes[i]);
+  }
+  if (append) {
+    return openDataset(group, "rows", fileType, {}, reservation);
+  }
+  dims_t<1ull> dims {0ull}, maxdims {H5S_UNLIMITED};
+  PropertyList cprops =
+    defaultDatasetCreationProperties(dims, fileSize, chunkBytes,
+                                     maxChunkRows);
+  PropertyList aprops =
+    chunkCacheProperties(chunkSizeBytes(cprops, fileType),
+                         ChunkAccess::APPEND, reservation);
+  return Dataset(group, "rows", fileType,
+                 Dataspace{1, dims.data(), maxdims.data()},
+                 {},
+                 std::move(cprops),
+                 std::move(aprops));
+}
+
+void
+hep_hpc::hdf5::detail::packColumn(unsigned char * const rows,
+                                  std::size_t const rowSize,
+                                  std::size_t const offset,
+                                  void const * const data,
+                                  std::size_t const rowBytes,
+                                  std::size_t const nRows)
+{
+  auto const in = static_cast<unsigned char const *>(data);
+  for (std::size_t i = 0; i != nRows; ++i) {
+    std::memcpy(rows + i * rowSize + offset, in + i * rowBytes, rowBytes);
+  }
+}
+
+hsize_t
+hep_hpc::hdf5::detail::nextExtent(ColumnWriteState const & state,
+                                  hsize_t const newSize)
+{
+  if (state.exactExtent) {
+    return newSize;
+  }
+  // Extend geometrically (in whole chunks) to amortize the cost of
+  // updating the dataset's metadata over many writes.
+  hsize_t extent = std::max(newSize, state.extent * 2ull);
+  if (state.chunkRows != 0ull) {
+    extent += (state.chunkRows - extent % state.chunkRows) % state.chunkRows;
+  }
+  return extent;
+}
+
+herr_t
+hep_hpc::hdf5::detail::writeRows(hid_t const dset,
+                                 hid_t const memType,
+                                 void const * const data,
+                                 hsize_t const nRows,
+                                 ColumnWriteState & state)
+{
+  herr_t rc = 0;
+  if (nRows == 0ull) { // Nothing to do.
+    return rc;
+  }
+  hsize_t const newSize = state.size + nRows;
+  if (newSize > state.extent) {
+    hsize_t extent = nextExtent(state, newSize);
+    if ((rc = ErrorController::call(&H5Dset_extent, dset, &extent)) != 0) {
+      return rc;
+    }
+    state.extent = extent;
+    state.fileSpace = Dataspace{ErrorController::call(&H5Dget_space, dset)};
+  }
+  hsize_t const offset = state.size;
+  if ((rc = ErrorController::call(&H5Sselect_hyperslab,
+                                  state.fileSpace,
+                                  H5S_SELECT_SET,
+                                  &offset,
+                                  nullptr,
+                                  &nRows,
+                                  nullptr)) != 0) {
+    return rc;
+  }
+  if (state.memRows != nRows) {
+    state.memSpace = Dataspace{1, &nRows, &nRows};
+    state.memRows = nRows;
+  }
+  if ((rc = ErrorController::call(&H5Dwrite, dset, memType,
+                                  state.memSpace, state.fileSpace,
+                                  H5P_DEFAULT, data)) == 0) {
+    state.size = newSize;
+  }
+  return rc;
+}
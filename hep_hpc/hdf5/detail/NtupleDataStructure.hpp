@@ -1,14 +1,36 @@
 #ifndef hep_hpc_hdf5_detail_NtupleDataStructure_hpp
 #define hep_hpc_hdf5_detail_NtupleDataStructure_hpp
 
+#include "hep_hpc/Utilities/detail/index_sequence.hpp"
+#include "hep_hpc/hdf5/ChunkCache.hpp"
+#include "hep_hpc/hdf5/Codec.hpp"
 #include "hep_hpc/hdf5/Column.hpp"
 #include "hep_hpc/hdf5/Group.hpp"
 #include "hep_hpc/hdf5/Dataset.hpp"
 #include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/Datatype.hpp"
+#include "hep_hpc/hdf5/JaggedColumn.hpp"
+#include "hep_hpc/hdf5/NtupleOptions.hpp"
 #include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/detail/BitPacker.hpp"
+#include "hep_hpc/hdf5/detail/ChunkStatistics.hpp"
+#include "hep_hpc/hdf5/detail/JaggedBuffer.hpp"
+#include "hep_hpc/hdf5/detail/JaggedValues.hpp"
+#include "hep_hpc/hdf5/detail/StringArena.hpp"
+#include "hep_hpc/hdf5/detail/StringDictionary.hpp"
+#include "hep_hpc/hdf5/detail/ThreadPool.hpp"
 #include "hep_hpc/hdf5/errorHandling.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 namespace hep_hpc {
   namespace hdf5 {
@@ -16,20 +38,361 @@ namespace hep_hpc {
       template <typename... Args>
       struct NtupleDataStructure;
 
+      // In-memory storage for the contents of a column with elements of
+      // type T.
+      template <typename T>
+      struct column_buffer {
+        using type = std::vector<T>;
+      };
+
+      // Variable-length strings are copied into a character arena as
+      // they are inserted, whatever the form in which they are given.
+      template <>
+      struct column_buffer<std::string> {
+        using type = StringArena;
+      };
+
+      template <>
+      struct column_buffer<char const *> {
+        using type = StringArena;
+      };
+
+      template <>
+      struct column_buffer<char *> {
+        using type = StringArena;
+      };
+
+      // Dictionary-encoded strings are encoded when written.
+      template <>
+      struct column_buffer<dict_string> {
+        using type = StringArena;
+      };
+
+      // Flags are buffered one per byte, and packed when written.
+      template <>
+      struct column_buffer<bool> {
+        using type = std::vector<unsigned char>;
+      };
+
+      template <typename T>
+      struct column_buffer<jagged_span<T> > {
+        using type = JaggedBuffer<T>;
+      };
+
+      template <typename T>
+      using column_buffer_t = typename column_buffer<T>::type;
+
+      // Memory allocated by a column buffer, in bytes.
+      template <typename T>
+      std::size_t capacityBytes(std::vector<T> const & buf)
+      { return buf.capacity() * sizeof(T); }
+
+      inline std::size_t capacityBytes(StringArena const & buf)
+      { return buf.capacityBytes(); }
+
+      template <typename T>
+      std::size_t capacityBytes(JaggedBuffer<T> const & buf)
+      { return buf.capacityBytes(); }
+
+      // Round n values of a column in place to its precision, if
+      // reduced (see mantissa_rounding).
+      template <typename COL, typename T>
+      void reducePrecision(COL const &, T *, std::size_t) { }
+
+      template <typename COL>
+      void reducePrecision(COL const & col, float * data, std::size_t n)
+      { col.roundMantissas(data, n); }
+
+      template <typename COL>
+      void reducePrecision(COL const & col, double * data, std::size_t n)
+      { col.roundMantissas(data, n); }
+
+      // As reducePrecision(), for n values not to be modified: returns
+      // data, or a rounded copy held by copy.
+      template <typename COL, typename T>
+      T const * reducedPrecision(COL const &, T const * data, std::size_t,
+                                 std::unique_ptr<T[]> &)
+      { return data; }
+
+      template <typename COL, typename T>
+      T const * reducedPrecisionFloat(COL const & col, T const * data,
+                                      std::size_t n,
+                                      std::unique_ptr<T[]> & copy)
+      {
+        if (col.mantissaBits() == col.fullMantissaBits()) {
+          return data;
+        }
+        if (data != copy.get()) {
+          copy.reset(new T[n]);
+          std::copy(data, data + n, copy.get());
+        }
+        col.roundMantissas(copy.get(), n);
+        return copy.get();
+      }
+
+      template <typename COL>
+      float const * reducedPrecision(COL const & col, float const * data,
+                                     std::size_t n,
+                                     std::unique_ptr<float[]> & copy)
+      { return reducedPrecisionFloat(col, data, n, copy); }
+
+      template <typename COL>
+      double const * reducedPrecision(COL const & col, double const * data,
+                                      std::size_t n,
+                                      std::unique_ptr<double[]> & copy)
+      { return reducedPrecisionFloat(col, data, n, copy); }
+
+      // Auxiliary storage written along with a column's own dataset,
+      // if any: the dictionary of a dictionary-encoded string column,
+      // or the values of a jagged column. The packer of a column of
+      // bool writes nothing of its own, but transforms the rows.
+      struct NoCompanion { };
+
+      template <typename T>
+      struct column_companion {
+        using type = NoCompanion;
+      };
+
+      template <>
+      struct column_companion<dict_string> {
+        using type = StringDictionary;
+      };
+
+      template <>
+      struct column_companion<bool> {
+        using type = BitPacker;
+      };
+
+      template <typename T>
+      struct column_companion<jagged_span<T> > {
+        using type = JaggedValues<T>;
+      };
+
+      template <typename T>
+      using column_companion_t = typename column_companion<T>::type;
+
+      // Create (or, if append, open) the companion of col in group.
+      template <typename COL>
+      void openCompanion(NoCompanion &, hid_t, COL const &,
+                         TranslationMode, bool) { }
+
+      template <typename COL>
+      void openCompanion(StringDictionary & dictionary, hid_t group,
+                         COL const & col, TranslationMode, bool append)
+      { dictionary.open(group, col.name(), append); }
+
+      template <typename T, typename COL>
+      void openCompanion(JaggedValues<T> & values, hid_t group,
+                         COL const & col, TranslationMode mode, bool append)
+      { values.open(group, col, mode, append); }
+
+      template <typename COL>
+      void openCompanion(BitPacker & packer, hid_t, COL const & col,
+                         TranslationMode, bool)
+      { packer.open(col.name(), col.elementSize()); }
+
+      // The column as stored in its dataset: bit-packed for columns of
+      // bool.
+      template <typename COL>
+      using is_bit_column = std::is_same<typename COL::element_type, bool>;
+
+      template <typename COL>
+      COL const & storedColumn(COL const & col, std::false_type)
+      { return col; }
+
+      template <typename COL>
+      PackedBitsColumn storedColumn(COL const & col, std::true_type)
+      { return PackedBitsColumn(col); }
+
+      // Write state of a column's dataset, persisting between writes.
+      struct ColumnWriteState {
+        // Rows written.
+        hsize_t size {0ull};
+        // Current extent (rows) of the dataset: grown geometrically
+        // (unless exactExtent), and trimmed to size by trimExtent().
+        hsize_t extent {0ull};
+        // Grow the extent only to the rows written, e.g. so that SWMR
+        // readers see no unwritten rows.
+        bool exactExtent {false};
+        // Chunk row count, or 0 if not chunked.
+        hsize_t chunkRows {0ull};
+        // File dataspace of the current extent.
+        Dataspace fileSpace {};
+        // Memory dataspace of the last write, of memRows rows.
+        Dataspace memSpace {};
+        hsize_t memRows {0ull};
+        // Direct chunk writing (see configureDirectChunkWrite()): the
+        // threads compressing chunks (nullptr if disabled), the
+        // compression filter and its parameter (see compressChunk() in
+        // CodecFilters.hpp), and element size for shuffling (0: no
+        // shuffle), which is bit shuffling (in blocks of shuffleBlock
+        // elements) if bitShuffle is set, else byte shuffling.
+        ThreadPool * compressors {nullptr};
+        H5Z_filter_t filter {H5Z_FILTER_DEFLATE};
+        unsigned int filterValue {0u};
+        std::size_t shuffleSize {0ull};
+        bool bitShuffle {false};
+        std::size_t shuffleBlock {0ull};
+      };
+
+      // Create the group of an Ntuple, or open it if it exists and
+      // overwriteContents is NtupleOverwriteFlag::APPEND.
       Group makeGroup(hid_t file,
                       std::string const & name,
-                      bool overwriteContents);
+                      NtupleOverwriteFlag overwriteContents);
+
+      // Does group contain anything (i.e. is there an existing table to
+      // append to)?
+      bool hasLinks(hid_t group);
+
+      // Open the existing dataset name of group to append rows to it,
+      // verifying that it exists, is chunked and extendible, and matches
+      // the specified type (fileType) and row dimensions, with the
+      // given access properties or, if they are default, a chunk cache
+      // for appending (see hep_hpc/hdf5/ChunkCache.hpp) reserved in
+      // reservation.
+      Dataset openDataset(hid_t group,
+                          std::string const & name,
+                          hid_t fileType,
+                          std::vector<hsize_t> const & rowDims,
+                          ChunkCacheReservation & reservation,
+                          PropertyList accessProperties = {});
 
+      // Initialize the write state of a dataset from its current extent
+      // and chunking.
+      void seedWriteState(hid_t dset, ColumnWriteState & state);
+
+      // Description of a column as a member of the compound type of a
+      // row-wise dataset.
+      struct RowMember {
+        std::string name;
+        hid_t fileType;
+        hid_t memType;
+        // Empty for scalar columns.
+        std::vector<hsize_t> dims;
+      };
+
+      // Does a column with elements of type engineType belong in a
+      // row-wise dataset (i.e. is it of fixed size)?
+      bool isRowMember(hid_t engineType);
+
+      // Is col of a type that may be stored in a row-wise dataset?
+      template <typename COL>
+      bool isRowColumn(COL const & col);
+
+      // Is col stored in a row-wise dataset (if there is one)? Columns
+      // with link creation, dataset creation or dataset access
+      // properties of their own keep a dataset of their own, to which
+      // they apply.
       template <typename COL>
-      Dataset makeDataset(hid_t const group, COL const & col, TranslationMode mode);
+      bool inRowDataset(COL const & col);
+
+      // Create the chunked row-wise dataset (name: "rows") of compound
+      // type with the specified members and default chunking (see
+      // defaultChunkRows()) for chunkBytes and maxChunkRows (or open it,
+      // if append is set), returning also the corresponding (packed)
+      // compound memory type and the offset of each member in a row.
+      // Its chunk cache is reserved in reservation.
+      Dataset makeRowDataset(hid_t group,
+                             std::vector<RowMember> const & members,
+                             bool append,
+                             std::size_t chunkBytes,
+                             hsize_t maxChunkRows,
+                             Datatype & memType,
+                             std::vector<std::size_t> & offsets,
+                             ChunkCacheReservation & reservation);
+
+      // Copy nRows rows of rowBytes bytes each of a column's data to
+      // their place (offset) in packed rows of size rowSize.
+      void packColumn(unsigned char * rows,
+                      std::size_t rowSize,
+                      std::size_t offset,
+                      void const * data,
+                      std::size_t rowBytes,
+                      std::size_t nRows);
+
+      // The extent to which a dataset must be grown to hold newSize
+      // rows.
+      hsize_t nextExtent(ColumnWriteState const & state, hsize_t newSize);
+
+      // Write nRows rows of type memType after the rows already written
+      // to the (one-dimensional) dataset dset, growing its extent if
+      // necessary.
+      herr_t writeRows(hid_t dset,
+                       hid_t memType,
+                       void const * data,
+                       hsize_t nRows,
+                       ColumnWriteState & state);
+
+      // Create the dataset of col, with default chunking for
+      // chunkBytes and maxChunkRows (see defaultChunkRows()) if its
+      // creation properties specify none, default filters with shuffle if it has no
+      // creation properties, and a chunk cache for appending (see
+      // hep_hpc/hdf5/ChunkCache.hpp), reserved in a new element of
+      // reservations, if it has no access properties.
+      template <typename COL>
+      Dataset makeDataset(hid_t const group, COL const & col,
+                          TranslationMode mode, std::size_t chunkBytes,
+                          hsize_t maxChunkRows, Shuffle shuffle,
+                          std::vector<ChunkCacheReservation> & reservations);
+
+      // As makeDataset(), or openDataset() if append is set.
+      template <typename COL>
+      Dataset makeOrOpenDataset(hid_t group, COL const & col,
+                                TranslationMode mode, bool append,
+                                std::size_t chunkBytes, hsize_t maxChunkRows,
+                                Shuffle shuffle,
+                                std::vector<ChunkCacheReservation> & reservations);
+
+      // Chunk row count (extent of the first dimension of the chunk) of
+      // a dataset, or 0 if not chunked.
+      hsize_t datasetChunkRows(hid_t dset);
+
+      // Set the extent of dset to the rows written.
+      herr_t trimExtent(hid_t dset, ColumnWriteState & state);
+
+      // Enable direct chunk writing for dset using compressors if its
+      // data may be written without conversion from memType, its chunks
+      // span whole rows, and its filter pipeline is a compression
+      // filter supported by compressChunk() (see CodecFilters.hpp),
+      // optionally preceded by byte or bit shuffle.
+      void configureDirectChunkWrite(hid_t dset,
+                                     hid_t memType,
+                                     ColumnWriteState & state,
+                                     ThreadPool * compressors);
+
+      // Compress and write nRows rows of rowBytes bytes each as whole
+      // chunks, bypassing the HDF5 filter pipeline. The rows written must
+      // start and end on chunk boundaries and lie within the dataset's
+      // extent.
+      herr_t writeChunksDirect(hid_t dset,
+                               ColumnWriteState & state,
+                               void const * data,
+                               hsize_t nRows,
+                               std::size_t rowBytes);
+
+      // Rows per chunk of chunkBytes bytes (see NtupleOptions) for rows
+      // of rowBytes bytes, but no more than maxRows if it is non-zero.
+      hsize_t defaultChunkRows(std::size_t rowBytes, std::size_t chunkBytes,
+                               hsize_t maxRows = 0ull);
+
+      // The shuffle for the default creation properties of a dataset
+      // of fileType (see NtupleOptions::shuffle()).
+      Shuffle defaultShuffle(hid_t fileType, Shuffle shuffle);
 
       template <size_t NDIMS>
       PropertyList
-      defaultDatasetCreationProperties(dims_t<NDIMS> const & dims);
+      defaultDatasetCreationProperties(dims_t<NDIMS> const & dims,
+                                       std::size_t rowBytes,
+                                       std::size_t chunkBytes,
+                                       hsize_t maxChunkRows,
+                                       Shuffle shuffle = Shuffle::NONE);
 
       template <size_t NDIMS>
       herr_t
-      setDefaultChunking(PropertyList & cprops, dims_t<NDIMS> const & dims);
+      setDefaultChunking(PropertyList & cprops, dims_t<NDIMS> const & dims,
+                         std::size_t rowBytes, std::size_t chunkBytes,
+                         hsize_t maxChunkRows);
     }
   }
 }
@@ -38,33 +401,311 @@ template <typename... Args>
 struct hep_hpc::hdf5::detail::NtupleDataStructure {
   NtupleDataStructure(hid_t file, std::string const & name,
                       TranslationMode mode,
-                      bool overwriteContents,
+                      NtupleOverwriteFlag overwriteContents,
+                      bool rowLayout,
+                      std::size_t chunkBytes,
+                      hsize_t maxChunkRows,
+                      Shuffle shuffle,
                       permissive_column<Args> const & ... cols);
 
   static constexpr auto nColumns = sizeof...(Args);
 
+  // Trim the extents of all datasets to the rows written.
+  herr_t trim();
+
+  // Flush all datasets to file (SWMR).
+  herr_t flushDatasets();
+
+  // Create (or, if appending, open) the chunk statistics datasets of
+  // the arithmetic columns.
+  void enableStatistics();
+
+  // Write the chunk statistics accumulated so far (see
+  // ChunkStatistics::write()).
+  herr_t writeStatistics(bool force);
+
+  // Rows written to file so far.
+  hsize_t rowsWritten() const
+    { return (nColumns == 0ull) ? 0ull :
+        (rowOffsets[0] < 0) ? state[0].size : rowState.size; }
+
   std::tuple<permissive_column<Args>...> columns;
   Group group;
+  // Appending to an existing table.
+  bool const appending;
+  // The shares of the chunk cache budget (see
+  // hep_hpc/hdf5/ChunkCache.hpp) held by the datasets below.
+  std::vector<ChunkCacheReservation> cacheReservations {};
   std::array<Dataset, nColumns> dsets;
+
+  // Row-wise layout only: the dataset of compound type holding all
+  // fixed-size columns (whose entries in dsets are invalid), its
+  // memory type, write state, each column's offset in a row (or -1 if
+  // not a member), and the size of a row in memory.
+  Dataset rows {};
+  Datatype rowMemType {};
+  ColumnWriteState rowState {};
+  std::array<std::ptrdiff_t, nColumns> rowOffsets;
+  std::size_t rowSize {0ull};
+  std::vector<unsigned char> rowBuffer {};
+
+  // Threads compressing chunks for direct chunk writing, if enabled.
+  std::unique_ptr<ThreadPool> compressors {};
+  // Per-column write state.
+  std::array<ColumnWriteState, nColumns> state {};
+  // Rows held back from the previous write to complete a chunk.
+  std::tuple<column_buffer_t<typename permissive_column<Args>::element_type>...>
+  carry;
+  // Only write whole chunks (barring an explicit flush).
+  bool chunkAligned {true};
+  // Writes which began within an already-written chunk.
+  std::atomic<std::size_t> chunkRewrites {0ull};
+  // Memory held by rowBuffer and carry (and by the buffers of an
+  // asynchronous writer thread), in bytes, as recorded by the last
+  // thread to modify them, for reading by any other.
+  std::atomic<std::size_t> heldBytes {0ull};
+  // File is in SWMR-write mode: flush datasets after each write.
+  bool swmr {false};
+  // Per-chunk statistics of each column (see ChunkStatistics), if
+  // enabled, and the group holding them.
+  std::tuple<ChunkStatistics<typename permissive_column<Args>::element_type>...>
+  statistics {};
+  Group statisticsGroup {};
+  // Companions of each column (see column_companion).
+  std::tuple<column_companion_t<typename permissive_column<Args>::element_type>...>
+  companions {};
+  // Names of the key columns to index on close (see KeyIndex.hpp).
+  std::vector<std::string> keyColumns {};
+
+private:
+  template <std::size_t... I>
+  void openCompanions_(TranslationMode mode,
+                       hep_hpc::detail::index_sequence<I...>);
+
+  template <std::size_t... I>
+  void enableStatistics_(hep_hpc::detail::index_sequence<I...>);
+
+  template <std::size_t... I>
+  herr_t writeStatistics_(bool force, bool flush,
+                          hep_hpc::detail::index_sequence<I...>);
 };
 
 template <typename... Args>
 hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::
 NtupleDataStructure(hid_t const file, std::string const & name,
                     TranslationMode mode,
-                    bool const overwriteContents,
+                    NtupleOverwriteFlag const overwriteContents,
+                    bool const rowLayout,
+                    std::size_t const chunkBytes,
+                    hsize_t const maxChunkRows,
+                    Shuffle const shuffle,
                     permissive_column<Args> const & ... cols)
   :
   columns(cols...),
   group(makeGroup(file, name, overwriteContents)),
-  dsets({makeDataset(group, cols, mode)...})
+  appending(overwriteContents == NtupleOverwriteFlag::APPEND && hasLinks(group)),
+  dsets({(rowLayout && inRowDataset(cols)) ?
+        Dataset{} :
+        makeOrOpenDataset(group,
+                          storedColumn(cols,
+                                       is_bit_column<permissive_column<Args> >{}),
+                          mode, appending, chunkBytes, maxChunkRows,
+                          shuffle, cacheReservations)...})
+{
+  rowOffsets.fill(-1);
+  if (rowLayout) {
+    std::vector<RowMember> members;
+    std::vector<std::size_t> columnIndex;
+    std::size_t i = 0;
+    using swallow = int[];
+    (void) swallow {0,
+        ((inRowDataset(cols) ?
+          (members.push_back({cols.name(),
+                  cols.engine_type(mode),
+                  cols.engine_type(TranslationMode::NONE),
+                  (cols.elementSize() == 1ull) ? std::vector<hsize_t>{} :
+                  std::vector<hsize_t>(cols.dims(), cols.dims() + cols.nDims())}),
+           columnIndex.push_back(i)) :
+          (void) 0), ++i, 0)...};
+    if (!members.empty()) {
+      std::vector<std::size_t> offsets;
+      cacheReservations.emplace_back();
+      rows = makeRowDataset(group, members, appending, chunkBytes,
+                            maxChunkRows, rowMemType, offsets,
+                            cacheReservations.back());
+      for (std::size_t m = 0; m != members.size(); ++m) {
+        rowOffsets[columnIndex[m]] = offsets[m];
+      }
+      rowSize = H5Tget_size(rowMemType);
+      seedWriteState(rows, rowState);
+    }
+  }
+  for (std::size_t i = 0; i != nColumns; ++i) {
+    if (rowOffsets[i] >= 0) {
+      // Column is stored in rows.
+      state[i].chunkRows = rowState.chunkRows;
+      state[i].size = state[i].extent = rowState.size;
+      continue;
+    }
+    seedWriteState(dsets[i], state[i]);
+  }
+  // All columns must resume from the same row.
+  if (std::any_of(std::begin(state), std::end(state),
+                  [this](ColumnWriteState const & s)
+                  { return s.size != state[0].size; })) {
+    throw std::runtime_error("Cannot append to Ntuple " + name +
+                             ": existing columns have differing numbers of rows.");
+  }
+  openCompanions_(mode, hep_hpc::detail::make_index_sequence<nColumns>());
+}
+
+template <typename... Args>
+template <std::size_t... I>
+void
+hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::
+openCompanions_(TranslationMode const mode,
+                hep_hpc::detail::index_sequence<I...>)
+{
+  using std::get;
+  using swallow = int[];
+  (void) swallow {0,
+      (openCompanion(get<I>(companions), group, get<I>(columns), mode,
+                     appending), 0)...};
+}
+
+template <typename... Args>
+herr_t
+hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::trim()
+{
+  herr_t result = 0;
+  for (std::size_t i = 0; i != nColumns; ++i) {
+    if (rowOffsets[i] < 0) {
+      result |= trimExtent(dsets[i], state[i]);
+    }
+  }
+  if (rows) {
+    result |= trimExtent(rows, rowState);
+  }
+  return result;
+}
+
+template <typename... Args>
+herr_t
+hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::flushDatasets()
+{
+  herr_t result = 0;
+  for (auto & dset : dsets) {
+    if (dset) {
+      result |= dset.flush();
+    }
+  }
+  if (rows) {
+    result |= rows.flush();
+  }
+  if (statisticsGroup) {
+    result |= writeStatistics_(false, true,
+                               hep_hpc::detail::make_index_sequence<nColumns>());
+  }
+  return result;
+}
+
+template <typename... Args>
+inline
+void
+hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::enableStatistics()
+{
+  enableStatistics_(hep_hpc::detail::make_index_sequence<nColumns>());
+}
+
+template <typename... Args>
+template <std::size_t... I>
+void
+hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::
+enableStatistics_(hep_hpc::detail::index_sequence<I...>)
+{
+  using std::get;
+  {
+    ScopedErrorHandler seh;
+    statisticsGroup = Group(group, STATISTICS_GROUP, Group::OPEN_MODE);
+  }
+  if (appending && !statisticsGroup) {
+    throw std::runtime_error("Cannot enable chunk statistics when appending "
+                             "to a table without them.");
+  }
+  if (!statisticsGroup) {
+    statisticsGroup = Group(group, STATISTICS_GROUP);
+  }
+  using swallow = int[];
+  (void) swallow {0,
+      (get<I>(statistics).open(statisticsGroup,
+                               get<I>(columns).name(),
+                               (rowOffsets[I] < 0) ? state[I].chunkRows :
+                               rowState.chunkRows,
+                               get<I>(columns).elementSize(),
+                               state[I].size,
+                               appending), 0)...};
+}
+
+template <typename... Args>
+inline
+herr_t
+hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::
+writeStatistics(bool const force)
 {
+  return statisticsGroup ?
+    writeStatistics_(force, false,
+                     hep_hpc::detail::make_index_sequence<nColumns>()) :
+    0;
+}
+
+template <typename... Args>
+template <std::size_t... I>
+herr_t
+hep_hpc::hdf5::detail::NtupleDataStructure<Args...>::
+writeStatistics_(bool const force, bool const flush,
+                 hep_hpc::detail::index_sequence<I...>)
+{
+  using std::get;
+  herr_t result = 0;
+  using swallow = int[];
+  (void) swallow {0,
+      (result |= (flush ? get<I>(statistics).flush() :
+                  get<I>(statistics).write(force)), 0)...};
+  return result;
+}
+
+template <typename COL>
+inline
+bool
+hep_hpc::hdf5::detail::isRowColumn(COL const & col)
+{
+  // Columns buffered other than as a plain array of their elements
+  // (dictionary-encoded strings, jagged arrays, bit-packed flags)
+  // have companions to write.
+  using element_type = typename COL::element_type;
+  return std::is_same<column_buffer_t<element_type>,
+                      std::vector<element_type> >::value &&
+    isRowMember(col.engine_type(TranslationMode::NONE));
+}
+
+template <typename COL>
+inline
+bool
+hep_hpc::hdf5::detail::inRowDataset(COL const & col)
+{
+  return isRowColumn(col) &&
+    col.linkCreationProperties().is_default() &&
+    col.datasetCreationProperties().is_default() &&
+    col.datasetAccessProperties().is_default();
 }
 
 template <typename COL>
 hep_hpc::hdf5::Dataset
 hep_hpc::hdf5::detail::
-makeDataset(hid_t const group, COL const & col, TranslationMode mode)
+makeDataset(hid_t const group, COL const & col, TranslationMode mode,
+            std::size_t const chunkBytes, hsize_t const maxChunkRows,
+            Shuffle const shuffle,
+            std::vector<ChunkCacheReservation> & reservations)
 {
   // Cause an exception to be thrown if we have an HDF5 issue.
   ScopedErrorHandler seh(ErrorMode::EXCEPTION);
@@ -74,30 +715,70 @@ makeDataset(hid_t const group, COL const & col, TranslationMode mode)
   auto maxdims = dims;
   maxdims[0] = H5S_UNLIMITED;
   // Create and return appropriately constructed dataset.
+  std::size_t const rowBytes =
+    col.elementSize() * H5Tget_size(col.engine_type(mode));
   PropertyList cdprops = col.datasetCreationProperties();
   if (cdprops.is_default()) {
     // Default chunking and compression.
-    cdprops = defaultDatasetCreationProperties(dims);
+    cdprops =
+      defaultDatasetCreationProperties(dims, rowBytes, chunkBytes,
+                                       maxChunkRows,
+                                       defaultShuffle(col.engine_type(mode),
+                                                      shuffle));
   } else if (H5Pget_layout(cdprops) != H5D_CHUNKED) {
     // Add defaulted chunking information to the provided dataset
     // creation properties.
-    (void) setDefaultChunking(cdprops, dims);
+    (void) setDefaultChunking(cdprops, dims, rowBytes, chunkBytes,
+                              maxChunkRows);
+  }
+  PropertyList daprops = col.datasetAccessProperties();
+  if (daprops.is_default()) {
+    reservations.emplace_back();
+    daprops =
+      chunkCacheProperties(chunkSizeBytes(cdprops, col.engine_type(mode)),
+                           ChunkAccess::APPEND,
+                           reservations.back());
   }
   return Dataset(group, col.name(), col.engine_type(mode),
                  Dataspace{dims.size(), dims.data(), maxdims.data()},
                  col.linkCreationProperties(),
                  std::move(cdprops),
-                 col.datasetAccessProperties());
+                 std::move(daprops));
+}
+
+template <typename COL>
+hep_hpc::hdf5::Dataset
+hep_hpc::hdf5::detail::
+makeOrOpenDataset(hid_t const group, COL const & col,
+                  TranslationMode const mode, bool const append,
+                  std::size_t const chunkBytes, hsize_t const maxChunkRows,
+                  Shuffle const shuffle,
+                  std::vector<ChunkCacheReservation> & reservations)
+{
+  if (append) {
+    reservations.emplace_back();
+    return openDataset(group, col.name(), col.engine_type(mode),
+                       std::vector<hsize_t>(col.dims(), col.dims() + col.nDims()),
+                       reservations.back(),
+                       col.datasetAccessProperties());
+  }
+  return makeDataset(group, col, mode, chunkBytes, maxChunkRows, shuffle,
+                     reservations);
 }
 
 template <size_t NDIMS>
 hep_hpc::hdf5::PropertyList
 hep_hpc::hdf5::detail::
-defaultDatasetCreationProperties(dims_t<NDIMS> const & dims)
+defaultDatasetCreationProperties(dims_t<NDIMS> const & dims,
+                                 std::size_t const rowBytes,
+                                 std::size_t const chunkBytes,
+                                 hsize_t const maxChunkRows,
+                                 Shuffle const shuffle)
 {
   // Set up creation properties of the dataset.
   PropertyList cprops(H5P_DATASET_CREATE);
-  setDefaultChunking(cprops, dims);
+  setDefaultChunking(cprops, dims, rowBytes, chunkBytes, maxChunkRows);
+  setShuffle(cprops, shuffle);
   unsigned int const compressionLevel = 6;
   // Set compression level.
   ErrorController::call(&H5Pset_deflate, cprops, compressionLevel);
@@ -108,10 +789,13 @@ template <size_t NDIMS>
 herr_t
 hep_hpc::hdf5::detail::
 setDefaultChunking(PropertyList & cprops,
-                   dims_t<NDIMS> const & dims)
+                   dims_t<NDIMS> const & dims,
+                   std::size_t const rowBytes,
+                   std::size_t const chunkBytes,
+                   hsize_t const maxChunkRows)
 {
   auto chunking = dims;
-  chunking[0] = DEFAULT_CHUNKING;
+  chunking[0] = defaultChunkRows(rowBytes, chunkBytes, maxChunkRows);
   // Set chunking.
   return ErrorController::call(&H5Pset_chunk, cprops, chunking.size(), chunking.data());
 }
@@ -0,0 +1,88 @@
+#include "hep_hpc/hdf5/detail/NtupleWriterThread.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+hep_hpc::hdf5::detail::NtupleWriterThread::
+NtupleWriterThread(std::function<int()> work)
+  :
+  work_(std::move(work)),
+  thread_(&NtupleWriterThread::run_, this)
+{
+}
+
+hep_hpc::hdf5::detail::NtupleWriterThread::
+~NtupleWriterThread() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lock {mutex_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void
+hep_hpc::hdf5::detail::NtupleWriterThread::
+wait()
+{
+  std::unique_lock<std::mutex> lock {mutex_};
+  cv_.wait(lock, [this] { return !pending_; });
+  if (error_) {
+    std::exception_ptr error;
+    std::swap(error, error_);
+    std::rethrow_exception(error);
+  }
+}
+
+void
+hep_hpc::hdf5::detail::NtupleWriterThread::
+submit()
+{
+  {
+    std::lock_guard<std::mutex> lock {mutex_};
+    if (pending_) {
+      again_ = true;
+    } else {
+      pending_ = true;
+    }
+  }
+  cv_.notify_all();
+}
+
+void
+hep_hpc::hdf5::detail::NtupleWriterThread::
+run_()
+{
+  // Error handling configuration is per-thread.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  std::unique_lock<std::mutex> lock {mutex_};
+  while (true) {
+    cv_.wait(lock, [this] { return pending_ || stop_; });
+    if (!pending_) { // Stop requested with no outstanding work.
+      break;
+    }
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      if (work_() != 0) {
+        throw std::runtime_error("HDF5 write failure.");
+      }
+    }
+    catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    if (error) {
+      error_ = std::move(error);
+    }
+    if (again_ && !error_) {
+      again_ = false;
+      continue;
+    }
+    again_ = false;
+    pending_ = false;
+    cv_.notify_all();
+  }
+}
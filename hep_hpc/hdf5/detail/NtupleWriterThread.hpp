@@ -0,0 +1,70 @@
+#ifndef hep_hpc_hdf5_detail_NtupleWriterThread_hpp
+#define hep_hpc_hdf5_detail_NtupleWriterThread_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::NtupleWriterThread
+//
+// A dedicated thread executing one unit of work (typically: write the
+// contents of a set of Ntuple buffers to file) at a time on behalf of
+// its owner.
+//
+// The owner is expected to call wait() before modifying any state used
+// by the work function, and submit() to have the work function executed
+// once on the writer thread. If work is outstanding when submit() is
+// called, the work function will be executed again after it
+// completes. A non-zero return from the work function, or an exception
+// thrown by it, is reported by the next call to wait().
+//
+// HDF5 calls made by the work function will throw on failure
+// (ErrorMode::EXCEPTION is configured for the writer thread).
+//
+// Destruction completes any outstanding work before joining the
+// thread; any error so encountered is discarded, so owners wishing to
+// report such errors should call wait() first.
+//
+////////////////////////////////////////////////////////////////////////
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      class NtupleWriterThread;
+    }
+  }
+}
+
+class hep_hpc::hdf5::detail::NtupleWriterThread {
+public:
+  explicit NtupleWriterThread(std::function<int()> work);
+  ~NtupleWriterThread() noexcept;
+
+  // Block until outstanding work is complete; rethrow any failure.
+  void wait();
+
+  // Execute the work function (again) on the writer thread.
+  void submit();
+
+  NtupleWriterThread(NtupleWriterThread const &) = delete;
+  NtupleWriterThread & operator = (NtupleWriterThread const &) = delete;
+
+private:
+  void run_();
+
+  std::function<int()> work_;
+  std::mutex mutex_ {};
+  std::condition_variable cv_ {};
+  bool pending_ {false};
+  bool again_ {false};
+  bool stop_ {false};
+  std::exception_ptr error_ {};
+  std::thread thread_;
+};
+
+#endif /* hep_hpc_hdf5_detail_NtupleWriterThread_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
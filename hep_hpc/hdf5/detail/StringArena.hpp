@@ -0,0 +1,112 @@
+#ifndef hep_hpc_hdf5_detail_StringArena_hpp
+#define hep_hpc_hdf5_detail_StringArena_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::StringArena
+//
+// Buffer for the contents of a variable-length string column: the
+// characters of all strings are stored contiguously (each
+// null-terminated) in a single pool, with a vector of offsets into
+// it. Once the pool has grown to the size required to hold a full
+// buffer, appending strings requires no memory allocation: clear()
+// retains the storage.
+//
+// data() provides the array of char const * required by HDF5 to write
+// the strings, valid until the next modification of the arena.
+//
+////////////////////////////////////////////////////////////////////////
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      class StringArena;
+    }
+  }
+}
+
+class hep_hpc::hdf5::detail::StringArena {
+public:
+  // Number of strings.
+  std::size_t size() const { return offsets_.size(); }
+
+  void reserve(std::size_t nStrings) { offsets_.reserve(nStrings); }
+
+  // Memory allocated, in bytes.
+  std::size_t capacityBytes() const
+    { return chars_.capacity() +
+        offsets_.capacity() * sizeof(std::size_t) +
+        pointers_.capacity() * sizeof(char const *); }
+
+  // Remove all strings, retaining storage.
+  void clear() { chars_.clear(); offsets_.clear(); }
+
+  // Append n strings (nullptr: n empty strings). A null char const *
+  // is stored as an empty string.
+  void append(std::string const * strings, std::size_t n);
+  void append(char const * const * strings, std::size_t n);
+
+  char const * const * data();
+
+private:
+  void append_(char const * s, std::size_t len);
+
+  std::vector<char> chars_ {};
+  std::vector<std::size_t> offsets_ {};
+  std::vector<char const *> pointers_ {};
+};
+
+inline
+void
+hep_hpc::hdf5::detail::StringArena::
+append(std::string const * const strings, std::size_t const n)
+{
+  for (std::size_t i = 0; i != n; ++i) {
+    if (strings == nullptr) {
+      append_(nullptr, 0ull);
+    } else {
+      append_(strings[i].data(), strings[i].size());
+    }
+  }
+}
+
+inline
+void
+hep_hpc::hdf5::detail::StringArena::
+append(char const * const * const strings, std::size_t const n)
+{
+  for (std::size_t i = 0; i != n; ++i) {
+    char const * const s = (strings == nullptr) ? nullptr : strings[i];
+    append_(s, (s == nullptr) ? 0ull : std::strlen(s));
+  }
+}
+
+inline
+char const * const *
+hep_hpc::hdf5::detail::StringArena::
+data()
+{
+  pointers_.resize(offsets_.size());
+  for (std::size_t i = 0; i != offsets_.size(); ++i) {
+    pointers_[i] = chars_.data() + offsets_[i];
+  }
+  return pointers_.data();
+}
+
+inline
+void
+hep_hpc::hdf5::detail::StringArena::
+append_(char const * const s, std::size_t const len)
+{
+  offsets_.push_back(chars_.size());
+  chars_.insert(chars_.end(), s, s + len);
+  chars_.push_back('\0');
+}
+
+#endif /* hep_hpc_hdf5_detail_StringArena_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,153 @@
+#include "hep_hpc/hdf5/detail/StringDictionary.hpp"
+
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/Datatype.hpp"
+#include "hep_hpc/hdf5/Group.hpp"
+#include "hep_hpc/hdf5/PropertyList.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+  hep_hpc::hdf5::Datatype stringType()
+  {
+    hep_hpc::hdf5::Datatype result(H5Tcopy(H5T_C_S1));
+    H5Tset_size(result, H5T_VARIABLE);
+    return result;
+  }
+}
+
+std::vector<std::string>
+hep_hpc::hdf5::detail::readDictionary(hid_t const group,
+                                      std::string const & name)
+{
+  // Cause an exception to be thrown if we have an HDF5 issue.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  Dataset dset(group, std::string(DICTIONARY_GROUP) + "/" + name);
+  Dataspace const space(H5Dget_space(dset));
+  std::vector<char *> values(H5Sget_simple_extent_npoints(space));
+  std::vector<std::string> result;
+  if (values.empty()) {
+    return result;
+  }
+  dset.read(stringType(), values.data());
+  result.reserve(values.size());
+  for (auto const value : values) {
+    result.emplace_back((value == nullptr) ? "" : value);
+    H5free_memory(value);
+  }
+  return result;
+}
+
+void
+hep_hpc::hdf5::detail::StringDictionary::open(hid_t const group,
+                                              std::string const & name,
+                                              bool const append)
+{
+  // Cause an exception to be thrown if we have an HDF5 issue.
+  ScopedErrorHandler seh(ErrorMode::EXCEPTION);
+  bool const exists =
+    (H5Lexists(group, DICTIONARY_GROUP, H5P_DEFAULT) > 0);
+  Group const dictionaries(group, DICTIONARY_GROUP,
+                           exists ? Group::OPEN_MODE : Group::CREATE_MODE);
+  if (append) {
+    if (!exists ||
+        H5Lexists(dictionaries, name.c_str(), H5P_DEFAULT) <= 0) {
+      throw std::runtime_error("Cannot append to dictionary-encoded column " +
+                               name + ": no dictionary found.");
+    }
+    auto const entries = readDictionary(group, name);
+    for (auto const & entry : entries) {
+      codes_.emplace(entry, static_cast<code_type>(codes_.size()));
+    }
+    written_ = entries.size();
+    dset_ = Dataset(dictionaries, name);
+    return;
+  }
+  hsize_t const dims = 0ull, maxdims = H5S_UNLIMITED, chunking = 256ull;
+  PropertyList cprops(H5P_DATASET_CREATE);
+  H5Pset_chunk(cprops, 1, &chunking);
+  H5Pset_deflate(cprops, 6u);
+  dset_ = Dataset(dictionaries, name, stringType(),
+                  Dataspace{1, &dims, &maxdims},
+                  {},
+                  std::move(cprops));
+}
+
+auto
+hep_hpc::hdf5::detail::StringDictionary::
+encode(char const * const * const strings, std::size_t const n)
+-> std::vector<code_type> const &
+{
+  scratch_.resize(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    char const * const s = strings[i];
+    scratch_[i] = code_(s, (s == nullptr) ? 0ull : std::strlen(s));
+  }
+  return scratch_;
+}
+
+auto
+hep_hpc::hdf5::detail::StringDictionary::
+encode(std::string const * const strings, std::size_t const n)
+-> std::vector<code_type> const &
+{
+  scratch_.resize(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    scratch_[i] = code_(strings[i].data(), strings[i].size());
+  }
+  return scratch_;
+}
+
+herr_t
+hep_hpc::hdf5::detail::StringDictionary::write()
+{
+  herr_t rc = 0;
+  if (pending_.empty()) {
+    return rc;
+  }
+  hsize_t const n = pending_.size();
+  hsize_t const extent = written_ + n;
+  if ((rc = ErrorController::call(&H5Dset_extent, dset_, &extent)) != 0) {
+    return rc;
+  }
+  Dataspace fileSpace(ErrorController::call(&H5Dget_space, dset_));
+  if ((rc = ErrorController::call(&H5Sselect_hyperslab, fileSpace,
+                                  H5S_SELECT_SET, &written_, nullptr,
+                                  &n, nullptr)) != 0) {
+    return rc;
+  }
+  std::vector<char const *> cbuf;
+  cbuf.reserve(n);
+  for (auto const & entry : pending_) {
+    cbuf.push_back(entry.c_str());
+  }
+  if ((rc = dset_.write(stringType(), cbuf.data(), Dataspace{1, &n, &n},
+                        std::move(fileSpace))) == 0) {
+    written_ = extent;
+    pending_.clear();
+  }
+  return rc;
+}
+
+auto
+hep_hpc::hdf5::detail::StringDictionary::
+code_(char const * const s, std::size_t const len)
+-> code_type
+{
+  key_.assign((s == nullptr) ? "" : s, len);
+  auto const i = codes_.find(key_);
+  if (i != codes_.end()) {
+    return i->second;
+  }
+  if (codes_.size() == std::numeric_limits<code_type>::max()) {
+    throw std::runtime_error("Too many distinct strings for a "
+                             "dictionary-encoded column.");
+  }
+  auto const code = static_cast<code_type>(codes_.size());
+  codes_.emplace(key_, code);
+  pending_.push_back(key_);
+  return code;
+}
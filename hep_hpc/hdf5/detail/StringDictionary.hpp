@@ -0,0 +1,82 @@
+#ifndef hep_hpc_hdf5_detail_StringDictionary_hpp
+#define hep_hpc_hdf5_detail_StringDictionary_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::StringDictionary
+//
+// The dictionary of a dictionary-encoded string column (see
+// hep_hpc::hdf5::dict_string in hep_hpc/hdf5/Column.hpp): each distinct
+// string is assigned the next integer code on first sight, and the
+// column's dataset holds the codes. The strings are written, in code
+// order, to a one-dimensional variable-length string dataset named for
+// the column in the subgroup _dictionary of the Ntuple's group as
+// they are added, so that the entry with index i of the dictionary
+// dataset is the string with code i.
+//
+////////////////////////////////////////////////////////////////////////
+#include "hep_hpc/hdf5/Column.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+
+#include "hdf5.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      class StringDictionary;
+
+      // Name of the group (within the Ntuple's group) holding the
+      // dictionary datasets.
+      constexpr char const * const DICTIONARY_GROUP = "_dictionary";
+
+      // Read the dictionary of column name of the Ntuple in group.
+      std::vector<std::string> readDictionary(hid_t group,
+                                              std::string const & name);
+    }
+  }
+}
+
+class hep_hpc::hdf5::detail::StringDictionary {
+public:
+  using code_type = std::uint32_t;
+
+  // Create (or, if append, open and read) the dictionary dataset of
+  // column name of the Ntuple in group.
+  void open(hid_t group, std::string const & name, bool append);
+
+  // Encode n strings (a null char const * as an empty string), adding
+  // any new ones to the dictionary. The codes are valid until the next
+  // call.
+  std::vector<code_type> const & encode(char const * const * strings,
+                                        std::size_t n);
+  std::vector<code_type> const & encode(std::string const * strings,
+                                        std::size_t n);
+
+  // Write the strings added since the last write.
+  herr_t write();
+
+  // Number of distinct strings.
+  std::size_t size() const { return codes_.size(); }
+
+private:
+  code_type code_(char const * s, std::size_t len);
+
+  std::unordered_map<std::string, code_type> codes_ {};
+  // Strings added since the last write.
+  std::vector<std::string> pending_ {};
+  hsize_t written_ {0ull};
+  Dataset dset_ {};
+  // Reused lookup key and output buffer.
+  std::string key_ {};
+  std::vector<code_type> scratch_ {};
+};
+
+#endif /* hep_hpc_hdf5_detail_StringDictionary_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,98 @@
+#include "hep_hpc/hdf5/detail/ThreadPool.hpp"
+
+#include <utility>
+
+hep_hpc::hdf5::detail::ThreadPool::
+ThreadPool(unsigned int const nThreads)
+{
+  threads_.reserve(nThreads);
+  for (unsigned int i = 0; i != nThreads; ++i) {
+    threads_.emplace_back(&ThreadPool::run_, this);
+  }
+}
+
+hep_hpc::hdf5::detail::ThreadPool::
+~ThreadPool() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lock {mutex_};
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto & thread : threads_) {
+    thread.join();
+  }
+}
+
+void
+hep_hpc::hdf5::detail::ThreadPool::
+parallel_for(std::size_t const nTasks,
+             std::function<void(std::size_t)> const & task)
+{
+  if (nTasks == 0ull) {
+    return;
+  }
+  std::lock_guard<std::mutex> serial {submitMutex_};
+  {
+    std::lock_guard<std::mutex> lock {mutex_};
+    task_ = &task;
+    nTasks_ = nTasks;
+    next_ = 0ull;
+    done_ = 0ull;
+    ++generation_;
+  }
+  cv_.notify_all();
+  work_();
+  std::unique_lock<std::mutex> lock {mutex_};
+  // Wait also for workers to stop looking at this loop.
+  doneCv_.wait(lock, [this] { return done_ == nTasks_ && active_ == 0u; });
+  task_ = nullptr;
+  if (error_) {
+    std::exception_ptr error;
+    std::swap(error, error_);
+    std::rethrow_exception(error);
+  }
+}
+
+void
+hep_hpc::hdf5::detail::ThreadPool::
+run_()
+{
+  std::uint64_t seen = 0ull;
+  std::unique_lock<std::mutex> lock {mutex_};
+  while (true) {
+    cv_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+    if (stop_) {
+      break;
+    }
+    seen = generation_;
+    ++active_;
+    lock.unlock();
+    work_();
+    lock.lock();
+    if (--active_ == 0u) {
+      doneCv_.notify_all();
+    }
+  }
+}
+
+void
+hep_hpc::hdf5::detail::ThreadPool::
+work_()
+{
+  for (std::size_t i; (i = next_++) < nTasks_; ) {
+    try {
+      (*task_)(i);
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock {mutex_};
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+    if (++done_ == nTasks_) {
+      std::lock_guard<std::mutex> lock {mutex_};
+      doneCv_.notify_all();
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef hep_hpc_hdf5_detail_ThreadPool_hpp
+#define hep_hpc_hdf5_detail_ThreadPool_hpp
+////////////////////////////////////////////////////////////////////////
+// hep_hpc::hdf5::detail::ThreadPool
+//
+// A fixed set of worker threads executing the iterations of one
+// parallel loop at a time (typically: compress the chunks of an Ntuple
+// column prior to writing them directly to file).
+//
+// parallel_for() executes task(i) for each i in [0, nTasks) on the
+// worker threads and on the calling thread, returning when all have
+// completed. The first exception thrown by any invocation of task is
+// rethrown by parallel_for(). Concurrent calls to parallel_for() are
+// serialized.
+//
+// Tasks must not call HDF5 functions.
+//
+////////////////////////////////////////////////////////////////////////
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    namespace detail {
+      class ThreadPool;
+    }
+  }
+}
+
+class hep_hpc::hdf5::detail::ThreadPool {
+public:
+  // nThreads worker threads in addition to the calling thread.
+  explicit ThreadPool(unsigned int nThreads);
+  ~ThreadPool() noexcept;
+
+  void parallel_for(std::size_t nTasks,
+                    std::function<void(std::size_t)> const & task);
+
+  std::size_t size() const { return threads_.size(); }
+
+  ThreadPool(ThreadPool const &) = delete;
+  ThreadPool & operator = (ThreadPool const &) = delete;
+
+private:
+  void run_();
+  void work_();
+
+  std::mutex submitMutex_ {};
+  std::mutex mutex_ {};
+  std::condition_variable cv_ {};
+  std::condition_variable doneCv_ {};
+  std::function<void(std::size_t)> const * task_ {nullptr};
+  std::size_t nTasks_ {0ull};
+  std::atomic<std::size_t> next_ {0ull};
+  std::atomic<std::size_t> done_ {0ull};
+  std::uint64_t generation_ {0ull};
+  unsigned int active_ {0u};
+  bool stop_ {false};
+  std::exception_ptr error_ {};
+  std::vector<std::thread> threads_ {};
+};
+
+#endif /* hep_hpc_hdf5_detail_ThreadPool_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -21,14 +21,27 @@
 // make_column(std::string name,
 //             <dimensions> dims,
 //             [size_t elementsPerChunk,]
+//             [Precision precision,]
 //             std::initializer_list<PropertyList> props = {})
 //
 // template <typename T>
 // Column<T, NDIMS>
 // make_scalar_column(std::string name,
 //                    [size_t elementsPerChunk,]
+//                    [Precision precision,]
 //                    std::initializer_list<PropertyList> props = {})
 //
+// struct Precision { unsigned mantissaBits; };
+//
+//   For columns of float or double only: store values rounded to
+//   mantissaBits explicit mantissa bits, with a relative error of at
+//   most 2^-(mantissaBits + 1) for normal values (see "Reduced
+//   precision" in hep_hpc/hdf5/Column.hpp for subnormal ones), e.g.:
+//
+//     make_scalar_column<float>("adc", Precision{10})
+//
+//   keeps about three significant decimal digits.
+//
 ////////////////////////////////////////////////////////////////////////
 #include "hep_hpc/hdf5/Column.hpp"
 #include "hep_hpc/hdf5/PropertyList.hpp"
@@ -36,13 +49,43 @@
 #include "hdf5.h"
 
 #include <cassert>
+#include <type_traits>
 
 namespace hep_hpc {
   namespace hdf5 {
+    struct Precision {
+      unsigned mantissaBits;
+    };
+
+    template <typename T, size_t NDIMS = 1>
+    Column<T, NDIMS>
+    make_column(std::string name,
+                typename Column<T, NDIMS>::dims_t dims,
+                std::initializer_list<PropertyList> props = {});
+
+    template <typename T, size_t NDIMS = 1>
+    Column<T, NDIMS>
+    make_column(std::string name,
+                typename Column<T, NDIMS>::dims_t dims,
+                size_t elementsPerChunk,
+                std::initializer_list<PropertyList> props = {});
+
+    template <typename T>
+    Column<T, 1ull>
+    make_scalar_column(std::string name,
+                       std::initializer_list<PropertyList> props = {});
+
+    template <typename T>
+    Column<T, 1ull>
+    make_scalar_column(std::string name,
+                       size_t elementsPerChunk,
+                       std::initializer_list<PropertyList> props = {});
+
     template <typename T, size_t NDIMS = 1>
     Column<T, NDIMS>
     make_column(std::string name,
                 typename Column<T, NDIMS>::dims_t dims,
+                Precision precision,
                 std::initializer_list<PropertyList> props = {});
 
     template <typename T, size_t NDIMS = 1>
@@ -50,17 +93,20 @@ namespace hep_hpc {
     make_column(std::string name,
                 typename Column<T, NDIMS>::dims_t dims,
                 size_t elementsPerChunk,
+                Precision precision,
                 std::initializer_list<PropertyList> props = {});
 
     template <typename T>
     Column<T, 1ull>
     make_scalar_column(std::string name,
+                       Precision precision,
                        std::initializer_list<PropertyList> props = {});
 
     template <typename T>
     Column<T, 1ull>
     make_scalar_column(std::string name,
                        size_t elementsPerChunk,
+                       Precision precision,
                        std::initializer_list<PropertyList> props = {});
 
     namespace detail {
@@ -151,6 +197,61 @@ hep_hpc::hdf5::make_scalar_column(std::string name,
   return result;
 }
 
+template <typename T, size_t NDIMS>
+inline
+hep_hpc::hdf5::Column<T, NDIMS>
+hep_hpc::hdf5::make_column(std::string name,
+                           typename Column<T, NDIMS>::dims_t dims,
+                           Precision const precision,
+                           std::initializer_list<PropertyList> props)
+{
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                "Precision may only be specified for columns of float or double.");
+  auto result = make_column<T, NDIMS>(std::move(name), std::move(dims),
+                                      std::move(props));
+  result.setMantissaBits(precision.mantissaBits);
+  return result;
+}
+
+template <typename T, size_t NDIMS>
+inline
+hep_hpc::hdf5::Column<T, NDIMS>
+hep_hpc::hdf5::make_column(std::string name,
+                           typename Column<T, NDIMS>::dims_t dims,
+                           size_t const elementsPerChunk,
+                           Precision const precision,
+                           std::initializer_list<PropertyList> props)
+{
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+                "Precision may only be specified for columns of float or double.");
+  auto result = make_column<T, NDIMS>(std::move(name), std::move(dims),
+                                      elementsPerChunk, std::move(props));
+  result.setMantissaBits(precision.mantissaBits);
+  return result;
+}
+
+template <typename T>
+inline
+hep_hpc::hdf5::Column<T, 1ull>
+hep_hpc::hdf5::make_scalar_column(std::string name,
+                                  Precision const precision,
+                                  std::initializer_list<PropertyList> props)
+{
+  return make_column<T>(std::move(name), 1ull, precision, std::move(props));
+}
+
+template <typename T>
+inline
+hep_hpc::hdf5::Column<T, 1ull>
+hep_hpc::hdf5::make_scalar_column(std::string name,
+                                  size_t const elementsPerChunk,
+                                  Precision const precision,
+                                  std::initializer_list<PropertyList> props)
+{
+  return make_column<T>(std::move(name), 1ull, elementsPerChunk, precision,
+                        std::move(props));
+}
+
 template <typename COL>
 void
 hep_hpc::hdf5::detail::
@@ -49,6 +49,16 @@
 //                   [TranslationMode mode,]
 //                   std::size_t bufsize = <default>);
 //
+// NtupleInitializer(hid_t file,
+//                   std::string tablename,
+//                   NtupleOptions options);
+//
+// NtupleInitializer(std::string filename,
+//                   std::string tablename,
+//                   NtupleOptions options);
+//
+//   See hep_hpc/hdf5/NtupleOptions.hpp.
+//
 ////////////////////////////////////////////////////////////////////////
 #include "hep_hpc/hdf5/Ntuple.hpp"
 #include "hep_hpc/hdf5/make_column.hpp"
@@ -104,6 +114,10 @@ public:
                     std::size_t bufsize);
   NtupleInitializer(std::string filename, std::string tablename,
                     std::size_t bufsize);
+  NtupleInitializer(hid_t file, std::string tablename,
+                    NtupleOptions options);
+  NtupleInitializer(std::string filename, std::string tablename,
+                    NtupleOptions options);
 private:
   template <typename NT, typename... Cols>
   NT
@@ -122,6 +136,7 @@ private:
   TranslationMode mode_{TranslationMode::NONE};
   NtupleOverwriteFlag overwriteContents_{NtupleOverwriteFlag::NO};
   std::size_t bufsize_{0ull};
+  NtupleOptions options_{};
 };
 
 hep_hpc::hdf5::NtupleInitializer::
@@ -294,6 +309,30 @@ NtupleInitializer(std::string filename, std::string tablename,
 {
 }
 
+inline
+hep_hpc::hdf5::NtupleInitializer::
+NtupleInitializer(hid_t file, std::string tablename,
+                  NtupleOptions options)
+  :
+  cflag_(14),
+  file_(file),
+  tablename_(std::move(tablename)),
+  options_(std::move(options))
+{
+}
+
+inline
+hep_hpc::hdf5::NtupleInitializer::
+NtupleInitializer(std::string filename, std::string tablename,
+                  NtupleOptions options)
+  :
+  cflag_(15),
+  filename_(std::move(filename)),
+  tablename_(std::move(tablename)),
+  options_(std::move(options))
+{
+}
+
 template <typename NT, typename... Cols>
 NT
 hep_hpc::hdf5::NtupleInitializer::
@@ -358,6 +397,14 @@ initializeNtuple(Cols && ... cols)
     return NT(std::move(filename_), std::move(tablename_),
               typename Ntuple<Cols...>::column_info_t { std::forward<Cols>(cols)... },
               bufsize_);
+  case 14:
+    return NT(file_, std::move(tablename_),
+              typename NT::column_info_t { std::forward<Cols>(cols)... },
+              std::move(options_));
+  case 15:
+    return NT(std::move(filename_), std::move(tablename_),
+              typename NT::column_info_t { std::forward<Cols>(cols)... },
+              std::move(options_));
   default:
     throw std::logic_error("INTERNAL ERROR: in NtupleInitializer::initializeNtuple().");
   }
@@ -0,0 +1,32 @@
+#include "hep_hpc/hdf5/pack_bits.hpp"
+
+void
+hep_hpc::hdf5::
+unpack_bits(unsigned char const * packed, std::size_t const nRows,
+            std::size_t const rowFlags, bool * flags)
+{
+  auto const unpackByte = [](unsigned char const byte, bool * const out)
+    {
+      for (unsigned bit = 0u; bit != 8u; ++bit) {
+        out[bit] = ((byte >> bit) & 1u) != 0u;
+      }
+    };
+  if (rowFlags % 8ull == 0ull) {
+    std::size_t const nBytes = nRows * rowFlags / 8ull;
+    for (std::size_t i = 0; i != nBytes; ++i) {
+      unpackByte(packed[i], flags + i * 8ull);
+    }
+    return;
+  }
+  std::size_t const fullBytes = rowFlags / 8ull;
+  std::size_t const tail = rowFlags % 8ull;
+  for (std::size_t row = 0; row != nRows; ++row, flags += rowFlags) {
+    for (std::size_t i = 0; i != fullBytes; ++i) {
+      unpackByte(*packed++, flags + i * 8ull);
+    }
+    unsigned char const byte = *packed++;
+    for (std::size_t bit = 0; bit != tail; ++bit) {
+      flags[fullBytes * 8ull + bit] = ((byte >> bit) & 1u) != 0u;
+    }
+  }
+}
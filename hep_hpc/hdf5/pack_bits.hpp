@@ -0,0 +1,101 @@
+#ifndef hep_hpc_hdf5_pack_bits_hpp
+#define hep_hpc_hdf5_pack_bits_hpp
+////////////////////////////////////////////////////////////////////////
+// Conversion between arrays of flags and the bit-packed representation
+// used on file by Ntuple columns of bool (see
+// hep_hpc/hdf5/Column.hpp).
+//
+// Each row of rowFlags flags is packed into
+// packed_row_bytes(rowFlags) == (rowFlags + 7) / 8 bytes: flag k of a
+// row (counting in row-major order over the column's dimensions) is
+// bit k % 8 (the least significant bit being bit 0) of byte k / 8 of
+// the row. Unused bits of a row's last byte are zero. Rows are
+// contiguous, with no padding beyond the row's last byte.
+//
+////////////////////////////////////
+// std::size_t packed_row_bytes(std::size_t rowFlags);
+//
+//   The number of bytes to which a row of rowFlags flags is packed.
+//
+// void pack_bits(bool const * flags, std::size_t nRows,
+//                std::size_t rowFlags, unsigned char * packed);
+//
+//   Pack nRows rows of rowFlags flags into
+//   nRows * packed_row_bytes(rowFlags) bytes.
+//
+// void unpack_bits(unsigned char const * packed, std::size_t nRows,
+//                  std::size_t rowFlags, bool * flags);
+//
+//   The inverse of pack_bits(), e.g. for the contents of a column's
+//   dataset as read with a memory type of H5T_NATIVE_B8.
+//
+////////////////////////////////////////////////////////////////////////
+#include <cstddef>
+
+namespace hep_hpc {
+  namespace hdf5 {
+    inline std::size_t packed_row_bytes(std::size_t const rowFlags)
+    { return (rowFlags + 7ull) / 8ull; }
+
+    namespace detail {
+      // Pack nRows rows of rowFlags flags of type B (bool, or one byte
+      // per flag with any non-zero value set).
+      template <typename B>
+      void packBits(B const * flags, std::size_t nRows,
+                    std::size_t rowFlags, unsigned char * packed);
+    }
+
+    inline void pack_bits(bool const * flags, std::size_t nRows,
+                          std::size_t rowFlags, unsigned char * packed)
+    { detail::packBits(flags, nRows, rowFlags, packed); }
+
+    void unpack_bits(unsigned char const * packed, std::size_t nRows,
+                     std::size_t rowFlags, bool * flags);
+  }
+}
+
+template <typename B>
+inline
+void
+hep_hpc::hdf5::detail::
+packBits(B const * flags, std::size_t const nRows,
+         std::size_t const rowFlags, unsigned char * packed)
+{
+  // The fixed-length inner loops over the eight flags of a byte leave
+  // the compiler free to vectorize.
+  auto const packByte = [](B const * const in)
+    {
+      unsigned char byte = 0u;
+      for (unsigned bit = 0u; bit != 8u; ++bit) {
+        byte |= static_cast<unsigned char>((in[bit] != 0) << bit);
+      }
+      return byte;
+    };
+  if (rowFlags % 8ull == 0ull) {
+    // Rows are whole bytes: pack them as one sequence.
+    std::size_t const nBytes = nRows * rowFlags / 8ull;
+    for (std::size_t i = 0; i != nBytes; ++i) {
+      packed[i] = packByte(flags + i * 8ull);
+    }
+    return;
+  }
+  std::size_t const fullBytes = rowFlags / 8ull;
+  std::size_t const tail = rowFlags % 8ull;
+  for (std::size_t row = 0; row != nRows; ++row, flags += rowFlags) {
+    for (std::size_t i = 0; i != fullBytes; ++i) {
+      *packed++ = packByte(flags + i * 8ull);
+    }
+    unsigned char byte = 0u;
+    for (std::size_t bit = 0; bit != tail; ++bit) {
+      byte |= static_cast<unsigned char>
+              ((flags[fullBytes * 8ull + bit] != 0) << bit);
+    }
+    *packed++ = byte;
+  }
+}
+
+#endif /* hep_hpc_hdf5_pack_bits_hpp */
+
+// Local Variables:
+// mode: c++
+// End:
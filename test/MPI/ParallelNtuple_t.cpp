@@ -0,0 +1,70 @@
+#include "hep_hpc/MPI/MPICommunicator.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/ParallelNtuple.hpp"
+#include "hep_hpc/hdf5/make_column.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <vector>
+
+using namespace hep_hpc;
+using namespace hep_hpc::hdf5;
+
+namespace {
+  // Rows inserted by a rank per flush: deliberately uneven, and zero
+  // for rank 1 on the second flush.
+  std::size_t rowsFor(int const rank, int const flush)
+  {
+    return (flush == 1 && rank == 1) ? 0ull : 10ull * (rank + 1) + flush;
+  }
+}
+
+TEST(ParallelNtuple, write)
+{
+  MPICommunicator const wcomm;
+  auto const rank = wcomm.rank();
+  auto const size = wcomm.size();
+  constexpr int nFlushes = 3;
+  {
+    ParallelNtuple<Column<int, 1>, Column<double, 1>>
+      nt(MPICommunicator(), "ParallelNtuple_t.hdf5", "data",
+         {make_scalar_column<int>("rank"), make_column<double>("x", 2)});
+    for (int flush = 0; flush != nFlushes; ++flush) {
+      for (std::size_t i = 0; i != rowsFor(rank, flush); ++i) {
+        double const x[] { i * 1.0, flush * 1.0 };
+        nt.insert(rank, x);
+      }
+      if (flush != nFlushes - 1) {
+        nt.flush();
+      }
+    }
+  } // Final flush on destruction.
+  MPI_Barrier(wcomm);
+  if (rank != 0) {
+    return;
+  }
+  File const file("ParallelNtuple_t.hdf5");
+  std::size_t expected = 0ull;
+  for (int flush = 0; flush != nFlushes; ++flush) {
+    for (int r = 0; r != size; ++r) {
+      expected += rowsFor(r, flush);
+    }
+  }
+  std::vector<int> ranks(expected);
+  std::vector<double> x(2 * expected);
+  Dataset(file, "/data/rank").read(H5T_NATIVE_INT, ranks.data());
+  Dataset(file, "/data/x").read(H5T_NATIVE_DOUBLE, x.data());
+  // Rows of each flush appear in rank order.
+  std::size_t row = 0ull;
+  for (int flush = 0; flush != nFlushes; ++flush) {
+    for (int r = 0; r != size; ++r) {
+      for (std::size_t i = 0; i != rowsFor(r, flush); ++i, ++row) {
+        ASSERT_EQ(ranks[row], r);
+        ASSERT_EQ(x[2 * row], i * 1.0);
+        ASSERT_EQ(x[2 * row + 1], flush * 1.0);
+      }
+    }
+  }
+}
@@ -0,0 +1,53 @@
+// Asynchronous (double-buffered) flushing.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+  template <typename T>
+  std::vector<T> readColumn(File const & file, std::string const & path,
+                            hid_t const memType, std::size_t const n)
+  {
+    std::vector<T> result(n);
+    Dataset ds(file, path);
+    assert(ds);
+    ds.read(memType, result.data());
+    return result;
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  constexpr std::size_t nRows = 1234;
+  {
+    auto data = make_ntuple({"test-ntuple_07.hdf5", "g1",
+          NtupleOptions{}.setBufsize(10).setFlushMode(NtupleFlushMode::ASYNC)},
+      make_scalar_column<int>("A"),
+      make_column<double>("B", 3));
+    for (std::size_t i = 0; i < nRows; ++i) {
+      double const b[] = { i * 1.0, i * 2.0, i * 3.0 };
+      data.insert(static_cast<int>(i), b);
+      if (i == nRows / 2) {
+        data.flush();
+      }
+    }
+    // Move while the writer thread may be busy.
+    auto moved = std::move(data);
+  }
+  File const file("test-ntuple_07.hdf5");
+  auto const a = readColumn<int>(file, "/g1/A", H5T_NATIVE_INT, nRows);
+  auto const b = readColumn<double>(file, "/g1/B", H5T_NATIVE_DOUBLE, nRows * 3);
+  for (std::size_t i = 0; i < nRows; ++i) {
+    assert(a[i] == static_cast<int>(i));
+    assert(b[i * 3 + 2] == i * 3.0);
+  }
+}
@@ -0,0 +1,74 @@
+// Multi-threaded insertion via per-thread staging blocks.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  constexpr int nThreads = 8;
+  constexpr int nPerThread = 2500;
+
+  void writeAndVerify(std::string const & filename,
+                      NtupleFlushMode const flushMode)
+  {
+    {
+      auto data = make_ntuple({filename, "g1",
+            NtupleOptions{}
+            .setBufsize(64)
+            .setFlushMode(flushMode)
+            .setInsertMode(NtupleInsertMode::PER_THREAD)},
+        make_scalar_column<int>("A"),
+        make_scalar_column<double>("B"));
+      std::vector<std::thread> threads;
+      for (int t = 0; t < nThreads; ++t) {
+        threads.emplace_back([&data, t]() {
+            for (int i = 0; i < nPerThread; ++i) {
+              int const value = t * nPerThread + i;
+              data.insert(value, value * 0.5);
+              if (t == 0 && i == nPerThread / 2) {
+                data.flush();
+              }
+            }
+          });
+      }
+      for (auto & thread : threads) {
+        thread.join();
+      }
+    }
+    constexpr std::size_t nRows = nThreads * nPerThread;
+    File const file(filename);
+    std::vector<int> a(nRows);
+    std::vector<double> b(nRows);
+    Dataset(file, "/g1/A").read(H5T_NATIVE_INT, a.data());
+    Dataset(file, "/g1/B").read(H5T_NATIVE_DOUBLE, b.data());
+    // Columns are consistent row-wise, and each thread's rows retain
+    // their relative order.
+    std::vector<int> last(nThreads, -1);
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(b[i] == a[i] * 0.5);
+      int const t = a[i] / nPerThread;
+      assert(a[i] > last[t]);
+      last[t] = a[i];
+    }
+    // All rows are present exactly once.
+    std::sort(a.begin(), a.end());
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(a[i] == static_cast<int>(i));
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  writeAndVerify("test-ntuple_08_sync.hdf5", NtupleFlushMode::SYNC);
+  writeAndVerify("test-ntuple_08_async.hdf5", NtupleFlushMode::ASYNC);
+}
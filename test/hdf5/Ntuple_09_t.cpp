@@ -0,0 +1,76 @@
+// Column-wise bulk insertion.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t bufsize = 100;
+
+  void write(std::string const & filename, NtupleInsertMode const insertMode)
+  {
+    auto data = make_ntuple({filename, "g1",
+          NtupleOptions{}.setBufsize(bufsize).setInsertMode(insertMode)},
+      make_scalar_column<int>("A"),
+      make_column<double>("B", 2),
+      make_scalar_column<std::string>("C"));
+    std::vector<int> a(1000);
+    std::iota(a.begin(), a.end(), 0);
+    std::vector<double> b(2000);
+    std::iota(b.begin(), b.end(), 0.0);
+    std::vector<std::string> c;
+    for (int i = 0; i < 1000; ++i) {
+      c.emplace_back(std::to_string(i));
+    }
+    // Rows 0-29: small batch into the buffer.
+    data.insert_columns(30, a.data(), b.data(), c.data());
+    // Rows 30-99: per-row insertion.
+    for (std::size_t i = 30; i < 100; ++i) {
+      data.insert(a[i], &b[i * 2], &c[i]);
+    }
+    // Rows 100-179: batch forcing a flush.
+    data.insert_columns(80, &a[100], &b[200], &c[100]);
+    // Rows 180-679: batch larger than the buffer.
+    data.insert_columns(500, &a[180], &b[360], &c[180]);
+    // Rows 680-699: defaulted column.
+    data.insert_columns(20, &a[680], nullptr, &c[680]);
+  }
+
+  void verify(std::string const & filename)
+  {
+    constexpr std::size_t nRows = 700;
+    File const file(filename);
+    std::vector<int> a(nRows);
+    std::vector<double> b(nRows * 2);
+    std::vector<char *> c(nRows);
+    Dataset(file, "/g1/A").read(H5T_NATIVE_INT, a.data());
+    Dataset(file, "/g1/B").read(H5T_NATIVE_DOUBLE, b.data());
+    Dataset cds(file, "/g1/C");
+    hid_t const stype = H5Dget_type(cds);
+    cds.read(stype, c.data());
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(a[i] == static_cast<int>(i));
+      assert(b[i * 2 + 1] == ((i < 680) ? i * 2 + 1.0 : 0.0));
+      assert(std::to_string(i) == c[i]);
+      free(c[i]);
+    }
+    H5Tclose(stype);
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  write("test-ntuple_09.hdf5", NtupleInsertMode::LOCKED);
+  verify("test-ntuple_09.hdf5");
+  // Single inserting thread: blocks are written in order.
+  write("test-ntuple_09_staged.hdf5", NtupleInsertMode::PER_THREAD);
+  verify("test-ntuple_09_staged.hdf5");
+}
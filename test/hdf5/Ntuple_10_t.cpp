@@ -0,0 +1,109 @@
+// Buffer sizing from a memory budget.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/NtupleMemoryPool.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace {
+  // Chunk rows: 100 (A), 150 (B); in-memory row size: 4 + 16 bytes.
+  constexpr std::size_t rowBytes = sizeof(int) + 2 * sizeof(double);
+  // The rows' worth of the budget set aside for those held back to
+  // complete a chunk of each column: (100 * 4 + 150 * 16) / 20.
+  constexpr std::size_t carryRows = 140;
+
+  std::size_t write(std::string const & filename, NtupleOptions const & options)
+  {
+    auto data = make_ntuple({filename, "g1", options},
+      make_scalar_column<int>("A", 100),
+      make_column<double>("B", 2, 150));
+    for (int i = 0; i < 1000; ++i) {
+      double const b[2] = { i * 2.0, i * 2.0 + 1.0 };
+      data.insert(i, b);
+    }
+    return data.bufsize();
+  }
+
+  void verify(std::string const & filename, std::string const & prefix = "/g1/")
+  {
+    constexpr std::size_t nRows = 1000;
+    File const file(filename);
+    std::vector<int> a(nRows);
+    std::vector<double> b(nRows * 2);
+    Dataset(file, prefix + "A").read(H5T_NATIVE_INT, a.data());
+    Dataset(file, prefix + "B").read(H5T_NATIVE_DOUBLE, b.data());
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(a[i] == static_cast<int>(i));
+      assert(b[i * 2 + 1] == i * 2 + 1.0);
+    }
+  }
+
+  // The memory held (as charged to a pool too large to force flushes)
+  // stays within a small budget. Default chunking is limited by the
+  // budget; column C's chunks make the buffer size unaligned, so that
+  // rows are held back after each flush.
+  void held(NtupleOptions options)
+  {
+    constexpr std::size_t budget = 4096;
+    auto const pool = NtupleMemoryPool::create(std::size_t(1) << 30);
+    {
+      auto data = make_ntuple({"test-ntuple_10-held.hdf5", "g2",
+            options.setBufferBytes(budget).setMemoryPool(pool)},
+        make_scalar_column<int>("A"),
+        make_column<double>("B", 2),
+        make_scalar_column<int>("C", 7));
+      for (int i = 0; i < 1000; ++i) {
+        double const b[2] = { i * 2.0, i * 2.0 + 1.0 };
+        data.insert(i, b, i);
+        assert(pool->usage() > 0 && pool->usage() <= budget);
+      }
+      assert(pool->forcedFlushes() == 0);
+    }
+    if (options.layout() == NtupleLayout::COLUMNAR) {
+      verify("test-ntuple_10-held.hdf5", "/g2/");
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  // No budget: bufsize is used as-is.
+  assert(write("test-ntuple_10.hdf5",
+               NtupleOptions{}.setBufsize(123)) == 123);
+  verify("test-ntuple_10.hdf5");
+  // Budget of 700 rows (after those held back): rounded down to a
+  // multiple of lcm(100, 150).
+  assert(write("test-ntuple_10.hdf5",
+               NtupleOptions{}.setBufsize(123).
+               setBufferBytes((700 + carryRows) * rowBytes + 7)) == 600);
+  verify("test-ntuple_10.hdf5");
+  // Without chunk-aligned flushing, no rows are held back.
+  assert(write("test-ntuple_10.hdf5",
+               NtupleOptions{}.setChunkAlignedFlush(false).
+               setBufferBytes(700 * rowBytes + 7)) == 600);
+  verify("test-ntuple_10.hdf5");
+  // Budget smaller than lcm(100, 150): as many rows as fit.
+  assert(write("test-ntuple_10.hdf5",
+               NtupleOptions{}.
+               setBufferBytes((250 + carryRows) * rowBytes)) == 250);
+  verify("test-ntuple_10.hdf5");
+  // Budget smaller than one row.
+  assert(write("test-ntuple_10.hdf5",
+               NtupleOptions{}.setBufferBytes(1)) == 1);
+  verify("test-ntuple_10.hdf5");
+  // Budget shared by both sets of buffers.
+  assert(write("test-ntuple_10.hdf5",
+               NtupleOptions{}.setBufferBytes((700 + carryRows) * rowBytes).
+               setFlushMode(NtupleFlushMode::ASYNC)) == 300);
+  verify("test-ntuple_10.hdf5");
+  held(NtupleOptions{});
+  held(NtupleOptions{}.setFlushMode(NtupleFlushMode::ASYNC));
+  held(NtupleOptions{}.setLayout(NtupleLayout::ROW_COMPOUND));
+}
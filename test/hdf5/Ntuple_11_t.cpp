@@ -0,0 +1,110 @@
+// Chunk-aligned flushing.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 1000;
+
+  // Returns the number of chunk rewrites before the final flush.
+  std::size_t write(std::string const & filename, NtupleOptions options)
+  {
+    auto data = make_ntuple({filename, "g1", options.setBufsize(100)},
+      make_scalar_column<int>("A", 128),
+      make_column<double>("B", 2, 50),
+      make_scalar_column<std::string>("C", 128),
+      make_scalar_column<char const *>("D", 128));
+    std::vector<int> a(nRows);
+    std::iota(a.begin(), a.end(), 0);
+    std::vector<double> b(nRows * 2);
+    std::iota(b.begin(), b.end(), 0.0);
+    std::vector<std::string> c;
+    for (std::size_t i = 0; i < nRows; ++i) {
+      c.emplace_back(std::to_string(i));
+    }
+    // Column D is given pointers to strings which are overwritten after
+    // insertion, including those rows held back to complete a chunk.
+    std::vector<std::string> d(c);
+    std::vector<char const *> dp;
+    for (auto const & s : d) {
+      dp.push_back(s.c_str());
+    }
+    auto const overwrite = [&d](std::size_t const first, std::size_t const n)
+      {
+        for (std::size_t i = first; i < first + n; ++i) {
+          d[i].replace(0, d[i].size(), d[i].size(), 'x');
+        }
+      };
+    // Rows 0-449: per-row insertion.
+    char dbuf[8];
+    for (std::size_t i = 0; i < 450; ++i) {
+      std::snprintf(dbuf, sizeof(dbuf), "%zu", i);
+      data.insert(a[i], &b[i * 2], &c[i], dbuf);
+    }
+    std::snprintf(dbuf, sizeof(dbuf), "x");
+    // Rows 450-899: a batch written directly.
+    data.insert_columns(450, &a[450], &b[900], &c[450], &dp[450]);
+    overwrite(450, 450);
+    auto const result = data.chunkRewrites();
+    // Rows 900-999: explicit flush part-way.
+    data.insert_columns(50, &a[900], &b[1800], &c[900], &dp[900]);
+    overwrite(900, 50);
+    data.flush();
+    data.insert_columns(50, &a[950], &b[1900], &c[950], &dp[950]);
+    overwrite(950, 50);
+    return result;
+  }
+
+  void verify(std::string const & filename)
+  {
+    File const file(filename);
+    std::vector<int> a(nRows);
+    std::vector<double> b(nRows * 2);
+    std::vector<char *> c(nRows);
+    std::vector<char *> d(nRows);
+    Dataset(file, "/g1/A").read(H5T_NATIVE_INT, a.data());
+    Dataset(file, "/g1/B").read(H5T_NATIVE_DOUBLE, b.data());
+    Dataset cds(file, "/g1/C");
+    hid_t const stype = H5Dget_type(cds);
+    cds.read(stype, c.data());
+    Dataset(file, "/g1/D").read(stype, d.data());
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(a[i] == static_cast<int>(i));
+      assert(b[i * 2 + 1] == i * 2 + 1.0);
+      assert(std::to_string(i) == c[i]);
+      assert(std::to_string(i) == d[i]);
+      free(c[i]);
+      free(d[i]);
+    }
+    H5Tclose(stype);
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  assert(write("test-ntuple_11.hdf5",
+               NtupleOptions{}.setChunkAlignedFlush(false)) > 0);
+  verify("test-ntuple_11.hdf5");
+  assert(write("test-ntuple_11.hdf5", NtupleOptions{}) == 0);
+  verify("test-ntuple_11.hdf5");
+  assert(write("test-ntuple_11.hdf5",
+               NtupleOptions{}.setFlushMode(NtupleFlushMode::ASYNC)) == 0);
+  verify("test-ntuple_11.hdf5");
+  assert(write("test-ntuple_11.hdf5",
+               NtupleOptions{}.setInsertMode(NtupleInsertMode::PER_THREAD)) == 0);
+  verify("test-ntuple_11.hdf5");
+  assert(write("test-ntuple_11.hdf5",
+               NtupleOptions{}.setInsertMode(NtupleInsertMode::PER_THREAD).
+               setFlushMode(NtupleFlushMode::ASYNC)) == 0);
+  verify("test-ntuple_11.hdf5");
+}
@@ -0,0 +1,60 @@
+// Geometric extent growth and trimming.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/Dataspace.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace {
+  hsize_t extent(hid_t const dset)
+  {
+    Dataspace const dspace{H5Dget_space(dset)};
+    hsize_t dims[2];
+    H5Sget_simple_extent_dims(dspace, dims, nullptr);
+    return dims[0];
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  {
+    auto data = make_ntuple({"test-ntuple_12.hdf5", "g1",
+          NtupleOptions{}.setBufsize(100)},
+      make_scalar_column<int>("A", 10),
+      make_column<double>("B", 2, 25));
+    for (int i = 0; i < 1000; ++i) {
+      double const b[2] = { i * 2.0, i * 2.0 + 1.0 };
+      data.insert(i, b);
+      if (i == 550) {
+        // Extent may exceed the rows written...
+        assert(extent(data.datasets()[0]) >= 500);
+        assert(extent(data.datasets()[0]) % 10 == 0);
+        assert(extent(data.datasets()[1]) % 25 == 0);
+        // ... until an explicit flush.
+        data.flush();
+        assert(extent(data.datasets()[0]) == 551);
+        assert(extent(data.datasets()[1]) == 551);
+      }
+    }
+  }
+  File const file("test-ntuple_12.hdf5");
+  Dataset const a(file, "/g1/A");
+  Dataset const b(file, "/g1/B");
+  assert(extent(a) == 1000);
+  assert(extent(b) == 1000);
+  std::vector<int> av(1000);
+  std::vector<double> bv(2000);
+  Dataset(file, "/g1/A").read(H5T_NATIVE_INT, av.data());
+  Dataset(file, "/g1/B").read(H5T_NATIVE_DOUBLE, bv.data());
+  for (std::size_t i = 0; i < 1000; ++i) {
+    assert(av[i] == static_cast<int>(i));
+    assert(bv[i * 2 + 1] == i * 2 + 1.0);
+  }
+}
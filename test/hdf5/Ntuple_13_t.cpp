@@ -0,0 +1,96 @@
+// Direct chunk writing with parallel compression.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 10000;
+
+  void write(std::string const & filename, unsigned int const nThreads)
+  {
+    auto data = make_ntuple({filename, "g1",
+          NtupleOptions{}.setBufsize(1000).setCompressionThreads(nThreads)},
+      make_scalar_column<int>("A"),
+      make_column<double, 2>("B", {2, 3}, 100,
+        {PropertyList{H5P_DATASET_CREATE}(&H5Pset_shuffle)(&H5Pset_deflate, 4u)}),
+      make_scalar_column<std::string>("C"),
+      make_scalar_column<float>("D", 64,
+        {PropertyList{H5P_DATASET_CREATE}(&H5Pset_fletcher32)(&H5Pset_deflate, 1u)}));
+    std::vector<int> a(nRows);
+    std::vector<double> b(nRows * 6);
+    std::vector<std::string> c(nRows);
+    std::vector<float> d(nRows);
+    for (std::size_t i = 0; i < nRows; ++i) {
+      a[i] = i % 97;
+      for (std::size_t j = 0; j < 6; ++j) {
+        b[i * 6 + j] = i * 0.5 + j;
+      }
+      c[i] = std::to_string(i);
+      d[i] = i * 0.25f;
+    }
+    // Rows 0-2999: per-row insertion.
+    for (std::size_t i = 0; i < 3000; ++i) {
+      data.insert(a[i], &b[i * 6], &c[i], d[i]);
+    }
+    // Rows 3000-7999: a batch written directly.
+    data.insert_columns(5000, &a[3000], &b[18000], &c[3000], &d[3000]);
+    // Rows 8000-9999: explicit flush part-way.
+    data.insert_columns(1000, &a[8000], &b[48000], &c[8000], &d[8000]);
+    data.flush();
+    data.insert_columns(1000, &a[9000], &b[54000], &c[9000], &d[9000]);
+  }
+
+  void verify(std::string const & filename)
+  {
+    File const file(filename);
+    std::vector<int> a(nRows);
+    std::vector<double> b(nRows * 6);
+    std::vector<char *> c(nRows);
+    std::vector<float> d(nRows);
+    Dataset(file, "/g1/A").read(H5T_NATIVE_INT, a.data());
+    Dataset(file, "/g1/B").read(H5T_NATIVE_DOUBLE, b.data());
+    Dataset cds(file, "/g1/C");
+    hid_t const stype = H5Dget_type(cds);
+    cds.read(stype, c.data());
+    Dataset(file, "/g1/D").read(H5T_NATIVE_FLOAT, d.data());
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(a[i] == static_cast<int>(i % 97));
+      for (std::size_t j = 0; j < 6; ++j) {
+        assert(b[i * 6 + j] == i * 0.5 + j);
+      }
+      assert(std::to_string(i) == c[i]);
+      free(c[i]);
+      assert(d[i] == i * 0.25f);
+    }
+    H5Tclose(stype);
+  }
+
+  hsize_t storageSize(std::string const & filename, char const * dset)
+  {
+    File const file(filename);
+    return H5Dget_storage_size(Dataset(file, dset));
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  write("test-ntuple_13_ref.hdf5", 0);
+  verify("test-ntuple_13_ref.hdf5");
+  for (unsigned int const nThreads : {1u, 4u}) {
+    write("test-ntuple_13.hdf5", nThreads);
+    verify("test-ntuple_13.hdf5");
+    // Chunks compressed by us are as compressed by HDF5.
+    for (auto const dset : {"/g1/A", "/g1/B", "/g1/D"}) {
+      assert(storageSize("test-ntuple_13.hdf5", dset) ==
+             storageSize("test-ntuple_13_ref.hdf5", dset));
+    }
+  }
+}
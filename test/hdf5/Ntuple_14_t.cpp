@@ -0,0 +1,102 @@
+// Variable-length string columns.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 1000;
+
+  std::string expected(std::size_t const row, std::size_t const j)
+  {
+    // Mix of empty, short and long strings.
+    switch ((row + j) % 3) {
+    case 0: return {};
+    case 1: return std::to_string(row);
+    default: return std::string(row % 200, 'a' + j);
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  {
+    auto data = make_ntuple({"test-ntuple_14.hdf5", "g1", 64},
+      make_scalar_column<int>("A"),
+      make_column<std::string>("S", 3));
+    std::vector<std::string> s(3);
+    for (std::size_t i = 0; i < nRows; ++i) {
+      if (i % 10 == 9) { // Default (empty) strings.
+        data.insert(static_cast<int>(i), nullptr);
+        continue;
+      }
+      for (std::size_t j = 0; j < 3; ++j) {
+        s[j] = expected(i, j);
+      }
+      data.insert(static_cast<int>(i), s.data());
+    }
+  }
+  File const file("test-ntuple_14.hdf5");
+  std::vector<int> a(nRows);
+  Dataset(file, "/g1/A").read(H5T_NATIVE_INT, a.data());
+  std::vector<char *> s(nRows * 3);
+  Dataset sds(file, "/g1/S");
+  hid_t const stype = H5Dget_type(sds);
+  sds.read(stype, s.data());
+  for (std::size_t i = 0; i < nRows; ++i) {
+    assert(a[i] == static_cast<int>(i));
+    for (std::size_t j = 0; j < 3; ++j) {
+      assert((i % 10 == 9 ? std::string() : expected(i, j)) == s[i * 3 + j]);
+      free(s[i * 3 + j]);
+    }
+  }
+  H5Tclose(stype);
+  {
+    // char const * and char * strings are copied at insert() time: free
+    // or overwrite them straight away.
+    auto data = make_ntuple({"test-ntuple_14-chars.hdf5", "g2", 10},
+      make_scalar_column<char const *>("P"),
+      make_scalar_column<char *>("Q"));
+    for (std::size_t i = 0; i < nRows / 2; ++i) {
+      char * const p = strdup(expected(i, 0).c_str());
+      char * const q = strdup(expected(i, 1).c_str());
+      data.insert(p, q);
+      free(p);
+      free(q);
+    }
+    std::string const blank(200, ' ');
+    std::vector<std::vector<char> > storage(nRows / 2,
+      std::vector<char>(blank.size() + 1));
+    std::vector<char const *> ps(nRows / 2);
+    std::vector<char *> qs(nRows / 2);
+    for (std::size_t i = 0; i < nRows / 2; ++i) {
+      std::strcpy(storage[i].data(), expected(nRows / 2 + i, 0).c_str());
+      ps[i] = qs[i] = storage[i].data();
+    }
+    data.insert_columns(nRows / 2, ps.data(), qs.data());
+    for (auto & chars : storage) {
+      std::strcpy(chars.data(), blank.c_str());
+    }
+  }
+  File const chars("test-ntuple_14-chars.hdf5");
+  for (std::size_t j = 0; j < 2; ++j) {
+    std::vector<char *> p(nRows);
+    Dataset pds(chars, j == 0 ? "/g2/P" : "/g2/Q");
+    hid_t const ptype = H5Dget_type(pds);
+    pds.read(ptype, p.data());
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(expected(i, (i < nRows / 2) ? j : 0) == p[i]);
+      free(p[i]);
+    }
+    H5Tclose(ptype);
+  }
+}
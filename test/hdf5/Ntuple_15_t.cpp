@@ -0,0 +1,101 @@
+// Insertion from arrays of structs.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/StructNtuple.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <array>
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace {
+  struct Hit {
+    int id;
+    float pos[3];
+    char flag;
+    double energy;
+    std::array<std::array<short, 2>, 2> m;
+    std::string label;
+  };
+
+  constexpr std::size_t nRows = 1000;
+
+  Hit makeHit(std::size_t const i)
+  {
+    return Hit{static_cast<int>(i),
+        {i * 1.0f, i * 2.0f, i * 3.0f},
+        'x',
+        i * 0.5,
+        {{{{short(i), short(i + 1)}}, {{short(i + 2), short(i + 3)}}}},
+        std::to_string(i)};
+  }
+
+  void write(std::string const & filename, NtupleInsertMode const insertMode)
+  {
+    auto hits = make_struct_ntuple<Hit>
+      ({filename, "hits", NtupleOptions{}.setBufsize(64).setInsertMode(insertMode)},
+       make_field(&Hit::id, make_scalar_column<int>("id")),
+       make_field(&Hit::pos, make_column<float>("pos", 3)),
+       make_field(&Hit::energy, make_scalar_column<double>("energy")),
+       make_field(&Hit::m, make_column<short, 2>("m", {2, 2})),
+       make_field(&Hit::label, make_scalar_column<std::string>("label")));
+    std::vector<Hit> batch;
+    std::size_t row = 0;
+    // Single rows, then batches of increasing size.
+    for (; row < 10; ++row) {
+      hits.insert(makeHit(row));
+    }
+    for (std::size_t n = 1; row < nRows; n = n * 2 + 1) {
+      batch.clear();
+      for (std::size_t i = 0; i < n && row < nRows; ++i, ++row) {
+        batch.push_back(makeHit(row));
+      }
+      hits.insert_range(batch);
+    }
+  }
+
+  void verify(std::string const & filename)
+  {
+    File const file(filename);
+    std::vector<int> id(nRows);
+    std::vector<float> pos(nRows * 3);
+    std::vector<double> energy(nRows);
+    std::vector<short> m(nRows * 4);
+    std::vector<char *> label(nRows);
+    Dataset(file, "/hits/id").read(H5T_NATIVE_INT, id.data());
+    Dataset(file, "/hits/pos").read(H5T_NATIVE_FLOAT, pos.data());
+    Dataset(file, "/hits/energy").read(H5T_NATIVE_DOUBLE, energy.data());
+    Dataset(file, "/hits/m").read(H5T_NATIVE_SHORT, m.data());
+    Dataset lds(file, "/hits/label");
+    hid_t const stype = H5Dget_type(lds);
+    lds.read(stype, label.data());
+    for (std::size_t i = 0; i < nRows; ++i) {
+      assert(id[i] == static_cast<int>(i));
+      assert(pos[i * 3 + 2] == i * 3.0f);
+      assert(energy[i] == i * 0.5);
+      assert(m[i * 4 + 3] == short(i + 3));
+      assert(std::to_string(i) == label[i]);
+      free(label[i]);
+    }
+    H5Tclose(stype);
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  write("test-ntuple_15.hdf5", NtupleInsertMode::LOCKED);
+  verify("test-ntuple_15.hdf5");
+  write("test-ntuple_15_staged.hdf5", NtupleInsertMode::PER_THREAD);
+  verify("test-ntuple_15_staged.hdf5");
+  // Member of the wrong size.
+  try {
+    make_field(&Hit::pos, make_column<float>("pos", 4));
+    assert(false);
+  }
+  catch (std::runtime_error const &) {
+  }
+}
@@ -0,0 +1,116 @@
+// Row-wise compound-dataset layout.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 1000;
+
+  struct Row {
+    int a;
+    double b[2][2];
+    float c;
+  };
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  {
+    auto data = make_ntuple({"test-ntuple_16.hdf5", "g1",
+          NtupleOptions{}.setBufsize(100).setLayout(NtupleLayout::ROW_COMPOUND)},
+      make_scalar_column<int>("A"),
+      make_column<double, 2>("B", {2, 2}),
+      make_scalar_column<std::string>("S"),
+      make_scalar_column<float>("C"));
+    assert(data.rowDataset());
+    assert(!data.datasets()[0] && !data.datasets()[1] && !data.datasets()[3]);
+    assert(data.datasets()[2]);
+    std::size_t i = 0;
+    for (; i < nRows / 2; ++i) {
+      double const b[4] { i * 1.0, i * 2.0, i * 3.0, i * 4.0 };
+      std::string const s { std::to_string(i) };
+      data.insert(static_cast<int>(i), b, &s, i * 0.5f);
+    }
+    // Insert the remainder column-wise, with B defaulted.
+    std::vector<int> a;
+    std::vector<std::string> s;
+    std::vector<float> c;
+    for (; i < nRows; ++i) {
+      a.push_back(static_cast<int>(i));
+      s.push_back(std::to_string(i));
+      c.push_back(i * 0.5f);
+    }
+    data.insert_columns(a.size(), a.data(), nullptr, s.data(), c.data());
+  }
+  File const file("test-ntuple_16.hdf5");
+  Dataset rows(file, "/g1/rows");
+  Dataspace const space(H5Dget_space(rows));
+  hsize_t extent = 0;
+  H5Sget_simple_extent_dims(space, &extent, nullptr);
+  assert(extent == nRows);
+  // Read back with a memory type matching Row.
+  hsize_t const bdims[2] {2, 2};
+  hid_t const btype = H5Tarray_create2(H5T_NATIVE_DOUBLE, 2, bdims);
+  hid_t const rtype = H5Tcreate(H5T_COMPOUND, sizeof(Row));
+  H5Tinsert(rtype, "A", HOFFSET(Row, a), H5T_NATIVE_INT);
+  H5Tinsert(rtype, "B", HOFFSET(Row, b), btype);
+  H5Tinsert(rtype, "C", HOFFSET(Row, c), H5T_NATIVE_FLOAT);
+  std::vector<Row> r(nRows);
+  rows.read(rtype, r.data());
+  std::vector<char *> s(nRows);
+  Dataset sds(file, "/g1/S");
+  hid_t const stype = H5Dget_type(sds);
+  sds.read(stype, s.data());
+  for (std::size_t i = 0; i < nRows; ++i) {
+    assert(r[i].a == static_cast<int>(i));
+    for (std::size_t j = 0; j < 4; ++j) {
+      assert(r[i].b[j / 2][j % 2] == ((i < nRows / 2) ? i * (j + 1.0) : 0.0));
+    }
+    assert(r[i].c == i * 0.5f);
+    assert(std::to_string(i) == s[i]);
+    free(s[i]);
+  }
+  H5Tclose(stype);
+  H5Tclose(rtype);
+  H5Tclose(btype);
+  {
+    // A column with creation properties of its own (here, chunking)
+    // keeps its own dataset.
+    auto data = make_ntuple({"test-ntuple_16-props.hdf5", "g2",
+          NtupleOptions{}.setLayout(NtupleLayout::ROW_COMPOUND)},
+      make_scalar_column<int>("A"),
+      make_scalar_column<int>("D", 64),
+      make_scalar_column<float>("C"));
+    assert(!data.datasets()[0] && data.datasets()[1] && !data.datasets()[2]);
+    PropertyList const dcpl(H5Dget_create_plist(data.datasets()[1]),
+                            ResourceStrategy::handle_tag);
+    hsize_t chunk[2] {0, 0};
+    assert(H5Pget_chunk(dcpl, 2, chunk) == 2 && chunk[0] == 64);
+    hid_t const type = H5Dget_type(data.rowDataset());
+    assert(H5Tget_nmembers(type) == 2);
+    for (unsigned m = 0; m != 2u; ++m) {
+      char * const member = H5Tget_member_name(type, m);
+      assert(std::string(member) != "D");
+      H5free_memory(member);
+    }
+    H5Tclose(type);
+    for (std::size_t i = 0; i < nRows; ++i) {
+      data.insert(static_cast<int>(i), -static_cast<int>(i), i * 0.5f);
+    }
+  }
+  std::vector<int> d(nRows);
+  Dataset(File("test-ntuple_16-props.hdf5"), "/g2/D").
+    read(H5T_NATIVE_INT, d.data());
+  for (std::size_t i = 0; i < nRows; ++i) {
+    assert(d[i] == -static_cast<int>(i));
+  }
+}
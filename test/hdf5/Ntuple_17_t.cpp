@@ -0,0 +1,146 @@
+// Appending to an existing table.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nSegments = 3;
+  constexpr std::size_t nRows = 1000; // Per segment.
+
+  // Write one job segment.
+  void write(std::string const & filename,
+             std::size_t const segment,
+             NtupleLayout const layout)
+  {
+    auto data = make_ntuple({filename, "g1",
+          NtupleOptions{}.
+          setBufsize(64).
+          setLayout(layout).
+          setOverwriteContents(NtupleOverwriteFlag::APPEND)},
+      make_scalar_column<int>("A"),
+      make_column<double>("B", 2),
+      make_scalar_column<std::string>("S"));
+    for (std::size_t i = segment * nRows; i < (segment + 1) * nRows; ++i) {
+      double const b[] { i * 1.0, i * 2.0 };
+      std::string const s { std::to_string(i) };
+      data.insert(static_cast<int>(i), b, &s);
+    }
+  }
+
+  void check(std::string const & filename, NtupleLayout const layout)
+  {
+    File const file(filename);
+    std::size_t const total = nSegments * nRows;
+    std::vector<int> a(total);
+    std::vector<double> b(2 * total);
+    if (layout == NtupleLayout::ROW_COMPOUND) {
+      struct Row { int a; double b[2]; };
+      hsize_t const bdims[1] {2};
+      hid_t const btype = H5Tarray_create2(H5T_NATIVE_DOUBLE, 1, bdims);
+      hid_t const rtype = H5Tcreate(H5T_COMPOUND, sizeof(Row));
+      H5Tinsert(rtype, "A", HOFFSET(Row, a), H5T_NATIVE_INT);
+      H5Tinsert(rtype, "B", HOFFSET(Row, b), btype);
+      Dataset rows(file, "/g1/rows");
+      Dataspace const space(H5Dget_space(rows));
+      hsize_t extent = 0;
+      H5Sget_simple_extent_dims(space, &extent, nullptr);
+      assert(extent == total);
+      std::vector<Row> r(total);
+      rows.read(rtype, r.data());
+      for (std::size_t i = 0; i < total; ++i) {
+        a[i] = r[i].a;
+        b[2 * i] = r[i].b[0];
+        b[2 * i + 1] = r[i].b[1];
+      }
+      H5Tclose(rtype);
+      H5Tclose(btype);
+    } else {
+      Dataset ads(file, "/g1/A");
+      Dataspace const space(H5Dget_space(ads));
+      hsize_t dims[2] {0, 0};
+      H5Sget_simple_extent_dims(space, dims, nullptr);
+      assert(dims[0] == total);
+      ads.read(H5T_NATIVE_INT, a.data());
+      Dataset(file, "/g1/B").read(H5T_NATIVE_DOUBLE, b.data());
+    }
+    std::vector<char *> s(total);
+    Dataset sds(file, "/g1/S");
+    hid_t const stype = H5Dget_type(sds);
+    sds.read(stype, s.data());
+    for (std::size_t i = 0; i < total; ++i) {
+      assert(a[i] == static_cast<int>(i));
+      assert(b[2 * i] == i * 1.0 && b[2 * i + 1] == i * 2.0);
+      assert(std::to_string(i) == s[i]);
+      free(s[i]);
+    }
+    H5Tclose(stype);
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    std::string const filename =
+      (layout == NtupleLayout::COLUMNAR) ?
+      "test-ntuple_17.hdf5" : "test-ntuple_17-rows.hdf5";
+    // The first segment creates the file (removing any left over from a
+    // previous run).
+    (void) File(filename, H5F_ACC_TRUNC);
+    for (std::size_t segment = 0; segment < nSegments; ++segment) {
+      write(filename, segment, layout);
+    }
+    check(filename, layout);
+  }
+  // Mismatched column type.
+  bool threw = false;
+  try {
+    auto data = make_ntuple({"test-ntuple_17.hdf5", "g1",
+          NtupleOptions{}.setOverwriteContents(NtupleOverwriteFlag::APPEND)},
+      make_scalar_column<float>("A"),
+      make_column<double>("B", 2),
+      make_scalar_column<std::string>("S"));
+  }
+  catch (std::runtime_error const &) {
+    threw = true;
+  }
+  assert(threw);
+  // Mismatched dimensions.
+  threw = false;
+  try {
+    auto data = make_ntuple({"test-ntuple_17.hdf5", "g1",
+          NtupleOptions{}.setOverwriteContents(NtupleOverwriteFlag::APPEND)},
+      make_scalar_column<int>("A"),
+      make_column<double>("B", 3),
+      make_scalar_column<std::string>("S"));
+  }
+  catch (std::runtime_error const &) {
+    threw = true;
+  }
+  assert(threw);
+  // Column not in the existing table.
+  threw = false;
+  try {
+    auto data = make_ntuple({"test-ntuple_17.hdf5", "g1",
+          NtupleOptions{}.setOverwriteContents(NtupleOverwriteFlag::APPEND)},
+      make_scalar_column<int>("A"),
+      make_scalar_column<int>("C"));
+  }
+  catch (std::runtime_error const &) {
+    threw = true;
+  }
+  assert(threw);
+  // Existing contents survive failed attempts, unchanged.
+  check("test-ntuple_17.hdf5", NtupleLayout::COLUMNAR);
+  File const file("test-ntuple_17.hdf5");
+  assert(H5Lexists(file, "/g1/C", H5P_DEFAULT) == 0);
+}
@@ -0,0 +1,166 @@
+// Memory ceiling shared by many Ntuples.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/NtupleMemoryPool.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nTables = 20;
+  constexpr std::size_t nRows = 5000; // Per table.
+  constexpr std::size_t capacity = 64 * 1024;
+
+  auto makeTable(File const & file, std::size_t const i,
+                 std::shared_ptr<NtupleMemoryPool> const & pool,
+                 NtupleFlushMode const flushMode = NtupleFlushMode::SYNC,
+                 std::size_t const bufsize = 100000)
+  {
+    // By default, each table's buffer alone would exceed the pool's
+    // capacity. Each forced flush writes a partial chunk, so keep
+    // chunks small.
+    return make_ntuple({file, "t" + std::to_string(i),
+          NtupleOptions{}.
+          setBufsize(bufsize).
+          setChunkBytes(0).
+          setFlushMode(flushMode).
+          setMemoryPool(pool)},
+      make_scalar_column<int>("A"),
+      make_column<double>("B", 2),
+      make_scalar_column<std::string>("S"));
+  }
+
+  void check(File const & file, std::size_t const i)
+  {
+    std::string const prefix = "/t" + std::to_string(i) + "/";
+    std::vector<int> a(nRows);
+    std::vector<double> b(2 * nRows);
+    Dataset ads(file, prefix + "A");
+    Dataspace const space(H5Dget_space(ads));
+    hsize_t dims[2] {0, 0};
+    H5Sget_simple_extent_dims(space, dims, nullptr);
+    assert(dims[0] == nRows);
+    ads.read(H5T_NATIVE_INT, a.data());
+    Dataset(file, prefix + "B").read(H5T_NATIVE_DOUBLE, b.data());
+    std::vector<char *> s(nRows);
+    Dataset sds(file, prefix + "S");
+    hid_t const stype = H5Dget_type(sds);
+    sds.read(stype, s.data());
+    for (std::size_t row = 0; row < nRows; ++row) {
+      int const expected = static_cast<int>(i * nRows + row);
+      assert(a[row] == expected);
+      assert(b[2 * row] == expected && b[2 * row + 1] == -expected);
+      assert(std::to_string(expected) == s[row]);
+      free(s[row]);
+    }
+    H5Tclose(stype);
+  }
+
+  template <typename TABLE>
+  void insertRow(TABLE & table,
+                 std::size_t const i, std::size_t const row)
+  {
+    int const value = static_cast<int>(i * nRows + row);
+    double const b[] { value * 1.0, -value * 1.0 };
+    std::string const s { std::to_string(value) };
+    table.insert(value, b, &s);
+  }
+
+  // Round-robin insertion into many tables from one thread.
+  void roundRobin(NtupleMemoryPool::Policy const policy,
+                  NtupleFlushMode const flushMode)
+  {
+    auto const pool = NtupleMemoryPool::create(capacity, policy);
+    {
+      File const file("test-ntuple_18.hdf5", H5F_ACC_TRUNC);
+      std::vector<decltype(makeTable(file, 0, pool))> tables;
+      for (std::size_t i = 0; i < nTables; ++i) {
+        tables.push_back(makeTable(file, i, pool, flushMode));
+      }
+      for (std::size_t row = 0; row < nRows; ++row) {
+        for (std::size_t i = 0; i < nTables; ++i) {
+          insertRow(tables[i], i, row);
+          // The ceiling holds after every insertion.
+          assert(pool->usage() <= capacity);
+        }
+      }
+      assert(pool->forcedFlushes() > 0);
+    }
+    assert(pool->usage() == 0);
+    File const file("test-ntuple_18.hdf5");
+    for (std::size_t i = 0; i < nTables; ++i) {
+      check(file, i);
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  roundRobin(NtupleMemoryPool::Policy::LARGEST, NtupleFlushMode::SYNC);
+  roundRobin(NtupleMemoryPool::Policy::LEAST_RECENTLY_USED,
+             NtupleFlushMode::SYNC);
+  roundRobin(NtupleMemoryPool::Policy::LARGEST, NtupleFlushMode::ASYNC);
+  // One table per thread, each thread forcing flushes of the others'.
+  {
+    auto const pool = NtupleMemoryPool::create(capacity);
+    {
+      File const file("test-ntuple_18.hdf5", H5F_ACC_TRUNC);
+      std::vector<decltype(makeTable(file, 0, pool))> tables;
+      for (std::size_t i = 0; i < 4; ++i) {
+        tables.push_back(makeTable(file, i, pool));
+      }
+      std::vector<std::thread> threads;
+      for (std::size_t i = 0; i < 4; ++i) {
+        threads.emplace_back([&table = tables[i], i]() {
+            for (std::size_t row = 0; row < nRows; ++row) {
+              insertRow(table, i, row);
+            }
+          });
+      }
+      for (auto & thread : threads) {
+        thread.join();
+      }
+      assert(pool->forcedFlushes() > 0);
+    }
+    File const file("test-ntuple_18.hdf5");
+    for (std::size_t i = 0; i < 4; ++i) {
+      check(file, i);
+    }
+  }
+  // Full buffers written asynchronously (holding back rows to
+  // complete a chunk) while further rows are inserted and charged.
+  {
+    auto const pool = NtupleMemoryPool::create(capacity * nTables);
+    {
+      File const file("test-ntuple_18.hdf5", H5F_ACC_TRUNC);
+      auto table = makeTable(file, 0, pool, NtupleFlushMode::ASYNC, 100);
+      for (std::size_t row = 0; row < nRows; ++row) {
+        insertRow(table, 0, row);
+      }
+      assert(pool->usage() > 0 && pool->forcedFlushes() == 0);
+    }
+    assert(pool->usage() == 0);
+    check(File("test-ntuple_18.hdf5"), 0);
+  }
+  // Not supported with per-thread staging.
+  bool threw = false;
+  try {
+    auto table = make_ntuple({"test-ntuple_18.hdf5", "t",
+          NtupleOptions{}.
+          setInsertMode(NtupleInsertMode::PER_THREAD).
+          setMemoryPool(NtupleMemoryPool::create(capacity))},
+      make_scalar_column<int>("A"));
+  }
+  catch (std::runtime_error const &) {
+    threw = true;
+  }
+  assert(threw);
+}
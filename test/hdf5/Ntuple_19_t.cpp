@@ -0,0 +1,104 @@
+// SWMR writing, tailed by a reader in another process.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/NtupleTail.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+  constexpr std::size_t nBatches = 5;
+  constexpr std::size_t batch = 300; // Not a multiple of the chunking.
+  char const * const filename = "test-ntuple_19.hdf5";
+
+  void writer(int const ready, int const ack)
+  {
+    auto data = make_ntuple({filename, "g1",
+          NtupleOptions{}.setBufsize(batch).setSWMR(true)},
+      make_scalar_column<int>("A"),
+      make_column<double>("B", 2));
+    for (std::size_t i = 0; i < nBatches; ++i) {
+      for (std::size_t row = i * batch; row < (i + 1) * batch; ++row) {
+        double const b[] { row * 1.0, row * -1.0 };
+        data.insert(static_cast<int>(row), b);
+      }
+      data.flush();
+      // No geometric growth: the extent is exactly the rows written.
+      Dataspace const space(H5Dget_space(data.datasets()[0]));
+      hsize_t dims[2] {0, 0};
+      H5Sget_simple_extent_dims(space, dims, nullptr);
+      assert(dims[0] == (i + 1) * batch);
+      char c = 'w';
+      assert(write(ready, &c, 1) == 1);
+      assert(read(ack, &c, 1) == 1);
+    }
+  }
+
+  void reader(int const ready, int const ack)
+  {
+    char c;
+    assert(read(ready, &c, 1) == 1);
+    NtupleTail tail(filename, "g1");
+    assert((tail.columns() == std::vector<std::string>{"A", "B"}));
+    for (std::size_t i = 0; i < nBatches; ++i) {
+      if (i != 0) {
+        assert(read(ready, &c, 1) == 1);
+      }
+      assert(tail.refresh() == batch);
+      assert(tail.position() == i * batch);
+      auto const a = tail.read<int>(0);
+      auto const b = tail.read<double>(1);
+      assert(a.size() == batch && b.size() == 2 * batch);
+      for (std::size_t j = 0; j < batch; ++j) {
+        int const expected = static_cast<int>(i * batch + j);
+        assert(a[j] == expected);
+        assert(b[2 * j] == expected && b[2 * j + 1] == -expected);
+      }
+      tail.advance();
+      assert(tail.refresh() == 0ull);
+      assert(write(ack, &c, 1) == 1);
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  int ready[2], ack[2];
+  assert(pipe(ready) == 0 && pipe(ack) == 0);
+  pid_t const pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    close(ready[0]);
+    close(ack[1]);
+    writer(ready[1], ack[0]);
+    _exit(EXIT_SUCCESS);
+  }
+  // So that we see end-of-file if the writer fails.
+  close(ready[1]);
+  close(ack[0]);
+  reader(ready[0], ack[1]);
+  int status = 0;
+  assert(waitpid(pid, &status, 0) == pid);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+  // Variable-length strings are not supported.
+  bool threw = false;
+  try {
+    auto data = make_ntuple({filename, "g1",
+          NtupleOptions{}.setSWMR(true)},
+      make_scalar_column<std::string>("S"));
+  }
+  catch (std::runtime_error const &) {
+    threw = true;
+  }
+  assert(threw);
+}
@@ -0,0 +1,126 @@
+// Per-chunk column statistics.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 1000;
+  constexpr std::size_t nAppend = 100;
+  constexpr std::size_t chunkRows = DEFAULT_CHUNKING;
+
+  struct Record {
+    double min;
+    double max;
+    double sum;
+    std::uint64_t count;
+    std::uint64_t nulls;
+  };
+
+  int a(std::size_t const row) { return static_cast<int>(row % 300) - 100; }
+  double b(std::size_t const row, std::size_t const j)
+  {
+    return (row % 50 == 7 && j == 1) ?
+      std::numeric_limits<double>::quiet_NaN() : row * (j + 1.0);
+  }
+
+  void fill(NtupleLayout const layout, NtupleOverwriteFlag const flag,
+            std::size_t const first, std::size_t const last)
+  {
+    auto data = make_ntuple({"test-ntuple_20.hdf5", "g1",
+          NtupleOptions{}.
+          setOverwriteContents(flag).
+          setBufsize(300).
+          setChunkBytes(0).
+          setLayout(layout).
+          setChunkStatistics(true)},
+      make_scalar_column<int>("A"),
+      make_column<double>("B", 2),
+      make_scalar_column<std::string>("S"));
+    for (std::size_t row = first; row < last; ++row) {
+      double const bs[] { b(row, 0), b(row, 1) };
+      std::string const s { std::to_string(row) };
+      data.insert(a(row), bs, &s);
+    }
+  }
+
+  // Read the statistics of a column as doubles.
+  std::vector<Record> records(File const & file, std::string const & name)
+  {
+    Dataset dset(file, "/g1/_chunk_stats/" + name);
+    Dataspace const space(H5Dget_space(dset));
+    hsize_t n = 0;
+    H5Sget_simple_extent_dims(space, &n, nullptr);
+    hid_t const rtype = H5Tcreate(H5T_COMPOUND, sizeof(Record));
+    H5Tinsert(rtype, "min", HOFFSET(Record, min), H5T_NATIVE_DOUBLE);
+    H5Tinsert(rtype, "max", HOFFSET(Record, max), H5T_NATIVE_DOUBLE);
+    H5Tinsert(rtype, "sum", HOFFSET(Record, sum), H5T_NATIVE_DOUBLE);
+    H5Tinsert(rtype, "count", HOFFSET(Record, count), H5T_NATIVE_UINT64);
+    H5Tinsert(rtype, "nulls", HOFFSET(Record, nulls), H5T_NATIVE_UINT64);
+    std::vector<Record> result(n);
+    dset.read(rtype, result.data());
+    H5Tclose(rtype);
+    return result;
+  }
+
+  void check(std::size_t const total)
+  {
+    File const file("test-ntuple_20.hdf5");
+    auto const as = records(file, "A");
+    auto const bs = records(file, "B");
+    std::size_t const nChunks = (total + chunkRows - 1) / chunkRows;
+    assert(as.size() == nChunks && bs.size() == nChunks);
+    for (std::size_t k = 0; k < nChunks; ++k) {
+      std::size_t const end = std::min(total, (k + 1) * chunkRows);
+      Record ea {1e300, -1e300, 0.0, 0, 0}, eb = ea;
+      for (std::size_t row = k * chunkRows; row < end; ++row) {
+        ea.min = std::min<double>(ea.min, a(row));
+        ea.max = std::max<double>(ea.max, a(row));
+        ea.sum += a(row);
+        ++ea.count;
+        for (std::size_t j = 0; j < 2; ++j) {
+          double const v = b(row, j);
+          if (std::isnan(v)) {
+            ++eb.nulls;
+            continue;
+          }
+          eb.min = std::min(eb.min, v);
+          eb.max = std::max(eb.max, v);
+          eb.sum += v;
+          ++eb.count;
+        }
+      }
+      assert(as[k].min == ea.min && as[k].max == ea.max);
+      assert(as[k].sum == ea.sum && as[k].count == ea.count);
+      assert(as[k].nulls == 0);
+      assert(bs[k].min == eb.min && bs[k].max == eb.max);
+      assert(bs[k].sum == eb.sum && bs[k].count == eb.count);
+      assert(bs[k].nulls == eb.nulls && eb.nulls != 0);
+    }
+    // No statistics for strings.
+    assert(H5Lexists(file, "/g1/_chunk_stats/S", H5P_DEFAULT) == 0);
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    fill(layout, NtupleOverwriteFlag::YES, 0, nRows);
+    check(nRows);
+    // Appending completes the last (partial) chunk's record.
+    fill(layout, NtupleOverwriteFlag::APPEND, nRows, nRows + nAppend);
+    check(nRows + nAppend);
+  }
+}
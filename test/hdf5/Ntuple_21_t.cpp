@@ -0,0 +1,130 @@
+// Key index and lookup.
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/Group.hpp"
+#include "hep_hpc/hdf5/NtupleIndex.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/detail/KeyIndex.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 5000;
+  constexpr std::size_t nAppend = 1000;
+
+  using Ranges = std::vector<std::pair<hsize_t, hsize_t> >;
+
+  // Sorted keys: 100 events per subrun, 10 subruns per run.
+  void fillSorted(NtupleLayout const layout, NtupleOverwriteFlag const flag,
+                  std::size_t const first, std::size_t const last)
+  {
+    auto data = make_ntuple({"test-ntuple_21.hdf5", "sorted",
+          NtupleOptions{}.
+          setOverwriteContents(flag).
+          setLayout(layout).
+          setKeyColumns({"run", "subrun", "event"})},
+      make_scalar_column<unsigned int>("run"),
+      make_scalar_column<int>("subrun"),
+      make_scalar_column<long long>("event"),
+      make_scalar_column<double>("energy"));
+    for (std::size_t row = first; row < last; ++row) {
+      data.insert(row / 1000, (row / 100) % 10, row % 100, row * 0.5);
+    }
+  }
+
+  // Interleaved runs: row has run row % 5 and event row / 5.
+  void fillUnsorted(NtupleLayout const layout)
+  {
+    auto data = make_ntuple({"test-ntuple_21.hdf5", "unsorted",
+          NtupleOptions{}.
+          setLayout(layout).
+          setKeyColumns({"run", "event"})},
+      make_scalar_column<int>("run"),
+      make_scalar_column<int>("event"),
+      make_scalar_column<std::string>("label"));
+    for (std::size_t row = 0; row < nRows; ++row) {
+      std::string const label {std::to_string(row)};
+      data.insert(row % 5, row / 5, &label);
+    }
+  }
+
+  void checkSorted(std::size_t const total)
+  {
+    NtupleIndex const index("test-ntuple_21.hdf5", "sorted");
+    assert(index.sparse());
+    assert(index.rows() == total);
+    assert((index.keyColumns() ==
+            std::vector<std::string> {"run", "subrun", "event"}));
+    assert((index.lookup({2, 3, 45}) == Ranges {{2345, 2346}}));
+    assert((index.lookup({2, 3}) == Ranges {{2300, 2400}}));
+    assert((index.lookup({2}) == Ranges {{2000, 3000}}));
+    assert((index.lookup({0, 0, 0}) == Ranges {{0, 1}}));
+    assert((index.lookup({}) == Ranges {{0, total}}));
+    assert(index.lookup({2, 3, 100}).empty());
+    assert(index.lookup({1000}).empty());
+    assert(index.lookup({-1}).empty());
+    hsize_t const lastRun = (total - 1) / 1000;
+    assert((index.lookup({static_cast<long long>(lastRun)}) ==
+            Ranges {{lastRun * 1000, total}}));
+  }
+
+  void checkUnsorted()
+  {
+    NtupleIndex const index("test-ntuple_21.hdf5", "unsorted");
+    assert(!index.sparse());
+    assert(index.rows() == nRows);
+    assert((index.lookup({3, 7}) == Ranges {{7 * 5 + 3, 7 * 5 + 4}}));
+    auto const run2 = index.lookup({2});
+    assert(run2.size() == nRows / 5);
+    for (std::size_t i = 0; i < run2.size(); ++i) {
+      assert(run2[i].first == i * 5 + 2 && run2[i].second == run2[i].first + 1);
+    }
+    assert((index.lookup({}) == Ranges {{0, nRows}}));
+    assert(index.lookup({5}).empty());
+    assert(index.lookup({4, static_cast<long long>(nRows)}).empty());
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    fillSorted(layout, NtupleOverwriteFlag::YES, 0, nRows);
+    checkSorted(nRows);
+    // Appending rebuilds the index over the whole table.
+    fillSorted(layout, NtupleOverwriteFlag::APPEND, nRows, nRows + nAppend);
+    checkSorted(nRows + nAppend);
+    fillUnsorted(layout);
+    checkUnsorted();
+    // A dense index merged from several sorted runs, read back in part
+    // (2048) or whole (300).
+    for (hsize_t const runRows : {300ull, 2048ull}) {
+      {
+        File const file("test-ntuple_21.hdf5", H5F_ACC_RDWR);
+        Group const group(file, "unsorted", Group::OPEN_MODE);
+        detail::writeKeyIndex(group, {"run", "event"}, nRows, runRows);
+      }
+      assert(!std::ifstream("test-ntuple_21.hdf5.key_index.tmp"));
+      checkUnsorted();
+    }
+  }
+  // Key columns must be scalar integer columns.
+  bool threw = false;
+  try {
+    auto data = make_ntuple({"test-ntuple_21.hdf5", "bad",
+          NtupleOptions{}.setKeyColumns({"energy"})},
+      make_scalar_column<double>("energy"));
+  }
+  catch (std::runtime_error const &) {
+    threw = true;
+  }
+  assert(threw);
+}
@@ -0,0 +1,116 @@
+// Dictionary-encoded string columns.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/detail/StringDictionary.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 10000;
+  constexpr std::size_t nAppend = 500;
+
+  std::string const detectors[] {"tracker", "ecal", "hcal", "muon", "lumi"};
+
+  std::string detector(std::size_t const row)
+  {
+    return (row >= nRows) ? "forward" : detectors[(row * 7 / 3) % 5];
+  }
+
+  std::string trigger(std::size_t const row, std::size_t const j)
+  {
+    return "HLT_path" + std::to_string((row + j) % 3);
+  }
+
+  void fill(NtupleLayout const layout, NtupleOverwriteFlag const flag,
+            std::size_t const first, std::size_t const last)
+  {
+    auto data = make_ntuple({"test-ntuple_22.hdf5", "g1",
+          NtupleOptions{}.
+          setOverwriteContents(flag).
+          setLayout(layout)},
+      make_scalar_column<int>("A"),
+      make_scalar_column<dict_string>("detector"),
+      make_column<dict_string>("triggers", 2),
+      make_scalar_column<std::string>("label"));
+    for (std::size_t row = first; row < last; ++row) {
+      dict_string const triggers[] {trigger(row, 0), trigger(row, 1)};
+      std::string const label {detector(row)};
+      data.insert(static_cast<int>(row), detector(row), triggers, &label);
+    }
+  }
+
+  // Decode the codes of a column.
+  std::vector<std::string> decode(File const & file, std::string const & name)
+  {
+    auto const dictionary =
+      detail::readDictionary(Group(file, "g1", Group::OPEN_MODE), name);
+    Dataset dset(file, "/g1/" + name);
+    Dataspace const space(H5Dget_space(dset));
+    std::vector<std::uint32_t> codes(H5Sget_simple_extent_npoints(space));
+    dset.read(H5T_NATIVE_UINT32, codes.data());
+    std::vector<std::string> result;
+    for (auto const code : codes) {
+      assert(code < dictionary.size());
+      result.push_back(dictionary[code]);
+    }
+    return result;
+  }
+
+  void check(std::size_t const total, std::size_t const nDetectors)
+  {
+    File const file("test-ntuple_22.hdf5");
+    Group const group(file, "g1", Group::OPEN_MODE);
+    assert(detail::readDictionary(group, "detector").size() == nDetectors);
+    assert(detail::readDictionary(group, "triggers").size() == 3);
+    auto const dets = decode(file, "detector");
+    auto const trigs = decode(file, "triggers");
+    assert(dets.size() == total && trigs.size() == total * 2);
+    for (std::size_t row = 0; row < total; ++row) {
+      assert(dets[row] == detector(row));
+      assert(trigs[row * 2] == trigger(row, 0));
+      assert(trigs[row * 2 + 1] == trigger(row, 1));
+    }
+    // The codes are much smaller on file than the references to the
+    // equivalent variable-length strings alone (excluding the strings
+    // themselves).
+    Dataset const codes(file, "/g1/detector"), strings(file, "/g1/label");
+    assert(H5Dget_storage_size(codes) * 5 < H5Dget_storage_size(strings));
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    fill(layout, NtupleOverwriteFlag::YES, 0, nRows);
+    check(nRows, 5);
+    // Appending extends the existing dictionary.
+    fill(layout, NtupleOverwriteFlag::APPEND, nRows, nRows + nAppend);
+    check(nRows + nAppend, 6);
+  }
+  {
+    // Column-wise insertion of more rows than the buffer holds.
+    std::vector<dict_string> values(3000);
+    for (std::size_t row = 0; row < values.size(); ++row) {
+      values[row] = detector(row);
+    }
+    {
+      auto data = make_ntuple({"test-ntuple_22.hdf5", "g2",
+            NtupleOptions{}.setOverwriteContents(NtupleOverwriteFlag::YES)},
+        make_scalar_column<dict_string>("detector"));
+      data.insert_columns(values.size(), values.data());
+    }
+    File const file("test-ntuple_22.hdf5");
+    auto const dictionary =
+      detail::readDictionary(Group(file, "g2", Group::OPEN_MODE), "detector");
+    assert(dictionary.size() == 5);
+  }
+}
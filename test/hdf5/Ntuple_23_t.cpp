@@ -0,0 +1,135 @@
+// Jagged columns.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/JaggedColumn.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 2000;
+  constexpr std::size_t nAppend = 300;
+
+  std::vector<float> hits(std::size_t const row)
+  {
+    std::vector<float> result(row % 7);
+    for (std::size_t k = 0; k < result.size(); ++k) {
+      result[k] = row * 10.0f + k;
+    }
+    return result;
+  }
+
+  std::vector<int> ids(std::size_t const row)
+  {
+    return std::vector<int>((row % 3 == 0) ? 0 : 2, static_cast<int>(row));
+  }
+
+  void fill(std::string const & table, NtupleOptions const & options,
+            std::size_t const first, std::size_t const last)
+  {
+    auto data = make_ntuple({"test-ntuple_23.hdf5", table, options},
+                            make_scalar_column<int>("event"),
+                            JaggedColumn<float>("hits", 256),
+                            JaggedColumn<int>("ids"));
+    for (std::size_t row = first; row < last; ++row) {
+      auto const i = ids(row);
+      data.insert(static_cast<int>(row), hits(row),
+                  jagged_span<int>(i.data(), i.size()));
+    }
+  }
+
+  template <typename T>
+  std::vector<T> readAll(File const & file, std::string const & name,
+                         hid_t const memType)
+  {
+    Dataset dset(file, name);
+    Dataspace const space(H5Dget_space(dset));
+    std::vector<T> result(H5Sget_simple_extent_npoints(space));
+    if (!result.empty()) {
+      dset.read(memType, result.data());
+    }
+    return result;
+  }
+
+  template <typename T>
+  void checkColumn(File const & file, std::string const & table,
+                   std::string const & name, hid_t const memType,
+                   std::size_t const total,
+                   std::vector<T> (*expected)(std::size_t))
+  {
+    auto const offsets =
+      readAll<std::uint64_t>(file, table + "/" + name, H5T_NATIVE_UINT64);
+    auto const values =
+      readAll<T>(file, table + "/_jagged/" + name, memType);
+    assert(offsets.size() == total);
+    std::uint64_t begin = 0ull;
+    for (std::size_t row = 0; row < total; ++row) {
+      auto const e = expected(row);
+      assert(offsets[row] - begin == e.size());
+      assert(std::vector<T>(values.begin() + begin,
+                            values.begin() + offsets[row]) == e);
+      begin = offsets[row];
+    }
+    assert(begin == values.size());
+  }
+
+  void check(std::string const & table, std::size_t const total)
+  {
+    File const file("test-ntuple_23.hdf5");
+    checkColumn<float>(file, table, "hits", H5T_NATIVE_FLOAT, total, &hits);
+    checkColumn<int>(file, table, "ids", H5T_NATIVE_INT, total, &ids);
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    auto const options = NtupleOptions{}.setBufsize(300).setLayout(layout);
+    fill("g1", NtupleOptions{options}.
+         setOverwriteContents(NtupleOverwriteFlag::YES), 0, nRows);
+    check("g1", nRows);
+    // Appending continues the values and offsets.
+    fill("g1", NtupleOptions{options}.
+         setOverwriteContents(NtupleOverwriteFlag::APPEND),
+         nRows, nRows + nAppend);
+    check("g1", nRows + nAppend);
+  }
+  // Asynchronous flushing.
+  fill("g2", NtupleOptions{}.setBufsize(100).
+       setFlushMode(NtupleFlushMode::ASYNC), 0, nRows);
+  check("g2", nRows);
+  {
+    // Column-wise insertion of more rows than the buffer holds, from
+    // non-contiguous rows.
+    std::vector<int> events(nRows);
+    std::vector<std::vector<float> > hitRows(nRows);
+    std::vector<std::vector<int> > idRows(nRows);
+    std::vector<jagged_span<float> > hitSpans(nRows);
+    std::vector<jagged_span<int> > idSpans(nRows);
+    for (std::size_t row = 0; row < nRows; ++row) {
+      events[row] = static_cast<int>(row);
+      hitRows[row] = hits(row);
+      idRows[row] = ids(row);
+      hitSpans[row] = hitRows[row];
+      idSpans[row] = idRows[row];
+    }
+    {
+      auto data = make_ntuple({"test-ntuple_23.hdf5", "g3",
+            NtupleOptions{}.setBufsize(100)},
+        make_scalar_column<int>("event"),
+        JaggedColumn<float>("hits", 256),
+        JaggedColumn<int>("ids"));
+      data.insert_columns(nRows, events.data(), hitSpans.data(),
+                          idSpans.data());
+    }
+    check("g3", nRows);
+  }
+}
@@ -0,0 +1,135 @@
+// Bit-packed columns of bool.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+#include "hep_hpc/hdf5/pack_bits.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 3000;
+  constexpr std::size_t nAppend = 250;
+  constexpr std::size_t nTriggers = 11;
+
+  bool passed(std::size_t const row) { return row % 3 != 1; }
+
+  bool trigger(std::size_t const row, std::size_t const j)
+  { return ((row * 7 + j * 3) % 5) < 2; }
+
+  void fill(std::string const & table, NtupleOptions const & options,
+            std::size_t const first, std::size_t const last)
+  {
+    auto data = make_ntuple({"test-ntuple_24.hdf5", table, options},
+                            make_scalar_column<int>("event"),
+                            make_scalar_column<bool>("passed"),
+                            make_column<bool>("triggers", nTriggers));
+    for (std::size_t row = first; row < last; ++row) {
+      bool triggers[nTriggers];
+      for (std::size_t j = 0; j < nTriggers; ++j) {
+        triggers[j] = trigger(row, j);
+      }
+      data.insert(static_cast<int>(row), passed(row), triggers);
+    }
+  }
+
+  // Read and unpack a column of rowFlags flags.
+  std::vector<bool> readFlags(File const & file, std::string const & name,
+                              std::size_t const rowFlags)
+  {
+    Dataset dset(file, name);
+    Datatype const type(H5Dget_type(dset));
+    assert(H5Tget_class(type) == H5T_BITFIELD);
+    Dataspace const space(H5Dget_space(dset));
+    hsize_t dims[2];
+    assert(H5Sget_simple_extent_dims(space, dims, nullptr) == 2);
+    assert(dims[1] == packed_row_bytes(rowFlags));
+    std::vector<unsigned char> packed(dims[0] * dims[1]);
+    if (!packed.empty()) {
+      dset.read(H5T_NATIVE_B8, packed.data());
+    }
+    std::unique_ptr<bool[]> flags(new bool[dims[0] * rowFlags]);
+    unpack_bits(packed.data(), dims[0], rowFlags, flags.get());
+    return std::vector<bool>(flags.get(), flags.get() + dims[0] * rowFlags);
+  }
+
+  void check(std::string const & table, std::size_t const total)
+  {
+    File const file("test-ntuple_24.hdf5");
+    auto const pass = readFlags(file, table + "/passed", 1);
+    auto const trigs = readFlags(file, table + "/triggers", nTriggers);
+    assert(pass.size() == total && trigs.size() == total * nTriggers);
+    for (std::size_t row = 0; row < total; ++row) {
+      assert(pass[row] == passed(row));
+      for (std::size_t j = 0; j < nTriggers; ++j) {
+        assert(trigs[row * nTriggers + j] == trigger(row, j));
+      }
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  {
+    // Layout: flag k of a row is bit k % 8 of byte k / 8.
+    bool const flags[] {true, false, false, true, false, false, false, false,
+        false, true, true, // Row 0.
+        false, false, false, false, false, false, false, true,
+        true, false, false}; // Row 1.
+    unsigned char packed[4];
+    pack_bits(flags, 2, nTriggers, packed);
+    assert(packed[0] == 0x09u && packed[1] == 0x06u);
+    assert(packed[2] == 0x80u && packed[3] == 0x01u);
+    bool unpacked[2 * nTriggers];
+    unpack_bits(packed, 2, nTriggers, unpacked);
+    assert(std::equal(flags, flags + 2 * nTriggers, unpacked));
+  }
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    auto const options = NtupleOptions{}.setBufsize(400).setLayout(layout);
+    fill("g1", NtupleOptions{options}.
+         setOverwriteContents(NtupleOverwriteFlag::YES), 0, nRows);
+    check("g1", nRows);
+    fill("g1", NtupleOptions{options}.
+         setOverwriteContents(NtupleOverwriteFlag::APPEND),
+         nRows, nRows + nAppend);
+    check("g1", nRows + nAppend);
+  }
+  // Asynchronous flushing.
+  fill("g2", NtupleOptions{}.setBufsize(100).
+       setFlushMode(NtupleFlushMode::ASYNC), 0, nRows);
+  check("g2", nRows);
+  {
+    // Column-wise insertion of more rows than the buffer holds.
+    std::vector<int> events(nRows);
+    std::unique_ptr<bool[]> pass(new bool[nRows]);
+    std::unique_ptr<bool[]> trigs(new bool[nRows * nTriggers]);
+    for (std::size_t row = 0; row < nRows; ++row) {
+      events[row] = static_cast<int>(row);
+      pass[row] = passed(row);
+      for (std::size_t j = 0; j < nTriggers; ++j) {
+        trigs[row * nTriggers + j] = trigger(row, j);
+      }
+    }
+    {
+      auto data = make_ntuple({"test-ntuple_24.hdf5", "g3",
+            NtupleOptions{}.setBufsize(100)},
+        make_scalar_column<int>("event"),
+        make_scalar_column<bool>("passed"),
+        make_column<bool>("triggers", nTriggers));
+      data.insert_columns(nRows, events.data(), pass.get(), trigs.get());
+    }
+    check("g3", nRows);
+    // Eleven flags per row occupy two bytes on file.
+    File const file("test-ntuple_24.hdf5");
+    Dataset const dset(file, "g3/triggers");
+    assert(H5Dget_storage_size(dset) <= nRows * 2);
+  }
+}
@@ -0,0 +1,161 @@
+// Reduced-precision floating-point columns.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 20000;
+  constexpr unsigned floatBits = 10u;
+  constexpr unsigned doubleBits = 20u;
+
+  // Noisy values, as from a digitizer.
+  std::vector<float> adcs()
+  {
+    std::mt19937 gen(42);
+    std::normal_distribution<float> noise(1000.0f, 25.0f);
+    std::vector<float> result(nRows);
+    for (auto & v : result) {
+      v = noise(gen);
+    }
+    return result;
+  }
+
+  std::vector<double> times()
+  {
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> noise(-50.0, 50.0);
+    std::vector<double> result(nRows);
+    for (auto & v : result) {
+      v = noise(gen);
+    }
+    return result;
+  }
+
+  template <typename T>
+  std::vector<T> readAll(File const & file, std::string const & name,
+                         hid_t const memType)
+  {
+    Dataset dset(file, name);
+    Dataspace const space(H5Dget_space(dset));
+    std::vector<T> result(H5Sget_simple_extent_npoints(space));
+    dset.read(memType, result.data());
+    return result;
+  }
+
+  template <typename T>
+  void checkBound(std::vector<T> const & stored, std::vector<T> const & orig,
+                  T const bound)
+  {
+    assert(stored.size() == orig.size());
+    bool rounded = false;
+    for (std::size_t i = 0; i < orig.size(); ++i) {
+      assert(std::abs(stored[i] - orig[i]) <= bound * std::abs(orig[i]));
+      rounded = rounded || (stored[i] != orig[i]);
+    }
+    assert(rounded);
+  }
+
+  std::size_t storageSize(File const & file, std::string const & name)
+  {
+    return H5Dget_storage_size(Dataset(file, name));
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  auto const adc = adcs();
+  auto const time = times();
+  {
+    // Rounding of special and boundary values.
+    auto col = make_scalar_column<float>("x", Precision{floatBits});
+    assert(col.mantissaBits() == floatBits);
+    assert(col.relativeErrorBound() == std::ldexp(1.0f, -11));
+    float values[] {1.0f + std::ldexp(1.0f, -11), // Tie: rounds up.
+                    std::numeric_limits<float>::max(),
+                    std::numeric_limits<float>::infinity(),
+                    -0.0f,
+                    // Subnormal: flushed to zero, or exact.
+                    std::numeric_limits<float>::denorm_min(),
+                    std::ldexp(1.0f, -130)};
+    col.roundMantissas(values, 6);
+    assert(values[0] == 1.0f + std::ldexp(1.0f, -10));
+    assert(std::isfinite(values[1]) &&
+           values[1] <= std::numeric_limits<float>::max());
+    assert(std::isinf(values[2]));
+    assert(values[3] == 0.0f && std::signbit(values[3]));
+    assert(values[4] == 0.0f && values[5] == std::ldexp(1.0f, -130));
+    bool threw = false;
+    try {
+      make_scalar_column<double>("y", Precision{53});
+    }
+    catch (Exception const &) {
+      threw = true;
+    }
+    assert(threw);
+  }
+  for (auto const layout :
+         { NtupleLayout::COLUMNAR, NtupleLayout::ROW_COMPOUND }) {
+    {
+      auto data = make_ntuple({"test-ntuple_25.hdf5", "g1",
+            NtupleOptions{}.
+            setOverwriteContents(NtupleOverwriteFlag::YES).
+            setLayout(layout)},
+        make_scalar_column<float>("adc", Precision{floatBits}),
+        make_column<double>("time", 2, 256, Precision{doubleBits}),
+        make_scalar_column<float>("adcFull"));
+      for (std::size_t row = 0; row < nRows; ++row) {
+        double const t[] {time[row], -time[row]};
+        data.insert(adc[row], t, adc[row]);
+      }
+    }
+    File const file("test-ntuple_25.hdf5");
+    if (layout == NtupleLayout::ROW_COMPOUND) {
+      // Read back the one member.
+      Datatype const member(H5Tcreate(H5T_COMPOUND, sizeof(float)));
+      H5Tinsert(member, "adc", 0, H5T_NATIVE_FLOAT);
+      checkBound(readAll<float>(file, "g1/rows", member), adc,
+                 std::ldexp(1.0f, -static_cast<int>(floatBits + 1)));
+    } else {
+      checkBound(readAll<float>(file, "g1/adc", H5T_NATIVE_FLOAT), adc,
+                 std::ldexp(1.0f, -static_cast<int>(floatBits + 1)));
+      auto const stored = readAll<double>(file, "g1/time", H5T_NATIVE_DOUBLE);
+      std::vector<double> orig;
+      for (auto const t : time) {
+        orig.push_back(t);
+        orig.push_back(-t);
+      }
+      checkBound(stored, orig,
+                 std::ldexp(1.0, -static_cast<int>(doubleBits + 1)));
+      assert(readAll<float>(file, "g1/adcFull", H5T_NATIVE_FLOAT) == adc);
+      // Reduced precision compresses much better.
+      assert(storageSize(file, "g1/adc") * 3 < storageSize(file, "g1/adcFull") * 2);
+    }
+  }
+  {
+    // Column-wise insertion of more rows than the buffer holds (written
+    // directly from the caller's arrays, which must be left as they
+    // were).
+    auto const copy = adc;
+    {
+      auto data = make_ntuple({"test-ntuple_25.hdf5", "g2",
+            NtupleOptions{}.setBufsize(100)},
+        make_scalar_column<float>("adc", Precision{floatBits}));
+      data.insert_columns(nRows, adc.data());
+    }
+    assert(adc == copy);
+    File const file("test-ntuple_25.hdf5");
+    checkBound(readAll<float>(file, "g2/adc", H5T_NATIVE_FLOAT), adc,
+               std::ldexp(1.0f, -static_cast<int>(floatBits + 1)));
+  }
+}
@@ -0,0 +1,107 @@
+// Compression codecs.
+#include "hep_hpc/hdf5/Codec.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 50000;
+
+  template <typename T>
+  std::vector<T> readAll(File const & file, std::string const & name,
+                         hid_t const memType)
+  {
+    Dataset dset(file, name);
+    Dataspace const space(H5Dget_space(dset));
+    std::vector<T> result(H5Sget_simple_extent_npoints(space));
+    dset.read(memType, result.data());
+    return result;
+  }
+
+  bool hasFilter(File const & file, std::string const & name,
+                 H5Z_filter_t const filter)
+  {
+    PropertyList const dcpl(H5Dget_create_plist(Dataset(file, name)),
+                            ResourceStrategy::handle_tag);
+    unsigned int flags;
+    std::size_t nValues = 0;
+    unsigned int config;
+    ScopedErrorHandler seh(ErrorMode::NONE);
+    return H5Pget_filter_by_id2(dcpl, filter, &flags, &nValues, nullptr,
+                                0, nullptr, &config) >= 0;
+  }
+
+  void testCodec(Codec const codec, unsigned int const compressionThreads)
+  {
+    std::string const group = std::string(codecName(codec)) + '-' +
+      std::to_string(compressionThreads);
+    {
+      auto data = make_ntuple({"test-ntuple_26.hdf5", group,
+            NtupleOptions{}.setCompressionThreads(compressionThreads)},
+        make_scalar_column<int>("i", {codecProperties(codec)}),
+        make_column<double>("d", 2, {codecProperties(codec, 1)}));
+      for (std::size_t row = 0; row < nRows; ++row) {
+        double const d[] {row * 0.5, row % 7 * 1.0};
+        data.insert(static_cast<int>(row / 100), d);
+      }
+    }
+    File const file("test-ntuple_26.hdf5");
+    assert(hasFilter(file, group + "/i", codecFilter(codec)));
+    auto const is = readAll<int>(file, group + "/i", H5T_NATIVE_INT);
+    auto const ds = readAll<double>(file, group + "/d", H5T_NATIVE_DOUBLE);
+    assert(is.size() == nRows && ds.size() == 2 * nRows);
+    for (std::size_t row = 0; row < nRows; ++row) {
+      assert(is[row] == static_cast<int>(row / 100));
+      assert(ds[2 * row] == row * 0.5);
+      assert(ds[2 * row + 1] == row % 7 * 1.0);
+    }
+    // Compressed.
+    assert(H5Dget_storage_size(Dataset(file, group + "/i")) <
+           nRows * sizeof(int));
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  for (auto const codec : { Codec::DEFLATE, Codec::ZSTD, Codec::LZ4 }) {
+    assert(codecFromName(codecName(codec)) == codec);
+  }
+  bool threw = false;
+  try {
+    (void) codecFromName("blosc");
+  }
+  catch (std::invalid_argument const &) {
+    threw = true;
+  }
+  assert(threw);
+  assert(codecAvailable(Codec::DEFLATE));
+  {
+    // Create the file.
+    File const file("test-ntuple_26.hdf5", H5F_ACC_TRUNC);
+  }
+  for (auto const codec : { Codec::DEFLATE, Codec::ZSTD, Codec::LZ4 }) {
+    if (!codecAvailable(codec)) {
+      threw = false;
+      try {
+        (void) codecProperties(codec);
+      }
+      catch (Exception const &) {
+        threw = true;
+      }
+      assert(threw);
+      continue;
+    }
+    for (auto const threads : { 0u, 2u }) {
+      testCodec(codec, threads);
+    }
+  }
+}
@@ -0,0 +1,119 @@
+// Byte-targeted default chunking.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/NtupleMemoryPool.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 1000;
+  constexpr std::size_t waveformSamples = 8192; // 64 KiB per row.
+  // In-memory size of a row.
+  constexpr std::size_t rowBytes = sizeof(std::int8_t) + sizeof(double) +
+    sizeof(double) * waveformSamples + sizeof(int) + sizeof(std::string);
+  // Memory allowed (by budget or pool), and the resulting limit on
+  // chunk rows: half of it.
+  constexpr std::size_t memoryBytes = 1 << 20;
+  constexpr hsize_t maxChunkRows = memoryBytes / (2 * rowBytes);
+
+  hsize_t chunkRows(File const & file, std::string const & name)
+  {
+    PropertyList const dcpl(H5Dget_create_plist(Dataset(file, name)),
+                            ResourceStrategy::handle_tag);
+    hsize_t chunking[H5S_MAX_RANK];
+    assert(H5Pget_chunk(dcpl, H5S_MAX_RANK, chunking) > 0);
+    return chunking[0];
+  }
+
+  void fill(File const & file, std::string const & group,
+            NtupleOptions options)
+  {
+    auto data = make_ntuple({file, group, options.setBufsize(100)},
+      make_scalar_column<std::int8_t>("flag"),
+      make_scalar_column<double>("energy"),
+      make_column<double>("waveform", waveformSamples),
+      make_scalar_column<int>("fixed", 10),
+      make_scalar_column<std::string>("name"));
+    std::vector<double> waveform(waveformSamples);
+    for (std::size_t row = 0; row < nRows; ++row) {
+      waveform[row % waveformSamples] = row;
+      std::string const name = std::to_string(row);
+      data.insert(static_cast<std::int8_t>(row % 3), row * 0.5,
+                  waveform.data(), static_cast<int>(row), &name);
+    }
+  }
+
+  void check(File const & file, std::string const & group)
+  {
+    std::vector<double> energy(nRows);
+    Dataset(file, group + "/energy").read(H5T_NATIVE_DOUBLE, energy.data());
+    std::vector<double> waveform(nRows * waveformSamples);
+    Dataset(file, group + "/waveform").read(H5T_NATIVE_DOUBLE,
+                                            waveform.data());
+    for (std::size_t row = 0; row < nRows; ++row) {
+      assert(energy[row] == row * 0.5);
+      assert(waveform[row * waveformSamples + row % waveformSamples] == row);
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  assert(detail::defaultChunkRows(1, DEFAULT_CHUNK_BYTES) ==
+         MAX_DEFAULT_CHUNKING);
+  assert(detail::defaultChunkRows(8, DEFAULT_CHUNK_BYTES) ==
+         DEFAULT_CHUNK_BYTES / 8);
+  assert(detail::defaultChunkRows(4 << 20, DEFAULT_CHUNK_BYTES) == 1);
+  assert(detail::defaultChunkRows(8, 0) == DEFAULT_CHUNKING);
+  assert(detail::defaultChunkRows(8, DEFAULT_CHUNK_BYTES, 100) == 100);
+  assert(detail::defaultChunkRows(8, 0, 100) == 100);
+  assert(detail::defaultChunkRows(8, 800, 1000) == 100);
+  File const file("test-ntuple_27.hdf5", H5F_ACC_TRUNC);
+  fill(file, "default", NtupleOptions{});
+  fill(file, "small", NtupleOptions{}.setChunkBytes(4096));
+  fill(file, "fixed", NtupleOptions{}.setChunkBytes(0));
+  fill(file, "rows", NtupleOptions{}.setLayout(NtupleLayout::ROW_COMPOUND));
+  fill(file, "budget", NtupleOptions{}.setBufferBytes(memoryBytes));
+  fill(file, "pool", NtupleOptions{}.
+       setMemoryPool(NtupleMemoryPool::create(memoryBytes)));
+  fill(file, "both", NtupleOptions{}.setBufferBytes(64 * memoryBytes).
+       setMemoryPool(NtupleMemoryPool::create(memoryBytes)));
+  // Sized by the bytes in a row.
+  assert(chunkRows(file, "default/flag") == MAX_DEFAULT_CHUNKING);
+  assert(chunkRows(file, "default/energy") == DEFAULT_CHUNK_BYTES / 8);
+  assert(chunkRows(file, "default/waveform") ==
+         DEFAULT_CHUNK_BYTES / (8 * waveformSamples));
+  assert(chunkRows(file, "default/name") > DEFAULT_CHUNKING);
+  assert(chunkRows(file, "small/flag") == 4096);
+  assert(chunkRows(file, "small/energy") == 512);
+  assert(chunkRows(file, "small/waveform") == 1);
+  assert(chunkRows(file, "fixed/flag") == DEFAULT_CHUNKING);
+  assert(chunkRows(file, "fixed/waveform") == DEFAULT_CHUNKING);
+  // Whole compound rows.
+  assert(chunkRows(file, "rows/rows") ==
+         DEFAULT_CHUNK_BYTES / (1 + 8 + 8 * waveformSamples + 4));
+  // Limited by the memory allowed for the Ntuple's buffers.
+  static_assert(maxChunkRows < DEFAULT_CHUNK_BYTES / (8 * waveformSamples),
+                "Every default-chunked column should be limited.");
+  for (auto const group : { "budget", "pool", "both" }) {
+    for (auto const column : { "/flag", "/energy", "/waveform" }) {
+      assert(chunkRows(file, group + std::string(column)) == maxChunkRows);
+    }
+  }
+  // Explicit chunking is kept.
+  for (auto const group : { "default", "small", "fixed", "budget", "pool" }) {
+    assert(chunkRows(file, std::string(group) + "/fixed") == 10);
+  }
+  for (auto const group :
+         { "default", "small", "fixed", "budget", "pool", "both" }) {
+    check(file, group);
+  }
+}
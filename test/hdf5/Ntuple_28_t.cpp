@@ -0,0 +1,166 @@
+// Byte and bit shuffle pre-filters.
+#include "hep_hpc/hdf5/Codec.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/detail/Bitshuffle.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 20003;
+
+  // Bit shuffle as specified, one bit at a time.
+  std::vector<unsigned char>
+  referenceBitshuffle(std::vector<unsigned char> const & in,
+                      std::size_t const size, std::size_t const blockSize)
+  {
+    std::vector<unsigned char> out(in.size(), 0);
+    std::size_t const nElements = in.size() / size;
+    std::size_t first = 0;
+    while (nElements - first >= 8) {
+      std::size_t n = std::min(blockSize, nElements - first);
+      n -= n % 8;
+      for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < size; ++j) {
+          for (std::size_t b = 0; b < 8; ++b) {
+            if ((in[(first + i) * size + j] >> b) & 1u) {
+              out[first * size + (8 * j + b) * n / 8 + i / 8] |= 1u << (i % 8);
+            }
+          }
+        }
+      }
+      first += n;
+    }
+    std::copy(in.begin() + first * size, in.end(), out.begin() + first * size);
+    return out;
+  }
+
+  void testBitshuffle(std::size_t const size, std::size_t const blockSize)
+  {
+    std::vector<unsigned char> in(1005 * size);
+    std::uint32_t x = 12345u;
+    for (auto & c : in) {
+      x = x * 1103515245u + 12345u;
+      c = static_cast<unsigned char>(x >> 16);
+    }
+    std::vector<unsigned char> out(in.size()), back(in.size());
+    detail::bitshuffle(in.data(), out.data(), 1005, size, blockSize);
+    assert(out == referenceBitshuffle(in, size, (blockSize == 0) ?
+                                      detail::defaultBitshuffleBlock(size) :
+                                      blockSize));
+    detail::bitunshuffle(out.data(), back.data(), 1005, size, blockSize);
+    assert(back == in);
+  }
+
+  bool hasFilter(File const & file, std::string const & name,
+                 H5Z_filter_t const filter)
+  {
+    PropertyList const dcpl(H5Dget_create_plist(Dataset(file, name)),
+                            ResourceStrategy::handle_tag);
+    unsigned int flags;
+    std::size_t nValues = 0;
+    unsigned int config;
+    ScopedErrorHandler seh(ErrorMode::NONE);
+    return H5Pget_filter_by_id2(dcpl, filter, &flags, &nValues, nullptr,
+                                0, nullptr, &config) >= 0;
+  }
+
+  std::int8_t c(std::size_t const row) { return row % 7 - 3; }
+  int i(std::size_t const row) { return 1000 + row % 50; }
+  double d(std::size_t const row) { return row * 0.25; }
+
+  void fill(File const & file, std::string const & group,
+            NtupleOptions options)
+  {
+    auto data = make_ntuple({file, group,
+          options.setBufsize(1000).setChunkBytes(4096)},
+      make_scalar_column<std::int8_t>("c"),
+      make_scalar_column<int>("i"),
+      make_column<double>("d", 2),
+      make_scalar_column<std::string>("s"),
+      make_scalar_column<int>("u",
+                              {codecProperties(Codec::DEFLATE,
+                                               DEFAULT_CODEC_LEVEL,
+                                               Shuffle::BIT)}));
+    for (std::size_t row = 0; row < nRows; ++row) {
+      double const ds[] {d(row), -d(row)};
+      std::string const s = std::to_string(row);
+      data.insert(c(row), i(row), ds, &s, i(row));
+    }
+  }
+
+  void check(File const & file, std::string const & group)
+  {
+    std::vector<std::int8_t> cs(nRows);
+    std::vector<int> is(nRows), us(nRows);
+    std::vector<double> ds(2 * nRows);
+    Dataset(file, group + "/c").read(H5T_NATIVE_INT8, cs.data());
+    Dataset(file, group + "/i").read(H5T_NATIVE_INT, is.data());
+    Dataset(file, group + "/d").read(H5T_NATIVE_DOUBLE, ds.data());
+    Dataset(file, group + "/u").read(H5T_NATIVE_INT, us.data());
+    for (std::size_t row = 0; row < nRows; ++row) {
+      assert(cs[row] == c(row));
+      assert(is[row] == i(row) && us[row] == i(row));
+      assert(ds[2 * row] == d(row) && ds[2 * row + 1] == -d(row));
+    }
+  }
+
+  std::size_t storageSize(File const & file, std::string const & name)
+  {
+    return H5Dget_storage_size(Dataset(file, name));
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  for (auto const size : { 1, 2, 3, 4, 8 }) {
+    testBitshuffle(size, 0);
+    testBitshuffle(size, 16);
+  }
+  File const file("test-ntuple_28.hdf5", H5F_ACC_TRUNC);
+  for (auto const threads : { 0u, 2u }) {
+    std::string const suffix = std::to_string(threads);
+    fill(file, "byte" + suffix,
+         NtupleOptions{}.setCompressionThreads(threads));
+    fill(file, "bit" + suffix,
+         NtupleOptions{}.setCompressionThreads(threads).
+         setShuffle(Shuffle::BIT));
+    fill(file, "none" + suffix,
+         NtupleOptions{}.setCompressionThreads(threads).
+         setShuffle(Shuffle::NONE));
+    for (auto const group : { "byte", "bit", "none" }) {
+      check(file, group + suffix);
+    }
+  }
+  // Byte shuffle by default for multi-byte arithmetic types only.
+  assert(!hasFilter(file, "byte0/c", H5Z_FILTER_SHUFFLE));
+  assert(hasFilter(file, "byte0/i", H5Z_FILTER_SHUFFLE));
+  assert(hasFilter(file, "byte0/d", H5Z_FILTER_SHUFFLE));
+  assert(!hasFilter(file, "byte0/s", H5Z_FILTER_SHUFFLE));
+  // Bit shuffle for all arithmetic types.
+  assert(hasFilter(file, "bit0/c", H5Z_FILTER_BITSHUFFLE));
+  assert(hasFilter(file, "bit0/i", H5Z_FILTER_BITSHUFFLE));
+  assert(!hasFilter(file, "bit0/i", H5Z_FILTER_SHUFFLE));
+  assert(!hasFilter(file, "bit0/s", H5Z_FILTER_BITSHUFFLE));
+  assert(!hasFilter(file, "none0/i", H5Z_FILTER_SHUFFLE));
+  // Column properties are left as specified.
+  assert(hasFilter(file, "none0/u", H5Z_FILTER_BITSHUFFLE));
+  // Identical output with and without direct chunk writes.
+  for (auto const name : { "/c", "/i", "/d" }) {
+    for (auto const group : { "byte", "bit", "none" }) {
+      assert(storageSize(file, group + std::string("0") + name) ==
+             storageSize(file, group + std::string("2") + name));
+    }
+  }
+  // Shuffling helps with slowly-varying values.
+  assert(storageSize(file, "byte0/d") < storageSize(file, "none0/d"));
+  assert(storageSize(file, "bit0/d") < storageSize(file, "byte0/d"));
+}
@@ -0,0 +1,123 @@
+// Chunk caches sized per dataset.
+#include "hep_hpc/hdf5/ChunkCache.hpp"
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/NtupleTail.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <vector>
+
+namespace {
+  constexpr std::size_t MiB = 1ull << 20;
+  constexpr std::size_t nRows = 100003;
+  char const * const filename = "test-ntuple_29.hdf5";
+
+  struct CacheConfig {
+    std::size_t nSlots;
+    std::size_t nBytes;
+    double w0;
+  };
+
+  CacheConfig cacheConfig(hid_t const daprops)
+  {
+    CacheConfig result;
+    assert(H5Pget_chunk_cache(daprops, &result.nSlots, &result.nBytes,
+                              &result.w0) >= 0);
+    return result;
+  }
+
+  CacheConfig datasetCacheConfig(hid_t const dset)
+  {
+    PropertyList const daprops(H5Dget_access_plist(dset),
+                               ResourceStrategy::handle_tag);
+    return cacheConfig(daprops);
+  }
+
+  void fill(NtupleOverwriteFlag const overwrite, std::size_t const first)
+  {
+    PropertyList userCache(H5P_DATASET_ACCESS);
+    H5Pset_chunk_cache(userCache, 17, 3 * MiB, 0.5);
+    auto data = make_ntuple({filename, "g",
+          NtupleOptions{}.setOverwriteContents(overwrite)},
+      make_scalar_column<int>("i"),
+      make_column<double>("d", 2),
+      make_scalar_column<float>("f", {std::move(userCache)}));
+    // One chunk of each column without access properties of its own.
+    assert(chunkCacheReserved() == 2 * MiB);
+    auto const i = datasetCacheConfig(data.datasets()[0]);
+    assert(i.nBytes == MiB && i.w0 == 1.0 && i.nSlots == 101);
+    assert(datasetCacheConfig(data.datasets()[1]).nBytes == MiB);
+    // Including when appending.
+    auto const f = datasetCacheConfig(data.datasets()[2]);
+    assert(f.nBytes == 3 * MiB && f.nSlots == 17);
+    for (std::size_t row = first; row < first + nRows; ++row) {
+      double const d[] {row * 0.5, -1.0 * row};
+      data.insert(static_cast<int>(row), d, row * 0.25f);
+    }
+  }
+
+  void check(std::size_t const totalRows)
+  {
+    NtupleTail tail(filename, "g", {"i", "d", "f"});
+    assert(chunkCacheReserved() == 3 * MiB);
+    assert(datasetCacheConfig(tail.dataset(0)).nBytes == MiB);
+    assert(tail.refresh() == totalRows);
+    auto const is = tail.read<int>(0);
+    auto const ds = tail.read<double>(1);
+    auto const fs = tail.read<float>(2);
+    for (std::size_t row = 0; row < totalRows; ++row) {
+      assert(is[row] == static_cast<int>(row));
+      assert(ds[2 * row] == row * 0.5 && ds[2 * row + 1] == -1.0 * row);
+      assert(fs[row] == row * 0.25f);
+    }
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  assert(chunkCacheBudget() == DEFAULT_CHUNK_CACHE_BUDGET);
+  {
+    // Sizing and the budget.
+    setChunkCacheBudget(10 * MiB);
+    ChunkCacheReservation append, random, none;
+    auto const a = cacheConfig(chunkCacheProperties(MiB, ChunkAccess::APPEND,
+                                                    append));
+    assert(a.nBytes == MiB && append.bytes() == MiB && a.w0 == 1.0);
+    auto const r = cacheConfig(chunkCacheProperties(MiB, ChunkAccess::RANDOM,
+                                                    random));
+    // Only 9 of RANDOM_ACCESS_CHUNKS chunks fit.
+    assert(r.nBytes == 9 * MiB && random.bytes() == 9 * MiB);
+    assert(r.nSlots == 907 && r.w0 < 1.0);
+    assert(chunkCacheReserved() == 10 * MiB);
+    // Exhausted: HDF5 defaults.
+    assert(chunkCacheProperties(MiB, ChunkAccess::SEQUENTIAL, none).
+           is_default());
+    assert(none.bytes() == 0ull);
+    ChunkCacheReservation moved(std::move(random));
+    assert(random.bytes() == 0ull && moved.bytes() == 9 * MiB);
+    moved.reset();
+    assert(chunkCacheReserved() == MiB);
+    // Not chunked.
+    assert(chunkCacheProperties(0ull, ChunkAccess::APPEND, append).
+           is_default());
+    assert(chunkCacheReserved() == 0ull);
+    setChunkCacheBudget(DEFAULT_CHUNK_CACHE_BUDGET);
+  }
+  fill(NtupleOverwriteFlag::YES, 0ull);
+  assert(chunkCacheReserved() == 0ull);
+  fill(NtupleOverwriteFlag::APPEND, nRows);
+  assert(chunkCacheReserved() == 0ull);
+  check(2 * nRows);
+  assert(chunkCacheReserved() == 0ull);
+  {
+    // Disabled: HDF5 defaults.
+    setChunkCacheBudget(0ull);
+    NtupleTail tail(filename, "g");
+    assert(chunkCacheReserved() == 0ull);
+    assert(datasetCacheConfig(tail.dataset(0)).nSlots == 521);
+  }
+}
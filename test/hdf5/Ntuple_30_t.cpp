@@ -0,0 +1,115 @@
+// File-level performance profiles.
+#include "hep_hpc/hdf5/Dataset.hpp"
+#include "hep_hpc/hdf5/File.hpp"
+#include "hep_hpc/hdf5/FileTuning.hpp"
+#include "hep_hpc/hdf5/errorHandling.hpp"
+#include "hep_hpc/hdf5/make_ntuple.hpp"
+
+using namespace hep_hpc::hdf5;
+
+#include <cassert>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr std::size_t nRows = 20000;
+
+  // paged: whether the file has (or will have) paged file space.
+  void fill(std::string const & filename, NtupleOptions const & options,
+            std::size_t const first, bool const paged)
+  {
+    auto data = make_ntuple({filename, "g", options},
+      make_scalar_column<int>("i"),
+      make_column<double>("d", 2));
+    for (std::size_t row = first; row < first + nRows; ++row) {
+      double const d[] {row * 0.5, -1.0 * row};
+      data.insert(static_cast<int>(row), d);
+    }
+    PropertyList const fapl(H5Fget_access_plist(data.file()),
+                            ResourceStrategy::handle_tag);
+    auto const & tuning = options.fileTuning();
+    hsize_t threshold, alignment;
+    assert(H5Pget_alignment(fapl, &threshold, &alignment) >= 0);
+    assert(threshold == tuning.alignmentThreshold() &&
+           alignment == tuning.alignment());
+    hsize_t metaBlockSize, smallDataBlockSize;
+    assert(H5Pget_meta_block_size(fapl, &metaBlockSize) >= 0);
+    assert(H5Pget_small_data_block_size(fapl, &smallDataBlockSize) >= 0);
+    assert(tuning.metaBlockSize() == 0ull ||
+           metaBlockSize == tuning.metaBlockSize());
+    assert(tuning.smallDataBlockSize() == 0ull ||
+           smallDataBlockSize == tuning.smallDataBlockSize());
+    // The page buffer is used only with paged file space.
+    std::size_t pageBufferSize;
+    unsigned minMetaPercent, minRawPercent;
+    assert(H5Pget_page_buffer_size(fapl, &pageBufferSize, &minMetaPercent,
+                                   &minRawPercent) >= 0);
+    assert(pageBufferSize == (paged ? tuning.pageBufferSize() : 0ull));
+    H5AC_cache_config_t config;
+    config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+    assert(H5Pget_mdc_config(fapl, &config) >= 0);
+    assert(tuning.metadataCacheSize() == 0ull ||
+           (config.set_initial_size &&
+            config.initial_size == tuning.metadataCacheSize()));
+  }
+
+  void check(std::string const & filename, std::size_t const totalRows)
+  {
+    File const file(filename);
+    std::vector<int> is(totalRows);
+    std::vector<double> ds(2 * totalRows);
+    Dataset(file, "g/i").read(H5T_NATIVE_INT, is.data());
+    Dataset(file, "g/d").read(H5T_NATIVE_DOUBLE, ds.data());
+    for (std::size_t row = 0; row < totalRows; ++row) {
+      assert(is[row] == static_cast<int>(row));
+      assert(ds[2 * row] == row * 0.5 && ds[2 * row + 1] == -1.0 * row);
+    }
+  }
+
+  hsize_t pageSize(std::string const & filename)
+  {
+    File const file(filename);
+    PropertyList const fcpl(H5Fget_create_plist(file),
+                            ResourceStrategy::handle_tag);
+    H5F_fspace_strategy_t strategy;
+    hbool_t persist;
+    hsize_t threshold, result;
+    assert(H5Pget_file_space_strategy(fcpl, &strategy, &persist,
+                                      &threshold) >= 0);
+    assert(H5Pget_file_space_page_size(fcpl, &result) >= 0);
+    return (strategy == H5F_FSPACE_STRATEGY_PAGE) ? result : 0ull;
+  }
+}
+
+int main()
+{
+  ErrorController::setErrorHandler(ErrorMode::EXCEPTION);
+  // Defaults.
+  FileTuning const none;
+  assert(none.alignment() == 1ull && none.pageSize() == 0ull &&
+         none.pageBufferSize() == 0ull && none.metadataCacheSize() == 0ull);
+  assert(FileTuning::parallelFS(4 << 20).pageSize() == (4 << 20));
+  struct Profile {
+    std::string name;
+    FileTuning tuning;
+  };
+  for (auto const & profile :
+       { Profile{"default", none},
+           Profile{"ssd", FileTuning::localSSD()},
+           Profile{"lustre", FileTuning::parallelFS()},
+           Profile{"tmpfs", FileTuning::tmpfs()} }) {
+    std::string const filename = "test-ntuple_30-" + profile.name + ".hdf5";
+    NtupleOptions options;
+    options.setFileTuning(profile.tuning);
+    bool const paged = (profile.tuning.pageSize() != 0ull);
+    fill(filename, options, 0ull, paged);
+    assert(NtupleDetail::hasPagedFileSpace(filename) == paged);
+    assert(pageSize(filename) == profile.tuning.pageSize());
+    // Appending, with the page buffer only if the file is paged.
+    fill(filename,
+         options.setOverwriteContents(NtupleOverwriteFlag::APPEND).
+         setFileTuning(FileTuning::localSSD()),
+         nRows, paged);
+    check(filename, 2 * nRows);
+  }
+}